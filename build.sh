@@ -6,9 +6,10 @@ program=
 do_debug=false
 
 project_name=cake
-common_flags="-g"
-# -Ibuild needs to be included so that gcc can find the .gch file
-compiler_flags="$common_flags -Werror -Wall -Wextra -Ibuild"
+common_flags="-g -pthread"
+# -Ibuild needs to be included so that gcc can find the .gch file,
+# the loops of approx.c only vectorize without trapping math
+compiler_flags="$common_flags -O3 -fno-trapping-math -Werror -Wall -Wextra -Ibuild"
 linker_flags="$common_flags"
 linker_libs="-lm -lSDL2 -lSDL2_ttf"
 
@@ -0,0 +1,394 @@
+#include "cake.h"
+
+/* every input goes through the same arithmetic and special cases are
+ * picked by selects, so that loops over these functions vectorize;
+ * the trigonometric functions reduce |x| < APPROX_TRIG_MAX themselves
+ * and leave larger arguments to libm after the loop
+ */
+
+/* adding and subtracting this rounds |x| < 2^51 to the nearest integer,
+ * which is then found in the low bits of the sum
+ */
+#define ROUNDER 0x1.8p52
+#define ROUNDERF 0x1.8p23f
+
+/* k * PIO2_HI is exact up to here, beyond it the reduction loses the
+ * low bits of x mod pi / 2
+ */
+#define APPROX_TRIG_MAX 1e6
+
+#define PIO2_HI 1.57079632673412561417e+00
+#define PIO2_MID 6.07710050630396597660e-11
+#define PIO2_LO 2.02226624879595063154e-21
+
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define LN2_HIF 0.693145751953125f
+#define LN2_LOF 1.428606765330187045e-06f
+
+static inline uint64_t approx_bits(double x)
+{
+	union { double d; uint64_t u; } v = { .d = x };
+	return v.u;
+}
+
+static inline double approx_double(uint64_t u)
+{
+	union { uint64_t u; double d; } v = { .u = u };
+	return v.d;
+}
+
+static inline uint32_t approx_bitsf(float x)
+{
+	union { float f; uint32_t u; } v = { .f = x };
+	return v.u;
+}
+
+static inline float approx_float(uint32_t u)
+{
+	union { uint32_t u; float f; } v = { .u = u };
+	return v.f;
+}
+
+/* sin(x + shift * pi / 2) by the quadrant of x and the Taylor series on
+ * [-pi / 4, pi / 4]; the reduction is done in double for both precisions
+ */
+static inline uint64_t approx_quadrant(double x, uint64_t shift, double *r)
+{
+	const double y = x * (2 / M_PI) + ROUNDER;
+	const double k = y - ROUNDER;
+
+	*r = x - k * PIO2_HI - k * PIO2_MID - k * PIO2_LO;
+	return approx_bits(y) + shift;
+}
+
+static inline double approx_sine(double x, uint64_t shift)
+{
+	double r, r2, s, c;
+	uint64_t q, odd, v;
+
+	q = approx_quadrant(x, shift, &r);
+	r2 = r * r;
+	s = r + r * r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040 +
+		r2 * (1.0 / 362880 + r2 * (-1.0 / 39916800 +
+		r2 * (1.0 / 6227020800 + r2 * (-1.0 / 1307674368000)))))));
+	c = 1 + r2 * (-1.0 / 2 + r2 * (1.0 / 24 + r2 * (-1.0 / 720 +
+		r2 * (1.0 / 40320 + r2 * (-1.0 / 3628800 +
+		r2 * (1.0 / 479001600 + r2 * (-1.0 / 87178291200 +
+		r2 * (1.0 / 20922789888000))))))));
+	/* selected by masks, baseline SSE has no 64 bit compares */
+	odd = -(q & 1);
+	v = (approx_bits(s) & ~odd) | (approx_bits(c) & odd);
+	return approx_double(v ^ (q & 2) << 62);
+}
+
+static inline float approx_sinef(float x, uint64_t shift)
+{
+	double rd;
+	float r, r2, s, c;
+	uint64_t q;
+	uint32_t odd, v;
+
+	q = approx_quadrant(x, shift, &rd);
+	r = rd;
+	r2 = r * r;
+	s = r + r * r2 * (-1.0f / 6 + r2 * (1.0f / 120 + r2 * (-1.0f / 5040 +
+		r2 * (1.0f / 362880))));
+	c = 1 + r2 * (-1.0f / 2 + r2 * (1.0f / 24 + r2 * (-1.0f / 720 +
+		r2 * (1.0f / 40320 + r2 * (-1.0f / 3628800)))));
+	odd = -(uint32_t) (q & 1);
+	v = (approx_bitsf(s) & ~odd) | (approx_bitsf(c) & odd);
+	return approx_float(v ^ (uint32_t) (q & 2) << 30);
+}
+
+static inline double approx_sin(double x)
+{
+	return approx_sine(x, 0);
+}
+
+static inline float approx_sinf(float x)
+{
+	return approx_sinef(x, 0);
+}
+
+static inline double approx_cos(double x)
+{
+	return approx_sine(x, 1);
+}
+
+static inline float approx_cosf(float x)
+{
+	return approx_sinef(x, 1);
+}
+
+/* 2^k * e^r with |r| <= ln(2) / 2, the power of two is applied in two
+ * halves so that results near overflow and subnormal ones are right
+ */
+static inline double approx_exp(double x)
+{
+	double y, k, r, p;
+	int64_t ki, k1;
+
+	x = x > 710 ? 710 : x < -746 ? -746 : x;
+	y = x * M_LOG2E + ROUNDER;
+	k = y - ROUNDER;
+	ki = approx_bits(y) - approx_bits(ROUNDER);
+	r = x - k * LN2_HI - k * LN2_LO;
+	p = 1 + r * (1 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 +
+		r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040 +
+		r * (1.0 / 40320 + r * (1.0 / 362880 +
+		r * (1.0 / 3628800 + r * (1.0 / 39916800 +
+		r * (1.0 / 479001600 + r * (1.0 / 6227020800)))))))))))));
+	k1 = ki >> 1;
+	return p * approx_double((uint64_t) (k1 + 1023) << 52) *
+		approx_double((uint64_t) (ki - k1 + 1023) << 52);
+}
+
+static inline float approx_expf(float x)
+{
+	float y, k, r, p;
+	int32_t ki, k1;
+
+	x = x > 89 ? 89 : x < -104 ? -104 : x;
+	y = x * (float) M_LOG2E + ROUNDERF;
+	k = y - ROUNDERF;
+	ki = approx_bitsf(y) - approx_bitsf(ROUNDERF);
+	r = x - k * LN2_HIF - k * LN2_LOF;
+	p = 1 + r * (1 + r * (1.0f / 2 + r * (1.0f / 6 + r * (1.0f / 24 +
+		r * (1.0f / 120 + r * (1.0f / 720 + r * (1.0f / 5040)))))));
+	k1 = ki >> 1;
+	return p * approx_float((uint32_t) (k1 + 127) << 23) *
+		approx_float((uint32_t) (ki - k1 + 127) << 23);
+}
+
+/* k * ln(2) + 2 * atanh((m - 1) / (m + 1)) with m in [sqrt(1/2), sqrt(2)) */
+static inline double approx_log(double x)
+{
+	const bool tiny = x < 0x1p-1022;
+	uint64_t ix;
+	double k, m, s, s2, v;
+
+	ix = approx_bits(tiny ? x * 0x1p54 : x);
+	ix += 0x3ff0000000000000 - 0x3fe6a09e667f3bcd;
+	/* the exponent converted by the bits of 2^52 + e, baseline SSE can
+	 * not convert 64 bit integers
+	 */
+	k = approx_double(0x4330000000000000 | ix >> 52) - 0x1p52 - 0x3ff -
+		(tiny ? 54 : 0);
+	ix = (ix & 0x000fffffffffffff) + 0x3fe6a09e667f3bcd;
+	m = approx_double(ix);
+	s = (m - 1) / (m + 1);
+	s2 = s * s;
+	v = 2 * s * (1 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 +
+		s2 * (1.0 / 9 + s2 * (1.0 / 11 + s2 * (1.0 / 13 +
+		s2 * (1.0 / 15 + s2 * (1.0 / 17 + s2 * (1.0 / 19 +
+		s2 * (1.0 / 21)))))))))));
+	v = k * LN2_HI + (v + k * LN2_LO);
+	v = x == 0 ? -INFINITY : v;
+	v = x == INFINITY ? INFINITY : v;
+	return x < 0 || x != x ? NAN : v;
+}
+
+static inline float approx_logf(float x)
+{
+	const bool tiny = x < 0x1p-126f;
+	uint32_t ix;
+	int32_t k;
+	float m, s, s2, v;
+
+	ix = approx_bitsf(tiny ? x * 0x1p25f : x);
+	ix += 0x3f800000 - 0x3f3504f3;
+	k = (int32_t) (ix >> 23) - 0x7f - (tiny ? 25 : 0);
+	ix = (ix & 0x007fffff) + 0x3f3504f3;
+	m = approx_float(ix);
+	s = (m - 1) / (m + 1);
+	s2 = s * s;
+	v = 2 * s * (1 + s2 * (1.0f / 3 + s2 * (1.0f / 5 + s2 * (1.0f / 7 +
+		s2 * (1.0f / 9 + s2 * (1.0f / 11))))));
+	v = k * LN2_HIF + (v + k * LN2_LOF);
+	v = x == 0 ? -INFINITY : v;
+	v = x == INFINITY ? INFINITY : v;
+	return x < 0 || x != x ? NAN : v;
+}
+
+/* the reciprocal root guessed from the exponent and refined by Newton,
+ * so that no errno checking sqrt() call stays in the loop
+ */
+static inline double approx_sqrt(double x)
+{
+	const bool tiny = x < 0x1p-1022;
+	const double sx = tiny ? x * 0x1p108 : x;
+	double y, v;
+
+	y = approx_double(0x5fe6eb50c7b537a9 - (approx_bits(sx) >> 1));
+	for (int i = 0; i < 4; i++)
+		y *= 1.5 - 0.5 * sx * y * y;
+	v = sx * y;
+	v += 0.5 * (sx - v * v) * y;
+	v = tiny ? v * 0x1p-54 : v;
+	v = x == 0 || x == INFINITY ? x : v;
+	return x < 0 ? NAN : v;
+}
+
+static inline float approx_sqrtf(float x)
+{
+	const bool tiny = x < 0x1p-126f;
+	const float sx = tiny ? x * 0x1p24f : x;
+	float y, v;
+
+	y = approx_float(0x5f375a86 - (approx_bitsf(sx) >> 1));
+	for (int i = 0; i < 3; i++)
+		y *= 1.5f - 0.5f * sx * y * y;
+	v = sx * y;
+	v = tiny ? v * 0x1p-12f : v;
+	v = x == 0 || x == INFINITY ? x : v;
+	return x < 0 ? NAN : v;
+}
+
+/* 1 - erf(z) by its positive series below 1.5 and the continued fraction
+ * e^(-z^2) / sqrt(pi) / (z + 1/2 / (z + 1 / (z + 3/2 / ...))) above,
+ * both with a fixed number of terms
+ */
+static inline double approx_erfc(double x)
+{
+	const double z = fabs(x);
+	const double z2 = z * z;
+	/* z^2 is split into hi^2, which is exact, and the rest, otherwise
+	 * its rounding grows into the exponential of large arguments
+	 */
+	const double hi = approx_double(approx_bits(z) & 0xfffffffff8000000);
+	const double e = approx_exp(-hi * hi) * approx_exp((hi - z) * (hi + z));
+	double term, sum, f, v;
+
+	term = z;
+	sum = z;
+	/* unrolled, an outer loop with two inner loops does not vectorize */
+#pragma GCC unroll 40
+	for (int n = 1; n < 40; n++) {
+		term *= 2 * z2 / (2 * n + 1);
+		sum += term;
+	}
+	f = z;
+#pragma GCC unroll 100
+	for (int n = 100; n > 0; n--)
+		f = z + n * 0.5 / f;
+	v = z < 1.5 ? 1 - 2 / sqrt(M_PI) * e * sum : e / (sqrt(M_PI) * f);
+	return x < 0 ? 2 - v : v;
+}
+
+/* Chebyshev fit with a relative error below 1.2e-7, computed in double
+ * since float already loses more in the exponent of large arguments
+ */
+static inline float approx_erfcf(float x)
+{
+	const double z = fabsf(x);
+	const double t = 1 / (1 + 0.5 * z);
+	double v;
+
+	v = t * approx_exp(-z * z - 1.26551223 + t * (1.00002368 +
+		t * (0.37409196 + t * (0.09678418 + t * (-0.18628806 +
+		t * (0.27886807 + t * (-1.13520398 + t * (1.48851587 +
+		t * (-0.82215223 + t * 0.17087277)))))))));
+	return x < 0 ? 2 - v : v;
+}
+
+/* Lanczos approximation with g = 7, reflected below 1/2 */
+static inline double approx_gamma(double x)
+{
+	static const double lanczos[] = {
+		676.5203681218851, -1259.1392167224028,
+		771.32342877765313, -176.61502916214059,
+		12.507343278686905, -0.13857109526572012,
+		9.9843695780195716e-6, 1.5056327351493116e-7,
+	};
+	const bool reflect = x < 0.5;
+	const double z = (reflect ? 1 - x : x) - 1;
+	const double t = z + 7.5;
+	/* sin(pi * x) from the exact distance to the nearest integer keeps
+	 * its relative accuracy next to the poles
+	 */
+	const double y = x + ROUNDER;
+	const double r = x - (y - ROUNDER);
+	const double sinpi = approx_double(approx_bits(approx_sin(M_PI * r)) ^
+			approx_bits(y) << 63);
+	double a, w, g;
+
+	a = 0.99999999999980993;
+#pragma GCC unroll 8
+	for (int i = 0; i < 8; i++)
+		a += lanczos[i] / (z + i + 1);
+	/* in two halves since t^(z + 1/2) alone overflows before gamma */
+	w = approx_exp(((z + 0.5) * approx_log(t) - t) / 2);
+	g = sqrt(2 * M_PI) * a * w * w;
+	g = reflect ? M_PI / (sinpi * g) : g;
+	/* the poles like in libm: the sign of zero and NaN at the negative
+	 * integers, which all numbers below -2^52 are
+	 */
+	g = x == 0 ? 1 / x : g;
+	return x < 0 && (r == 0 || x < -0x1p52) ? NAN : g;
+}
+
+/* the Lanczos sum cancels too much in float */
+static inline float approx_gammaf(float x)
+{
+	return approx_gamma(x);
+}
+
+#define APPROX(name) \
+double math_##name(double x) \
+{ \
+	return approx_##name(x); \
+} \
+float math_##name##f(float x) \
+{ \
+	return approx_##name##f(x); \
+} \
+void math_##name##v(double *restrict y, const double *restrict x, \
+		size_t n) \
+{ \
+	for (size_t i = 0; i < n; i++) \
+		y[i] = approx_##name(x[i]); \
+} \
+void math_##name##vf(float *restrict y, const float *restrict x, size_t n) \
+{ \
+	for (size_t i = 0; i < n; i++) \
+		y[i] = approx_##name##f(x[i]); \
+}
+
+/* the same with the large arguments computed again by libm, in a second
+ * loop so that the first one still vectorizes
+ */
+#define APPROX_TRIG(name) \
+double math_##name(double x) \
+{ \
+	return fabs(x) < APPROX_TRIG_MAX ? approx_##name(x) : name##l(x); \
+} \
+float math_##name##f(float x) \
+{ \
+	return fabsf(x) < APPROX_TRIG_MAX ? approx_##name##f(x) : name(x); \
+} \
+void math_##name##v(double *restrict y, const double *restrict x, \
+		size_t n) \
+{ \
+	for (size_t i = 0; i < n; i++) \
+		y[i] = approx_##name(x[i]); \
+	for (size_t i = 0; i < n; i++) \
+		if (!(fabs(x[i]) < APPROX_TRIG_MAX)) \
+			y[i] = name##l(x[i]); \
+} \
+void math_##name##vf(float *restrict y, const float *restrict x, size_t n) \
+{ \
+	for (size_t i = 0; i < n; i++) \
+		y[i] = approx_##name##f(x[i]); \
+	for (size_t i = 0; i < n; i++) \
+		if (!(fabsf(x[i]) < APPROX_TRIG_MAX)) \
+			y[i] = name(x[i]); \
+}
+
+APPROX_TRIG(sin)
+APPROX_TRIG(cos)
+APPROX(exp)
+APPROX(log)
+APPROX(sqrt)
+APPROX(erfc)
+APPROX(gamma)
@@ -0,0 +1,163 @@
+#include "cake.h"
+
+struct parallel {
+	const MathProgram *program;
+	size_t count;
+	size_t chunk;
+	/* start of the next chunk, shared by all workers */
+	size_t next;
+	void (*work)(MathContext *ctx, void *arg, size_t begin, size_t end);
+	void *arg;
+};
+
+static void *parallel_worker(void *arg)
+{
+	struct parallel *const parallel = arg;
+	MathContext ctx;
+	size_t begin, end;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = parallel->program;
+	ctx.nested = true;
+	while (1) {
+		begin = __atomic_fetch_add(&parallel->next, parallel->chunk,
+				__ATOMIC_RELAXED);
+		if (begin >= parallel->count)
+			break;
+		end = MIN(begin + parallel->chunk, parallel->count);
+		(*parallel->work)(&ctx, parallel->arg, begin, end);
+	}
+	math_freecontext(&ctx);
+	return NULL;
+}
+
+unsigned math_threadcount(void)
+{
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count < 1 ? 1 : count;
+}
+
+/* calls work for chunks of [0, count) on up to numThreads threads, each
+ * with its own context computing the program; the calling thread is one
+ * of them; a chunk or thread count of 0 picks one
+ */
+void math_parallel(const MathProgram *program, size_t count, size_t chunk,
+		void (*work)(MathContext *ctx, void *arg, size_t begin,
+			size_t end),
+		void *arg, unsigned numThreads)
+{
+	struct parallel parallel;
+	size_t numChunks;
+	unsigned numStarted = 0;
+
+	if (count == 0)
+		return;
+	if (numThreads == 0)
+		numThreads = math_threadcount();
+	/* a few chunks per thread even out uneven items */
+	if (chunk == 0)
+		chunk = MAX(count / (numThreads * 16), (size_t) 1);
+	numChunks = (count + chunk - 1) / chunk;
+	if (numThreads > numChunks)
+		numThreads = numChunks;
+
+	parallel.program = program;
+	parallel.count = count;
+	parallel.chunk = chunk;
+	parallel.next = 0;
+	parallel.work = work;
+	parallel.arg = arg;
+
+	pthread_t threads[numThreads];
+	/* if a thread can not start, the others take over its chunks */
+	for (unsigned i = 1; i < numThreads; i++)
+		if (pthread_create(&threads[numStarted], NULL,
+					parallel_worker, &parallel) == 0)
+			numStarted++;
+	parallel_worker(&parallel);
+	for (unsigned i = 0; i < numStarted; i++)
+		pthread_join(threads[i], NULL);
+}
+
+struct batch {
+	const MathGroup *const *groups;
+	const char *const *texts;
+	MathResult *results;
+};
+
+static void batch_compute(MathContext *ctx, const MathGroup *group,
+		MathResult *result)
+{
+	math_seterror(ctx, MATH_SUCCESS, 0);
+	ctx->frame = ctx->numLocals;
+	result->value = math_computegroup(ctx, group);
+	result->error = ctx->error;
+	result->errorNumber = ctx->errorNumber;
+}
+
+static void batch_computegroups(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct batch *const batch = arg;
+
+	for (size_t i = begin; i < end; i++)
+		batch_compute(ctx, batch->groups[i], &batch->results[i]);
+}
+
+static void batch_evaluatetexts(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct batch *const batch = arg;
+	MathFunction constant;
+
+	memset(&constant, 0, sizeof(constant));
+	for (size_t i = begin; i < end; i++) {
+		MathResult *const result = &batch->results[i];
+
+		constant.group = math_parse(ctx, batch->texts[i]);
+		if (constant.group == NULL ||
+				!math_bindfunction(ctx, &constant)) {
+			result->value = NAN;
+			/* an empty text leaves no error */
+			result->error = ctx->error == MATH_SUCCESS ?
+				MATH_HANGING_OPERATOR : ctx->error;
+			result->errorNumber = ctx->errorNumber;
+		} else {
+			batch_compute(ctx, constant.group, result);
+		}
+		math_freegroup(ctx, constant.group);
+	}
+}
+
+/* computes bound groups without parameters, the results are in the
+ * order of the groups
+ */
+void math_computebatch(const MathProgram *program,
+		const MathGroup *const *groups, size_t count,
+		MathResult *results, unsigned numThreads)
+{
+	struct batch batch = {
+		.groups = groups,
+		.results = results,
+	};
+
+	math_parallel(program, count, 0, batch_computegroups, &batch,
+			numThreads);
+}
+
+/* tokenizes, parses, binds and computes each text on its own, failures
+ * only affect the result of their text
+ */
+void math_evaluatebatch(const MathProgram *program,
+		const char *const *texts, size_t count,
+		MathResult *results, unsigned numThreads)
+{
+	struct batch batch = {
+		.texts = texts,
+		.results = results,
+	};
+
+	math_parallel(program, count, 0, batch_evaluatetexts, &batch,
+			numThreads);
+}
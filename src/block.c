@@ -0,0 +1,547 @@
+#include "cake.h"
+
+/* vector versions of the approximations used by system.c */
+static const struct {
+	void (*v)(double *restrict y, const double *restrict x, size_t n);
+	void (*vf)(float *restrict y, const float *restrict x, size_t n);
+} block_approx[SYSTEM_MAX] = {
+	[SYSTEM_EXP] = { math_expv, math_expvf },
+	[SYSTEM_ERFC] = { math_erfcv, math_erfcvf },
+	[SYSTEM_SQRT] = { math_sqrtv, math_sqrtvf },
+	[SYSTEM_LN] = { math_logv, math_logvf },
+	[SYSTEM_SIN] = { math_sinv, math_sinvf },
+	[SYSTEM_COS] = { math_cosv, math_cosvf },
+	[SYSTEM_GAMMA] = { math_gammav, math_gammavf },
+};
+
+static bool block_equal(const MathOperation *a, const MathOperation *b)
+{
+	if (a->type != b->type || a->function != b->function ||
+			a->group != b->group || a->index != b->index ||
+			memcmp(a->arguments, b->arguments,
+				sizeof(a->arguments)) != 0)
+		return false;
+	return a->value == b->value || (isnan(a->value) && isnan(b->value));
+}
+
+static size_t block_hash(const MathOperation *op)
+{
+	const double value = op->value;
+	uint64_t hash = 0xcbf29ce484222325, bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	/* all NaN are equal */
+	if (isnan(value))
+		bits = 0;
+	hash = (hash ^ op->type) * 0x100000001b3;
+	hash = (hash ^ (uintptr_t) op->function) * 0x100000001b3;
+	hash = (hash ^ (uintptr_t) op->group) * 0x100000001b3;
+	hash = (hash ^ op->index) * 0x100000001b3;
+	for (size_t i = 0; i < ARRLEN(op->arguments); i++)
+		hash = (hash ^ op->arguments[i]) * 0x100000001b3;
+	hash = (hash ^ bits) * 0x100000001b3;
+	/* the bits of small numbers differ at the top only */
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccd;
+	return hash ^ hash >> 33;
+}
+
+static bool block_growtable(MathContext *ctx, MathBlock *block)
+{
+	const size_t newSize = block->tableSize * 2 + 64;
+	size_t *newTable;
+
+	newTable = malloc(sizeof(*newTable) * newSize);
+	if (newTable == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	for (size_t i = 0; i < newSize; i++)
+		newTable[i] = (size_t) -1;
+	for (size_t i = 0; i < block->numOperations; i++) {
+		size_t slot = block_hash(&block->operations[i]) & (newSize - 1);
+		while (newTable[slot] != (size_t) -1)
+			slot = (slot + 1) & (newSize - 1);
+		newTable[slot] = i;
+	}
+	free(block->table);
+	block->table = newTable;
+	block->tableSize = newSize;
+	return true;
+}
+
+/* returns the existing equal operation or appends it */
+static size_t block_operation(MathContext *ctx, MathBlock *block,
+		MathOperation op)
+{
+	size_t slot;
+
+	if (block->numOperations * 2 >= block->tableSize &&
+			!block_growtable(ctx, block))
+		return -1;
+	slot = block_hash(&op) & (block->tableSize - 1);
+	for (; block->table[slot] != (size_t) -1;
+			slot = (slot + 1) & (block->tableSize - 1))
+		if (block_equal(&block->operations[block->table[slot]], &op))
+			return block->table[slot];
+	if (block->numOperations == block->maxOperations) {
+		const size_t newMax = block->maxOperations * 2 + 16;
+		MathOperation *const newOperations = realloc(block->operations,
+				sizeof(*block->operations) * newMax);
+		if (newOperations == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return -1;
+		}
+		block->operations = newOperations;
+		block->maxOperations = newMax;
+	}
+	block->table[slot] = block->numOperations;
+	block->operations[block->numOperations] = op;
+	return block->numOperations++;
+}
+
+static size_t block_number(MathContext *ctx, MathBlock *block,
+		number_t value)
+{
+	return block_operation(ctx, block, (MathOperation) {
+		.type = GROUP_NUMBER,
+		.value = value,
+	});
+}
+
+/* adds a list the block is computed over, the lists of variables are
+ * borrowed and the values of others belong to the block from now on
+ */
+static size_t block_list(MathContext *ctx, MathBlock *block, MathList list)
+{
+	MathList *newLeaves;
+	size_t index;
+
+	if (block->numLeaves > 0 && list.count != block->count) {
+		math_seterror(ctx, MATH_LIST_LENGTH, 0);
+		math_freelist(&list);
+		return -1;
+	}
+	for (index = 0; index < block->numLeaves; index++)
+		if (list.borrowed && block->leaves[index].borrowed &&
+				block->leaves[index].values == list.values &&
+				block->leaves[index].first == list.first)
+			break;
+	if (index == block->numLeaves) {
+		newLeaves = realloc(block->leaves, sizeof(*block->leaves) *
+				(block->numLeaves + 1));
+		if (newLeaves == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			math_freelist(&list);
+			return -1;
+		}
+		block->leaves = newLeaves;
+		block->leaves[block->numLeaves++] = list;
+		block->count = list.count;
+	}
+	return block_operation(ctx, block, (MathOperation) {
+		.type = GROUP_LIST,
+		.index = index,
+	});
+}
+
+/* appends the operations of the group, the parameters are the
+ * operations computing the arguments of the function it is in
+ */
+static size_t block_group(MathContext *ctx, MathBlock *block,
+		const MathGroup *group, const size_t *parameters, size_t depth)
+{
+	MathOperation op;
+
+	memset(&op, 0, sizeof(op));
+	op.type = group->type;
+	switch (group->type) {
+	case GROUP_NUMBER:
+		return block_number(ctx, block, group->value);
+	case GROUP_VARIABLE:
+		/* binding failed */
+		return block_number(ctx, block, NAN);
+	case GROUP_PARAMETER:
+		return parameters[group->index];
+	case GROUP_GLOBAL: {
+		MathVariable *const var =
+			&ctx->program->variables[group->index];
+		MathList list;
+
+		/* only while math_bindprogram() computes the variables */
+		if (var->state != VARIABLE_COMPUTED)
+			math_computevariable(ctx, var);
+		if (var->list == NULL || !block->lists)
+			return block_number(ctx, block, var->value);
+		list = *var->list;
+		list.borrowed = true;
+		return block_list(ctx, block, list);
+	}
+	case GROUP_LIST: {
+		MathList list;
+
+		if (!block->lists)
+			return block_number(ctx, block, NAN);
+		if (!math_literallist(ctx, group, &list))
+			return -1;
+		return block_list(ctx, block, list);
+	}
+	case GROUP_RANGE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		return block_number(ctx, block, NAN);
+	case GROUP_SOLVE: {
+		MathList list;
+
+		/* the roots can not depend on the samples */
+		if (!block->lists || !math_isconstant(group))
+			return block_number(ctx, block, NAN);
+		if (!math_solvegroup(ctx, group, &list))
+			return -1;
+		return block_list(ctx, block, list);
+	}
+	case GROUP_NEGATE:
+		op.arguments[0] = block_group(ctx, block, group->group,
+				parameters, depth);
+		if (op.arguments[0] == (size_t) -1)
+			return -1;
+		break;
+	case GROUP_CALL: {
+		size_t args[group->numArguments];
+
+		if (group->function == NULL)
+			return block_number(ctx, block, NAN);
+		for (size_t i = 0; i < group->numArguments; i++) {
+			args[i] = block_group(ctx, block, group->arguments[i],
+					parameters, depth);
+			if (args[i] == (size_t) -1)
+				return -1;
+		}
+		/* a recursion is computed by math_computefunction(), its
+		 * memo keeps it linear, inlined it is exponential
+		 */
+		if (group->function->group != NULL &&
+				(!group->function->recursive ||
+				 group->numArguments > MATH_MEMO_ARGUMENTS)) {
+			/* like math_computefunction() */
+			if (depth == MATH_MAX_DEPTH) {
+				math_seterror(ctx, MATH_RECURSIVE, 0);
+				return block_number(ctx, block, NAN);
+			}
+			return block_group(ctx, block, group->function->group,
+					args, depth + 1);
+		}
+		op.function = group->function;
+		memcpy(op.arguments, args, sizeof(*args) *
+				MIN(group->numArguments, ARRLEN(op.arguments)));
+		break;
+	}
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL: {
+		/* the bounds and the parameters the body may use */
+		const MathGroup *const name = group->arguments[0];
+
+		if (name->type != GROUP_PARAMETER ||
+				name->index + 2 > ARRLEN(op.arguments)) {
+			math_seterror(ctx, MATH_INVALID_CALL, 0);
+			return block_number(ctx, block, NAN);
+		}
+		op.group = group;
+		for (size_t i = 0; i < 2; i++) {
+			op.arguments[i] = block_group(ctx, block,
+					group->arguments[i + 1], parameters,
+					depth);
+			if (op.arguments[i] == (size_t) -1)
+				return -1;
+		}
+		for (size_t i = 0; i < name->index; i++)
+			op.arguments[i + 2] = parameters[i];
+		break;
+	}
+	case GROUP_ADD:
+	case GROUP_SUBTRACT:
+	case GROUP_MULTIPLY:
+	case GROUP_DIVIDE:
+	case GROUP_MOD:
+	case GROUP_AND:
+	case GROUP_OR:
+	case GROUP_XOR:
+	case GROUP_EQUALS:
+		/* the same as a subtraction */
+		if (op.type == GROUP_EQUALS)
+			op.type = GROUP_SUBTRACT;
+		op.arguments[0] = block_group(ctx, block, group->left,
+				parameters, depth);
+		if (op.arguments[0] == (size_t) -1)
+			return -1;
+		op.arguments[1] = block_group(ctx, block, group->right,
+				parameters, depth);
+		if (op.arguments[1] == (size_t) -1)
+			return -1;
+		break;
+	default:
+		return block_number(ctx, block, 0);
+	}
+	return block_operation(ctx, block, op);
+}
+
+/* adds the bound function to the block, it shares the operations that
+ * are the same in the earlier functions
+ */
+bool math_blockfunction(MathContext *ctx, MathBlock *block,
+		const MathFunction *func)
+{
+	size_t parameters[func->numParameters + 1];
+	size_t *newResults;
+	size_t result;
+
+	for (size_t i = 0; i < func->numParameters; i++) {
+		parameters[i] = block_operation(ctx, block, (MathOperation) {
+			.type = GROUP_PARAMETER,
+			.index = i,
+		});
+		if (parameters[i] == (size_t) -1)
+			return false;
+	}
+	result = block_group(ctx, block, func->group, parameters, 0);
+	if (result == (size_t) -1)
+		return false;
+	newResults = realloc(block->results, sizeof(*block->results) *
+			(block->numResults + 1));
+	if (newResults == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	block->results = newResults;
+	block->results[block->numResults++] = result;
+	return true;
+}
+
+/* computes a system or recursive function for every sample */
+static void block_call(MathContext *ctx, const MathOperation *op,
+		number_t *restrict y,
+		const number_t *const a[MATH_OPERATION_ARGUMENTS],
+		size_t count)
+{
+	const enum math_system system = math_systemof(op->function);
+	number_t (*funcZero)(MathContext *ctx);
+	number_t (*funcSingle)(MathContext *ctx, number_t);
+	number_t (*funcDouble)(MathContext *ctx, number_t, number_t);
+	number_t (*funcTriple)(MathContext *ctx, number_t, number_t, number_t);
+
+	if (op->function->group != NULL) {
+		const size_t frame = ctx->numLocals;
+
+		for (size_t p = 0; p < op->function->numParameters; p++)
+			if (math_pushlocal(ctx, 0) == (size_t) -1) {
+				ctx->numLocals = frame;
+				for (size_t i = 0; i < count; i++)
+					y[i] = NAN;
+				return;
+			}
+		for (size_t i = 0; i < count; i++) {
+			for (size_t p = 0; p < op->function->numParameters;
+					p++)
+				ctx->locals[frame + p] = a[p][i];
+			y[i] = math_computefunction(ctx, op->function);
+		}
+		ctx->numLocals = frame;
+		return;
+	}
+	if (system != SYSTEM_NONE && block_approx[system].v != NULL) {
+		switch (ctx->accuracy) {
+		case ACCURACY_DOUBLE: {
+			double in[MATH_BLOCK], out[MATH_BLOCK];
+
+			for (size_t i = 0; i < count; i++)
+				in[i] = a[0][i];
+			block_approx[system].v(out, in, count);
+			for (size_t i = 0; i < count; i++)
+				y[i] = out[i];
+			return;
+		}
+		case ACCURACY_FAST: {
+			float in[MATH_BLOCK], out[MATH_BLOCK];
+
+			for (size_t i = 0; i < count; i++)
+				in[i] = a[0][i];
+			block_approx[system].vf(out, in, count);
+			for (size_t i = 0; i < count; i++)
+				y[i] = out[i];
+			return;
+		}
+		default:
+		}
+	}
+	switch (op->function->numParameters) {
+	case 0:
+		funcZero = op->function->system;
+		for (size_t i = 0; i < count; i++)
+			y[i] = (*funcZero)(ctx);
+		break;
+	case 1:
+		funcSingle = op->function->system;
+		for (size_t i = 0; i < count; i++)
+			y[i] = (*funcSingle)(ctx, a[0][i]);
+		break;
+	case 2:
+		funcDouble = op->function->system;
+		for (size_t i = 0; i < count; i++)
+			y[i] = (*funcDouble)(ctx, a[0][i], a[1][i]);
+		break;
+	case 3:
+		funcTriple = op->function->system;
+		for (size_t i = 0; i < count; i++)
+			y[i] = (*funcTriple)(ctx, a[0][i], a[1][i], a[2][i]);
+		break;
+	}
+}
+
+/* computes a series for every sample, samples of the same bounds and
+ * parameters are computed once
+ */
+static void block_series(MathContext *ctx, const MathOperation *op,
+		number_t *restrict y,
+		const number_t *const a[MATH_OPERATION_ARGUMENTS],
+		size_t count)
+{
+	const size_t index = op->group->arguments[0]->index;
+	number_t outer[index + 1];
+	bool same;
+
+	for (size_t i = 0; i < count; i++) {
+		same = i > 0;
+		for (size_t p = 0; p < index + 2 && same; p++)
+			same = a[p][i] == a[p][i - 1];
+		if (same) {
+			y[i] = y[i - 1];
+			continue;
+		}
+		for (size_t p = 0; p < index; p++)
+			outer[p] = a[p + 2][i];
+		y[i] = math_computeseries(ctx, op->group, a[0][i], a[1][i],
+				outer);
+	}
+}
+
+/* computes all functions for count <= MATH_BLOCK samples, parameter i
+ * of sample j is parameters[i][j]
+ */
+bool math_computeblock(MathContext *ctx, MathBlock *block,
+		const number_t *const *parameters, size_t count)
+{
+	const size_t numValues = block->numOperations * MATH_BLOCK;
+
+	if (numValues > block->numValues) {
+		number_t *const newValues = realloc(block->values,
+				sizeof(*block->values) * numValues);
+		if (newValues == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return false;
+		}
+		block->values = newValues;
+		block->numValues = numValues;
+	}
+	block->complex = false;
+	for (size_t o = 0; o < block->numOperations; o++) {
+		const MathOperation *const op = &block->operations[o];
+		number_t *restrict const y = &block->values[o * MATH_BLOCK];
+		const number_t *a[MATH_OPERATION_ARGUMENTS];
+
+		for (size_t i = 0; i < MATH_OPERATION_ARGUMENTS; i++)
+			a[i] = &block->values[op->arguments[i] * MATH_BLOCK];
+
+		switch (op->type) {
+		case GROUP_NUMBER:
+			for (size_t i = 0; i < count; i++)
+				y[i] = op->value;
+			break;
+		case GROUP_PARAMETER:
+			memcpy(y, parameters[op->index], sizeof(*y) * count);
+			break;
+		case GROUP_LIST: {
+			const MathList *const list = &block->leaves[op->index];
+
+			if (list->values != NULL) {
+				memcpy(y, &list->values[block->offset],
+						sizeof(*y) * count);
+				break;
+			}
+			for (size_t i = 0; i < count; i++)
+				y[i] = list->first +
+					(number_t) (block->offset + i);
+			break;
+		}
+		case GROUP_NEGATE:
+			for (size_t i = 0; i < count; i++)
+				y[i] = -a[0][i];
+			break;
+		case GROUP_CALL:
+			block_call(ctx, op, y, a, count);
+			break;
+		case GROUP_SUM:
+		case GROUP_PRODUCT:
+		case GROUP_INTEGRAL:
+			block_series(ctx, op, y, a, count);
+			break;
+		case GROUP_ADD:
+			for (size_t i = 0; i < count; i++)
+				y[i] = a[0][i] + a[1][i];
+			break;
+		case GROUP_SUBTRACT:
+			for (size_t i = 0; i < count; i++)
+				y[i] = a[0][i] - a[1][i];
+			break;
+		case GROUP_MULTIPLY:
+			for (size_t i = 0; i < count; i++)
+				y[i] = a[0][i] * a[1][i];
+			break;
+		case GROUP_DIVIDE:
+			for (size_t i = 0; i < count; i++)
+				y[i] = a[0][i] / a[1][i];
+			break;
+		case GROUP_MOD:
+			for (size_t i = 0; i < count; i++)
+				y[i] = a[0][i] - a[1][i] *
+					floorl(a[0][i] / a[1][i]);
+			break;
+		case GROUP_AND:
+			for (size_t i = 0; i < count; i++)
+				y[i] = (a[0][i] != 0) & (a[1][i] != 0);
+			break;
+		case GROUP_OR:
+			for (size_t i = 0; i < count; i++)
+				y[i] = (a[0][i] != 0) | (a[1][i] != 0);
+			break;
+		case GROUP_XOR:
+			for (size_t i = 0; i < count; i++)
+				y[i] = (a[0][i] != 0) ^ (a[1][i] != 0);
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+/* the values of a function after math_computeblock(), the real parts
+ * after math_computecomplexblock()
+ */
+const number_t *math_blockresult(const MathBlock *block, size_t result)
+{
+	return &block->values[block->results[result] * MATH_BLOCK *
+		(block->complex ? 2 : 1)];
+}
+
+void math_freeblock(MathBlock *block)
+{
+	free(block->operations);
+	free(block->results);
+	free(block->table);
+	free(block->values);
+	for (size_t i = 0; i < block->numLeaves; i++)
+		math_freelist(&block->leaves[i]);
+	free(block->leaves);
+	memset(block, 0, sizeof(*block));
+}
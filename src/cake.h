@@ -3,10 +3,18 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <locale.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <wchar.h>
 #include <wctype.h>
@@ -24,6 +32,8 @@
 })
 
 typedef long double number_t;
+/* plot samples only decide signs and interpolate within a pixel */
+typedef float sample_t;
 
 typedef struct vector {
 	number_t x;
@@ -34,6 +44,8 @@ typedef struct vector {
 #include <SDL2/SDL_ttf.h>
 
 #include "math.h"
+#include "tile.h"
+#include "plot.h"
 #include "window.h"
 
 #endif
@@ -0,0 +1,369 @@
+#include "cake.h"
+
+/* the C expressions of the system functions, %0 and %1 are the
+ * arguments; they are variables or numbers so they may repeat
+ */
+static const char *codegen_system[SYSTEM_MAX] = {
+	[SYSTEM_FLOOR] = "floor(%0)",
+	[SYSTEM_CEIL] = "ceil(%0)",
+	[SYSTEM_EXP] = "exp(%0)",
+	[SYSTEM_POW] = "pow(%0, %1)",
+	[SYSTEM_ERFC] = "erfc(%0)",
+	[SYSTEM_SQRT] = "sqrt(%0)",
+	[SYSTEM_CBRT] = "cbrt(%0)",
+	[SYSTEM_ROOT] = "(%1 < 0 && fmod(%0, 2) != 0 && floor(%0) == %0 ? "
+		"-pow(-%1, 1 / %0) : pow(%1, 1 / %0))",
+	[SYSTEM_LOG10] = "log10(%0)",
+	[SYSTEM_LOG] = "log(%1) / log(%0)",
+	[SYSTEM_LN] = "log(%0)",
+	[SYSTEM_SIN] = "sin(%0)",
+	[SYSTEM_COS] = "cos(%0)",
+	[SYSTEM_TAN] = "tan(%0)",
+	[SYSTEM_COT] = "1 / tan(%0)",
+	[SYSTEM_SEC] = "1 / cos(%0)",
+	[SYSTEM_CSC] = "1 / sin(%0)",
+	[SYSTEM_SINH] = "sinh(%0)",
+	[SYSTEM_COSH] = "cosh(%0)",
+	[SYSTEM_TANH] = "tanh(%0)",
+	[SYSTEM_ASINH] = "asinh(%0)",
+	[SYSTEM_ACOSH] = "acosh(%0)",
+	[SYSTEM_ATANH] = "atanh(%0)",
+	[SYSTEM_GAMMA] = "tgamma(%0)",
+};
+
+/* constant integer powers up to this are written as products */
+#define CODEGEN_MAX_POWER 64
+
+/* the operators, %0 and %1 are the operands */
+static const char *codegen_operators[] = {
+	[GROUP_NEGATE] = "-%0",
+	[GROUP_ADD] = "%0 + %1",
+	[GROUP_SUBTRACT] = "%0 - %1",
+	[GROUP_MULTIPLY] = "%0 * %1",
+	[GROUP_DIVIDE] = "%0 / %1",
+	[GROUP_MOD] = "%0 - %1 * floor(%0 / %1)",
+	[GROUP_AND] = "(%0 != 0) & (%1 != 0)",
+	[GROUP_OR] = "(%0 != 0) | (%1 != 0)",
+	[GROUP_XOR] = "(%0 != 0) ^ (%1 != 0)",
+};
+
+static const char codegen_preamble[] =
+	"/* generated by cake, the definitions compute in double with the\n"
+	" * variables and constant parts folded; define CAKE_API as static\n"
+	" * inline before including this file to inline them into the caller\n"
+	" */\n"
+	"#include <math.h>\n"
+	"#include <stddef.h>\n"
+	"\n"
+	"#ifndef CAKE_API\n"
+	"#define CAKE_API\n"
+	"#endif\n";
+
+/* names are letters of any script, the bytes of those that are not
+ * ascii are written as hex
+ */
+static const char *codegen_name(char text[1024], const char *prefix,
+		const char *name)
+{
+	size_t length;
+
+	length = snprintf(text, 1024, "%s", prefix);
+	for (; *name != '\0'; name++)
+		if (isascii(*name) && isalnum(*name))
+			text[length++] = *name;
+		else
+			length += sprintf(&text[length], "_%02x",
+					(unsigned char) *name);
+	text[length] = '\0';
+	return text;
+}
+
+/* the shortest text that reads back as the same double */
+static void codegen_number(char *text, size_t size, number_t value)
+{
+	const double d = value;
+
+	if (isnan(d)) {
+		snprintf(text, size, "NAN");
+		return;
+	}
+	if (isinf(d)) {
+		snprintf(text, size, "%sINFINITY", d < 0 ? "(-" : "");
+		if (d < 0)
+			strcat(text, ")");
+		return;
+	}
+	for (int precision = 1; precision <= 17; precision++) {
+		snprintf(text, size, d < 0 ? "(%.*g" : "%.*g", precision, d);
+		if (strtod(&text[d < 0], NULL) == d)
+			break;
+	}
+	/* a double and not an int */
+	if (strpbrk(text, ".e") == NULL)
+		strcat(text, ".0");
+	if (d < 0)
+		strcat(text, ")");
+}
+
+/* the operands are the constant values or the variables of the earlier
+ * operations
+ */
+static void codegen_format(FILE *fp, const char *format,
+		char operands[][64])
+{
+	for (; *format != '\0'; format++)
+		if (format[0] == '%' && isdigit(format[1]))
+			fputs(operands[*++format - '0'], fp);
+		else
+			fputc(*format, fp);
+}
+
+/* base^n of an integer n > 0 by squaring, the compiler computes equal
+ * squares once; unlike pow() the products are inlined and vectorized
+ */
+static void codegen_power(FILE *fp, const char *base, unsigned n)
+{
+	if (n == 1) {
+		fputs(base, fp);
+		return;
+	}
+	for (int i = 0; i < 2; i++) {
+		fputs(i == 0 ? (n / 2 > 1 ? "(" : "") :
+				(n / 2 > 1 ? " * (" : " * "), fp);
+		codegen_power(fp, base, n / 2);
+		fputs(n / 2 > 1 ? ")" : "", fp);
+	}
+	if (n % 2 == 1)
+		fprintf(fp, " * %s", base);
+}
+
+/* the number of operands of the operation */
+static size_t codegen_arity(const MathOperation *op)
+{
+	switch (op->type) {
+	case GROUP_NUMBER:
+	case GROUP_PARAMETER:
+		return 0;
+	case GROUP_NEGATE:
+		return 1;
+	case GROUP_CALL:
+		return op->function->numParameters;
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+		/* the bounds, the parameters follow */
+		return 2;
+	default:
+		return 2;
+	}
+}
+
+/* writes the body of the function: one constant for every operation that
+ * depends on a parameter, the others are computed now and written as
+ * numbers
+ */
+static bool codegen_body(MathContext *ctx, FILE *fp,
+		const MathFunction *func)
+{
+	MathBlock block;
+	const number_t *values;
+	number_t nans[func->numParameters + 1];
+	const number_t *parameters[func->numParameters + 1];
+	bool *constant = NULL, *used = NULL;
+	char operands[MATH_MEMO_ARGUMENTS][64], name[1024];
+	size_t result;
+	number_t exponent;
+	bool success = false;
+
+	memset(&block, 0, sizeof(block));
+	for (size_t i = 0; i < func->numParameters; i++) {
+		nans[i] = NAN;
+		parameters[i] = &nans[i];
+	}
+	math_seterror(ctx, MATH_SUCCESS, 0);
+	if (!math_blockfunction(ctx, &block, func))
+		goto end;
+	constant = calloc(block.numOperations, sizeof(*constant));
+	used = calloc(block.numOperations, sizeof(*used));
+	if (constant == NULL || used == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		goto end;
+	}
+	for (size_t o = 0; o < block.numOperations; o++) {
+		const MathOperation *const op = &block.operations[o];
+
+		/* a recursion has no end in C */
+		if (op->type == GROUP_CALL && op->function->group != NULL) {
+			math_seterror(ctx, MATH_RECURSIVE, 0);
+			goto end;
+		}
+		if (op->type == GROUP_CALL &&
+				codegen_system[math_systemof(op->function)] ==
+				NULL) {
+			math_seterror(ctx, MATH_INVALID_CALL, 0);
+			goto end;
+		}
+		constant[o] = op->type != GROUP_PARAMETER;
+		for (size_t a = 0; a < codegen_arity(op); a++)
+			constant[o] &= constant[op->arguments[a]];
+		/* a series is only written as its value */
+		if (op->group != NULL)
+			for (size_t p = 0; p < op->group->arguments[0]->index;
+					p++)
+				constant[o] &= !math_references(
+						op->group->arguments[3], p);
+	}
+	if (!math_computeblock(ctx, &block, parameters, 1))
+		goto end;
+	/* the operations are after their operands */
+	result = block.results[0];
+	used[result] = true;
+	for (size_t o = block.numOperations; o-- > 0; ) {
+		const MathOperation *const op = &block.operations[o];
+
+		if (!used[o] || constant[o])
+			continue;
+		if (op->group != NULL) {
+			math_seterror(ctx, MATH_INVALID_CALL, 0);
+			goto end;
+		}
+		for (size_t a = 0; a < codegen_arity(op); a++)
+			used[op->arguments[a]] = true;
+	}
+
+	values = block.values;
+	for (size_t o = 0; o < block.numOperations; o++) {
+		const MathOperation *const op = &block.operations[o];
+
+		if (op->type == GROUP_PARAMETER && !used[o])
+			fprintf(fp, "\t(void) %s;\n", codegen_name(name, "p_",
+						func->parameters[op->index]));
+		if (!used[o] || constant[o])
+			continue;
+		for (size_t a = 0; a < codegen_arity(op); a++) {
+			const size_t arg = op->arguments[a];
+
+			if (constant[arg])
+				codegen_number(operands[a], sizeof(operands[a]),
+						values[arg * MATH_BLOCK]);
+			else
+				snprintf(operands[a], sizeof(operands[a]),
+						"v%zu", arg);
+		}
+		fprintf(fp, "\tconst double v%zu = ", o);
+		switch (op->type) {
+		case GROUP_PARAMETER:
+			fputs(codegen_name(name, "p_",
+					func->parameters[op->index]), fp);
+			break;
+		case GROUP_CALL:
+			exponent = math_systemof(op->function) == SYSTEM_POW &&
+				constant[op->arguments[1]] ?
+				values[op->arguments[1] * MATH_BLOCK] : 0;
+			if (floorl(exponent) == exponent && exponent != 0 &&
+					fabsl(exponent) <= CODEGEN_MAX_POWER) {
+				fputs(exponent < 0 ? "1 / (" : "", fp);
+				codegen_power(fp, operands[0],
+						fabsl(exponent));
+				fputs(exponent < 0 ? ")" : "", fp);
+				break;
+			}
+			codegen_format(fp, codegen_system[
+					math_systemof(op->function)], operands);
+			break;
+		default:
+			codegen_format(fp, codegen_operators[op->type],
+					operands);
+		}
+		fputs(";\n", fp);
+	}
+	if (constant[result]) {
+		codegen_number(operands[0], sizeof(operands[0]),
+				values[result * MATH_BLOCK]);
+		fprintf(fp, "\treturn %s;\n", operands[0]);
+	} else {
+		fprintf(fp, "\treturn v%zu;\n", result);
+	}
+	success = true;
+
+end:
+	free(constant);
+	free(used);
+	math_freeblock(&block);
+	return success;
+}
+
+/* the scalar function and its batch variant over arrays */
+static bool codegen_function(MathContext *ctx, FILE *fp,
+		const MathFunction *func, const char *name)
+{
+	char parameter[1024];
+
+	fprintf(fp, "\nCAKE_API double %s(", name);
+	for (size_t i = 0; i < func->numParameters; i++)
+		fprintf(fp, "%sdouble %s", i == 0 ? "" : ", ",
+				codegen_name(parameter, "p_",
+					func->parameters[i]));
+	fputs(func->numParameters == 0 ? "void)\n{\n" : ")\n{\n", fp);
+	if (!codegen_body(ctx, fp, func))
+		return false;
+	fputs("}\n", fp);
+
+	fprintf(fp, "\nCAKE_API void %s_batch(double *restrict result", name);
+	for (size_t i = 0; i < func->numParameters; i++)
+		fprintf(fp, ",\n\t\tconst double *restrict %s",
+				codegen_name(parameter, "p_",
+					func->parameters[i]));
+	fprintf(fp, ", size_t count)\n{\n"
+			"\tfor (size_t i = 0; i < count; i++)\n"
+			"\t\tresult[i] = %s(", name);
+	for (size_t i = 0; i < func->numParameters; i++)
+		fprintf(fp, "%s%s[i]", i == 0 ? "" : ", ",
+				codegen_name(parameter, "p_",
+					func->parameters[i]));
+	fputs(");\n}\n", fp);
+	return true;
+}
+
+/* writes the bound program as C source: a function returning the value of
+ * each variable and for each function and equation a function of its
+ * parameters and one computing arrays of them; equations are named
+ * equation0, equation1, ... and all names have the prefix cake_; failed
+ * is set to the function that could not be generated
+ */
+bool math_writesource(MathContext *ctx, const MathProgram *program,
+		FILE *fp, size_t *failed)
+{
+	char name[1024], value[64];
+	size_t numEquations = 0;
+
+	fputs(codegen_preamble, fp);
+	for (size_t i = 0; i < program->numVariables; i++) {
+		const MathVariable *const var = &program->variables[i];
+
+		fputc('\n', fp);
+		if (var->list != NULL) {
+			fprintf(fp, "/* %s is a list, lists are computed "
+					"with math_computelist() only */\n",
+					var->name);
+			continue;
+		}
+		codegen_number(value, sizeof(value), var->value);
+		fprintf(fp, "CAKE_API double %s(void)\n{\n\treturn %s;\n}\n",
+				codegen_name(name, "cake_", var->name), value);
+	}
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		const MathFunction *const func = &program->functions[i];
+
+		if (func->name[0] == '\0')
+			snprintf(name, sizeof(name), "cake_equation%zu",
+					numEquations++);
+		else
+			codegen_name(name, "cake_", func->name);
+		if (!codegen_function(ctx, fp, func, name)) {
+			*failed = i;
+			return false;
+		}
+	}
+	return true;
+}
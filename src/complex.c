@@ -0,0 +1,554 @@
+#include "cake.h"
+
+/* complex values are computed on the split real and imaginary parts of
+ * the block, each loop runs over arrays of number_t like the real
+ * operations of block.c; functions without a complex version are real
+ * where all their arguments are real and NaN elsewhere
+ */
+
+/* constant integer exponents up to this are multiplied out */
+#define COMPLEX_MAX_POWER 64
+
+/* vector versions of the real functions the complex ones are made of */
+static const struct {
+	void (*v)(double *restrict y, const double *restrict x, size_t n);
+	void (*vf)(float *restrict y, const float *restrict x, size_t n);
+} complex_approx[SYSTEM_MAX] = {
+	[SYSTEM_EXP] = { math_expv, math_expvf },
+	[SYSTEM_SQRT] = { math_sqrtv, math_sqrtvf },
+	[SYSTEM_LN] = { math_logv, math_logvf },
+	[SYSTEM_SIN] = { math_sinv, math_sinvf },
+	[SYSTEM_COS] = { math_cosv, math_cosvf },
+};
+
+/* replaces the values by the real function of the system */
+static void complex_real(MathContext *ctx, enum math_system system,
+		number_t *x, size_t count)
+{
+	number_t (*funcSingle)(MathContext *ctx, number_t);
+
+	switch (ctx->accuracy) {
+	case ACCURACY_DOUBLE: {
+		/* cleared, the compiler can not tell that count values
+		 * are set
+		 */
+		double in[MATH_BLOCK] = { 0 }, out[MATH_BLOCK];
+
+		for (size_t i = 0; i < count; i++)
+			in[i] = x[i];
+		complex_approx[system].v(out, in, count);
+		for (size_t i = 0; i < count; i++)
+			x[i] = out[i];
+		return;
+	}
+	case ACCURACY_FAST: {
+		float in[MATH_BLOCK] = { 0 }, out[MATH_BLOCK];
+
+		for (size_t i = 0; i < count; i++)
+			in[i] = x[i];
+		complex_approx[system].vf(out, in, count);
+		for (size_t i = 0; i < count; i++)
+			x[i] = out[i];
+		return;
+	}
+	default:
+	}
+	funcSingle = math_systemfunction(system)->system;
+	for (size_t i = 0; i < count; i++)
+		x[i] = (*funcSingle)(ctx, x[i]);
+}
+
+/* y may be a or b */
+static void complex_multiply(number_t *yr, number_t *yi,
+		const number_t *ar, const number_t *ai,
+		const number_t *br, const number_t *bi, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		const number_t r = ar[i] * br[i] - ai[i] * bi[i];
+
+		yi[i] = ar[i] * bi[i] + ai[i] * br[i];
+		yr[i] = r;
+	}
+}
+
+/* y may be a or b, real divisors divide exactly */
+static void complex_divide(number_t *yr, number_t *yi,
+		const number_t *ar, const number_t *ai,
+		const number_t *br, const number_t *bi, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		const number_t d = bi[i] == 0 ? br[i] :
+			br[i] * br[i] + bi[i] * bi[i];
+		const number_t r = (ar[i] * br[i] + ai[i] * bi[i]) / d;
+
+		yi[i] = bi[i] == 0 ? ai[i] / br[i] :
+			(ai[i] * br[i] - ar[i] * bi[i]) / d;
+		yr[i] = bi[i] == 0 ? ar[i] / br[i] : r;
+	}
+}
+
+/* e^a (cos b + i sin b) */
+static void complex_exp(MathContext *ctx, number_t *yr, number_t *yi,
+		const number_t *ar, const number_t *ai, size_t count)
+{
+	number_t e[MATH_BLOCK], c[MATH_BLOCK], s[MATH_BLOCK];
+
+	memcpy(e, ar, sizeof(*e) * count);
+	memcpy(c, ai, sizeof(*c) * count);
+	memcpy(s, ai, sizeof(*s) * count);
+	complex_real(ctx, SYSTEM_EXP, e, count);
+	complex_real(ctx, SYSTEM_COS, c, count);
+	complex_real(ctx, SYSTEM_SIN, s, count);
+	for (size_t i = 0; i < count; i++) {
+		yi[i] = ai[i] == 0 ? 0 : e[i] * s[i];
+		yr[i] = e[i] * c[i];
+	}
+}
+
+/* the principal logarithm, ln |z| + i arg z; the sign of a zero
+ * imaginary part is dropped so that ln -1 is iπ
+ */
+static void complex_ln(MathContext *ctx, number_t *yr, number_t *yi,
+		const number_t *ar, const number_t *ai, size_t count)
+{
+	number_t m[MATH_BLOCK];
+
+	for (size_t i = 0; i < count; i++)
+		m[i] = ar[i] * ar[i] + ai[i] * ai[i];
+	complex_real(ctx, SYSTEM_LN, m, count);
+	if (ctx->accuracy == ACCURACY_EXACT) {
+		for (size_t i = 0; i < count; i++)
+			yi[i] = atan2l(ai[i] == 0 ? 0 : ai[i], ar[i]);
+	} else {
+		for (size_t i = 0; i < count; i++)
+			yi[i] = atan2(ai[i] == 0 ? 0 : ai[i], ar[i]);
+	}
+	for (size_t i = 0; i < count; i++)
+		yr[i] = m[i] / 2;
+}
+
+/* the principal root, its real part is never negative and the root of
+ * a negative real number is on the positive imaginary axis
+ */
+static void complex_sqrt(MathContext *ctx, number_t *yr, number_t *yi,
+		const number_t *ar, const number_t *ai, size_t count)
+{
+	number_t t[MATH_BLOCK];
+
+	for (size_t i = 0; i < count; i++)
+		t[i] = ar[i] * ar[i] + ai[i] * ai[i];
+	complex_real(ctx, SYSTEM_SQRT, t, count);
+	for (size_t i = 0; i < count; i++)
+		t[i] = (t[i] + fabsl(ar[i])) / 2;
+	complex_real(ctx, SYSTEM_SQRT, t, count);
+	for (size_t i = 0; i < count; i++) {
+		const number_t other = t[i] == 0 ? 0 : ai[i] / (2 * t[i]);
+
+		if (ar[i] >= 0) {
+			yr[i] = t[i];
+			yi[i] = other;
+		} else {
+			yr[i] = fabsl(other);
+			yi[i] = ai[i] < 0 ? -t[i] : t[i];
+		}
+	}
+}
+
+/* z^n of an integer n by squaring */
+static void complex_integerpow(number_t *restrict yr,
+		number_t *restrict yi, const number_t *ar, const number_t *ai,
+		number_t n, size_t count)
+{
+	number_t br[MATH_BLOCK], bi[MATH_BLOCK];
+
+	memcpy(br, ar, sizeof(*br) * count);
+	memcpy(bi, ai, sizeof(*bi) * count);
+	for (size_t i = 0; i < count; i++) {
+		yr[i] = 1;
+		yi[i] = 0;
+	}
+	for (unsigned e = fabsl(n); e > 0; e >>= 1) {
+		if (e & 1)
+			complex_multiply(yr, yi, yr, yi, br, bi, count);
+		complex_multiply(br, bi, br, bi, br, bi, count);
+	}
+	if (n < 0) {
+		for (size_t i = 0; i < count; i++) {
+			br[i] = 1;
+			bi[i] = 0;
+		}
+		complex_divide(yr, yi, br, bi, yr, yi, count);
+	}
+}
+
+/* z^w = e^(w ln z) */
+static void complex_pow(MathContext *ctx, number_t *restrict yr,
+		number_t *restrict yi, const number_t *zr, const number_t *zi,
+		const number_t *wr, const number_t *wi, size_t count)
+{
+	number_t br[MATH_BLOCK], bi[MATH_BLOCK];
+
+	complex_ln(ctx, br, bi, zr, zi, count);
+	complex_multiply(br, bi, br, bi, wr, wi, count);
+	complex_exp(ctx, yr, yi, br, bi, count);
+	/* ln 0 is infinite */
+	for (size_t i = 0; i < count; i++)
+		if (zr[i] == 0 && zi[i] == 0) {
+			yr[i] = wr[i] == 0 && wi[i] == 0 ? 1 :
+				wr[i] > 0 ? 0 : NAN;
+			yi[i] = 0;
+		}
+}
+
+/* the sine and cosine of the angles and the hyperbolic ones of the
+ * other parts, their products make up the trigonometric functions
+ */
+static void complex_parts(MathContext *ctx,
+		number_t *restrict c, number_t *restrict s,
+		number_t *restrict ch, number_t *restrict sh,
+		const number_t *angle, const number_t *other, size_t count)
+{
+	memcpy(c, angle, sizeof(*c) * count);
+	memcpy(s, angle, sizeof(*s) * count);
+	memcpy(ch, other, sizeof(*ch) * count);
+	complex_real(ctx, SYSTEM_COS, c, count);
+	complex_real(ctx, SYSTEM_SIN, s, count);
+	complex_real(ctx, SYSTEM_EXP, ch, count);
+	for (size_t i = 0; i < count; i++) {
+		const number_t e = ch[i];
+
+		ch[i] = (e + 1 / e) / 2;
+		sh[i] = other[i] == 0 ? 0 : (e - 1 / e) / 2;
+	}
+}
+
+/* sin z = sin a cosh b + i cos a sinh b,
+ * cos z = cos a cosh b - i sin a sinh b and their quotients
+ */
+static void complex_circular(MathContext *ctx, enum math_system system,
+		number_t *restrict yr, number_t *restrict yi,
+		const number_t *ar, const number_t *ai, size_t count)
+{
+	number_t c[MATH_BLOCK], s[MATH_BLOCK];
+	number_t ch[MATH_BLOCK], sh[MATH_BLOCK];
+	number_t sr[MATH_BLOCK], si[MATH_BLOCK];
+	number_t cr[MATH_BLOCK], ci[MATH_BLOCK];
+
+	complex_parts(ctx, c, s, ch, sh, ar, ai, count);
+	for (size_t i = 0; i < count; i++) {
+		sr[i] = s[i] * ch[i];
+		si[i] = c[i] * sh[i];
+		cr[i] = c[i] * ch[i];
+		ci[i] = -s[i] * sh[i];
+		/* the numerator of sec and csc */
+		c[i] = 1;
+		s[i] = 0;
+	}
+	switch (system) {
+	case SYSTEM_SIN:
+		memcpy(yr, sr, sizeof(*yr) * count);
+		memcpy(yi, si, sizeof(*yi) * count);
+		break;
+	case SYSTEM_COS:
+		memcpy(yr, cr, sizeof(*yr) * count);
+		memcpy(yi, ci, sizeof(*yi) * count);
+		break;
+	case SYSTEM_TAN:
+		complex_divide(yr, yi, sr, si, cr, ci, count);
+		break;
+	case SYSTEM_COT:
+		complex_divide(yr, yi, cr, ci, sr, si, count);
+		break;
+	case SYSTEM_SEC:
+		complex_divide(yr, yi, c, s, cr, ci, count);
+		break;
+	default:
+		complex_divide(yr, yi, c, s, sr, si, count);
+	}
+}
+
+/* sinh z = sinh a cos b + i cosh a sin b,
+ * cosh z = cosh a cos b + i sinh a sin b and their quotient
+ */
+static void complex_hyperbolic(MathContext *ctx, enum math_system system,
+		number_t *restrict yr, number_t *restrict yi,
+		const number_t *ar, const number_t *ai, size_t count)
+{
+	number_t c[MATH_BLOCK], s[MATH_BLOCK];
+	number_t ch[MATH_BLOCK], sh[MATH_BLOCK];
+	number_t sr[MATH_BLOCK], si[MATH_BLOCK];
+	number_t cr[MATH_BLOCK], ci[MATH_BLOCK];
+
+	complex_parts(ctx, c, s, ch, sh, ai, ar, count);
+	for (size_t i = 0; i < count; i++) {
+		sr[i] = sh[i] * c[i];
+		si[i] = ch[i] * s[i];
+		cr[i] = ch[i] * c[i];
+		ci[i] = sh[i] * s[i];
+	}
+	switch (system) {
+	case SYSTEM_SINH:
+		memcpy(yr, sr, sizeof(*yr) * count);
+		memcpy(yi, si, sizeof(*yi) * count);
+		break;
+	case SYSTEM_COSH:
+		memcpy(yr, cr, sizeof(*yr) * count);
+		memcpy(yi, ci, sizeof(*yi) * count);
+		break;
+	default:
+		complex_divide(yr, yi, sr, si, cr, ci, count);
+	}
+}
+
+/* the function of the real arguments, NaN where one is not real */
+static void complex_fallback(MathContext *ctx, const MathOperation *op,
+		number_t *yr, number_t *yi,
+		const number_t *const ar[], const number_t *const ai[],
+		size_t count)
+{
+	const size_t frame = ctx->numLocals;
+	const size_t numParameters = op->function->numParameters;
+	bool real;
+
+	for (size_t p = 0; p < numParameters; p++)
+		if (math_pushlocal(ctx, 0) == (size_t) -1) {
+			ctx->numLocals = frame;
+			for (size_t i = 0; i < count; i++)
+				yr[i] = NAN;
+			memset(yi, 0, sizeof(*yi) * count);
+			return;
+		}
+	for (size_t i = 0; i < count; i++) {
+		real = true;
+		for (size_t p = 0; p < numParameters; p++) {
+			real &= ai[p][i] == 0;
+			ctx->locals[frame + p] = ar[p][i];
+		}
+		yr[i] = real ? math_computefunction(ctx, op->function) : NAN;
+		yi[i] = 0;
+	}
+	ctx->numLocals = frame;
+}
+
+/* computes a system or recursive function for every sample */
+static void complex_call(MathContext *ctx, const MathBlock *block,
+		const MathOperation *op, number_t *restrict yr,
+		number_t *restrict yi,
+		const number_t *const ar[], const number_t *const ai[],
+		size_t count)
+{
+	const enum math_system system = math_systemof(op->function);
+	const MathOperation *const exponent =
+		&block->operations[op->arguments[1]];
+	number_t br[MATH_BLOCK], bi[MATH_BLOCK];
+	number_t cr[MATH_BLOCK], ci[MATH_BLOCK];
+
+	switch (system) {
+	case SYSTEM_EXP:
+		complex_exp(ctx, yr, yi, ar[0], ai[0], count);
+		break;
+	case SYSTEM_POW:
+		if (exponent->type == GROUP_NUMBER &&
+				floorl(exponent->value) == exponent->value &&
+				fabsl(exponent->value) <= COMPLEX_MAX_POWER) {
+			complex_integerpow(yr, yi, ar[0], ai[0],
+					exponent->value, count);
+			break;
+		}
+		complex_pow(ctx, yr, yi, ar[0], ai[0], ar[1], ai[1], count);
+		break;
+	case SYSTEM_SQRT:
+		complex_sqrt(ctx, yr, yi, ar[0], ai[0], count);
+		break;
+	case SYSTEM_ROOT:
+		/* x^(1/n) */
+		for (size_t i = 0; i < count; i++) {
+			cr[i] = 1;
+			ci[i] = 0;
+		}
+		complex_divide(br, bi, cr, ci, ar[0], ai[0], count);
+		complex_pow(ctx, yr, yi, ar[1], ai[1], br, bi, count);
+		break;
+	case SYSTEM_LOG10:
+		complex_ln(ctx, yr, yi, ar[0], ai[0], count);
+		for (size_t i = 0; i < count; i++) {
+			yr[i] /= logl(10);
+			yi[i] /= logl(10);
+		}
+		break;
+	case SYSTEM_LOG:
+		complex_ln(ctx, br, bi, ar[1], ai[1], count);
+		complex_ln(ctx, cr, ci, ar[0], ai[0], count);
+		complex_divide(yr, yi, br, bi, cr, ci, count);
+		break;
+	case SYSTEM_LN:
+		complex_ln(ctx, yr, yi, ar[0], ai[0], count);
+		break;
+	case SYSTEM_SIN:
+	case SYSTEM_COS:
+	case SYSTEM_TAN:
+	case SYSTEM_COT:
+	case SYSTEM_SEC:
+	case SYSTEM_CSC:
+		complex_circular(ctx, system, yr, yi, ar[0], ai[0], count);
+		break;
+	case SYSTEM_SINH:
+	case SYSTEM_COSH:
+	case SYSTEM_TANH:
+		complex_hyperbolic(ctx, system, yr, yi, ar[0], ai[0], count);
+		break;
+	default:
+		complex_fallback(ctx, op, yr, yi, ar, ai, count);
+	}
+}
+
+/* computes a real series for every sample, NaN where the bounds or
+ * parameters are not real
+ */
+static void complex_series(MathContext *ctx, const MathOperation *op,
+		number_t *restrict yr, number_t *restrict yi,
+		const number_t *const ar[], const number_t *const ai[],
+		size_t count)
+{
+	const size_t index = op->group->arguments[0]->index;
+	number_t outer[index + 1];
+	bool real;
+
+	for (size_t i = 0; i < count; i++) {
+		real = true;
+		for (size_t p = 0; p < index + 2; p++)
+			real &= ai[p][i] == 0;
+		for (size_t p = 0; p < index; p++)
+			outer[p] = ar[p + 2][i];
+		yr[i] = real ? math_computeseries(ctx, op->group, ar[0][i],
+				ar[1][i], outer) : NAN;
+		yi[i] = 0;
+	}
+}
+
+/* computes all functions for count <= MATH_BLOCK complex samples, the
+ * real part of parameter i of sample j is re[i][j] and the imaginary
+ * part im[i][j]; im or im[i] may be NULL for real parameters
+ */
+bool math_computecomplexblock(MathContext *ctx, MathBlock *block,
+		const number_t *const *re, const number_t *const *im,
+		size_t count)
+{
+	const size_t numValues = block->numOperations * 2 * MATH_BLOCK;
+
+	if (numValues > block->numValues) {
+		number_t *const newValues = realloc(block->values,
+				sizeof(*block->values) * numValues);
+		if (newValues == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return false;
+		}
+		block->values = newValues;
+		block->numValues = numValues;
+	}
+	block->complex = true;
+	for (size_t o = 0; o < block->numOperations; o++) {
+		const MathOperation *const op = &block->operations[o];
+		number_t *restrict const yr =
+			&block->values[o * 2 * MATH_BLOCK];
+		number_t *restrict const yi = yr + MATH_BLOCK;
+		const number_t *ar[MATH_OPERATION_ARGUMENTS];
+		const number_t *ai[MATH_OPERATION_ARGUMENTS];
+
+		for (size_t i = 0; i < MATH_OPERATION_ARGUMENTS; i++) {
+			ar[i] = &block->values[op->arguments[i] * 2 *
+				MATH_BLOCK];
+			ai[i] = ar[i] + MATH_BLOCK;
+		}
+
+		switch (op->type) {
+		case GROUP_NUMBER:
+			for (size_t i = 0; i < count; i++) {
+				yr[i] = op->value;
+				yi[i] = 0;
+			}
+			break;
+		case GROUP_PARAMETER:
+			memcpy(yr, re[op->index], sizeof(*yr) * count);
+			if (im != NULL && im[op->index] != NULL)
+				memcpy(yi, im[op->index], sizeof(*yi) * count);
+			else
+				memset(yi, 0, sizeof(*yi) * count);
+			break;
+		case GROUP_LIST: {
+			const MathList *const list = &block->leaves[op->index];
+
+			for (size_t i = 0; i < count; i++) {
+				yr[i] = list->values != NULL ?
+					list->values[block->offset + i] :
+					list->first +
+					(number_t) (block->offset + i);
+				yi[i] = 0;
+			}
+			break;
+		}
+		case GROUP_NEGATE:
+			for (size_t i = 0; i < count; i++) {
+				yr[i] = -ar[0][i];
+				yi[i] = -ai[0][i];
+			}
+			break;
+		case GROUP_CALL:
+			complex_call(ctx, block, op, yr, yi, ar, ai, count);
+			break;
+		case GROUP_SUM:
+		case GROUP_PRODUCT:
+		case GROUP_INTEGRAL:
+			complex_series(ctx, op, yr, yi, ar, ai, count);
+			break;
+		case GROUP_ADD:
+			for (size_t i = 0; i < count; i++) {
+				yr[i] = ar[0][i] + ar[1][i];
+				yi[i] = ai[0][i] + ai[1][i];
+			}
+			break;
+		case GROUP_SUBTRACT:
+			for (size_t i = 0; i < count; i++) {
+				yr[i] = ar[0][i] - ar[1][i];
+				yi[i] = ai[0][i] - ai[1][i];
+			}
+			break;
+		case GROUP_MULTIPLY:
+			complex_multiply(yr, yi, ar[0], ai[0], ar[1], ai[1],
+					count);
+			break;
+		case GROUP_DIVIDE:
+			complex_divide(yr, yi, ar[0], ai[0], ar[1], ai[1],
+					count);
+			break;
+		case GROUP_MOD:
+		case GROUP_AND:
+		case GROUP_OR:
+		case GROUP_XOR:
+			/* like math_computeblock(), only of real values */
+			for (size_t i = 0; i < count; i++) {
+				const number_t a = ar[0][i], b = ar[1][i];
+
+				yr[i] = ai[0][i] != 0 || ai[1][i] != 0 ? NAN :
+					op->type == GROUP_MOD ?
+					a - b * floorl(a / b) :
+					op->type == GROUP_AND ?
+					(a != 0) & (b != 0) :
+					op->type == GROUP_OR ?
+					(a != 0) | (b != 0) :
+					(a != 0) ^ (b != 0);
+				yi[i] = 0;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+/* the imaginary parts of a function after math_computecomplexblock() */
+const number_t *math_blockimaginary(const MathBlock *block, size_t result)
+{
+	return math_blockresult(block, result) + MATH_BLOCK;
+}
@@ -0,0 +1,722 @@
+#include "cake.h"
+
+/* the derivatives of the parameters of the function whose body is
+ * computed, next to their values in the locals of its frame
+ */
+struct dual_frame {
+	const number_t *derivatives;
+	size_t numParameters;
+};
+
+static MathDual dual_group(MathContext *ctx, const MathGroup *group,
+		const struct dual_frame *frame);
+
+/* applies the function to dual arguments by the chain rule */
+static MathDual dual_apply(MathContext *ctx, const MathFunction *func,
+		const MathDual *args)
+{
+	number_t (*funcSingle)(MathContext *ctx, number_t);
+	number_t (*funcDouble)(MathContext *ctx, number_t, number_t);
+	MathDual result = { 0, 0 };
+	number_t derivatives[func->numParameters + 1];
+	struct dual_frame body;
+	size_t frame;
+
+	switch (math_systemof(func)) {
+	case SYSTEM_NONE:
+		break;
+	case SYSTEM_POW:
+		result.value = powl(args[0].value, args[1].value);
+		if (args[0].derivative != 0)
+			result.derivative += args[1].value *
+				powl(args[0].value, args[1].value - 1) *
+				args[0].derivative;
+		if (args[1].derivative != 0)
+			result.derivative += result.value *
+				logl(args[0].value) * args[1].derivative;
+		return result;
+	case SYSTEM_ROOT:
+		funcDouble = func->system;
+		result.value = (*funcDouble)(ctx, args[0].value, args[1].value);
+		if (args[1].derivative != 0)
+			result.derivative += result.value /
+				(args[0].value * args[1].value) *
+				args[1].derivative;
+		/* an odd root of a negative number is real, see
+		 * derive_call()
+		 */
+		if (args[0].derivative != 0)
+			result.derivative -= result.value *
+				logl(fabsl(args[1].value)) /
+				(args[0].value * args[0].value) *
+				args[0].derivative;
+		return result;
+	case SYSTEM_LOG:
+		funcDouble = func->system;
+		result.value = (*funcDouble)(ctx, args[0].value, args[1].value);
+		if (args[1].derivative != 0)
+			result.derivative += args[1].derivative /
+				(args[1].value * logl(args[0].value));
+		if (args[0].derivative != 0)
+			result.derivative -= result.value * args[0].derivative /
+				(args[0].value * logl(args[0].value));
+		return result;
+	default:
+		funcSingle = func->system;
+		result.value = (*funcSingle)(ctx, args[0].value);
+		if (args[0].derivative != 0) {
+			funcSingle = func->derivative;
+			result.derivative = (*funcSingle)(ctx, args[0].value) *
+				args[0].derivative;
+		}
+		return result;
+	}
+
+	/* user function, the body is computed once with the values of
+	 * the arguments as its locals and their derivatives next to them
+	 */
+	if (ctx->depth == MATH_MAX_DEPTH) {
+		math_seterror(ctx, MATH_RECURSIVE, 0);
+		return (MathDual) { NAN, NAN };
+	}
+	for (size_t i = 0; i < func->numParameters; i++) {
+		if (math_pushlocal(ctx, args[i].value) == (size_t) -1) {
+			ctx->numLocals -= i;
+			return (MathDual) { NAN, NAN };
+		}
+		derivatives[i] = args[i].derivative;
+	}
+	body = (struct dual_frame) { derivatives, func->numParameters };
+	frame = ctx->frame;
+	ctx->frame = ctx->numLocals - func->numParameters;
+	ctx->depth++;
+	result = dual_group(ctx, func->group, &body);
+	ctx->depth--;
+	ctx->frame = frame;
+	ctx->numLocals -= func->numParameters;
+	return result;
+}
+
+/* whether the group depends on a parameter whose derivative is not 0 */
+static bool dual_varies(const MathGroup *group,
+		const struct dual_frame *frame)
+{
+	for (size_t i = 0; i < frame->numParameters; i++)
+		if (frame->derivatives[i] != 0 && math_references(group, i))
+			return true;
+	return false;
+}
+
+static MathDual dual_group(MathContext *ctx, const MathGroup *group,
+		const struct dual_frame *frame)
+{
+	MathDual left, right;
+
+	switch (group->type) {
+	case GROUP_NUMBER:
+		return (MathDual) { group->value, 0 };
+	case GROUP_PARAMETER:
+		return (MathDual) {
+			ctx->locals[ctx->frame + group->index],
+			frame->derivatives[group->index]
+		};
+	case GROUP_NEGATE:
+		left = dual_group(ctx, group->group, frame);
+		return (MathDual) { -left.value, -left.derivative };
+	case GROUP_CALL: {
+		MathDual args[group->numArguments];
+
+		if (group->function == NULL)
+			return (MathDual) { NAN, NAN };
+		for (size_t i = 0; i < group->numArguments; i++)
+			args[i] = dual_group(ctx, group->arguments[i], frame);
+		return dual_apply(ctx, group->function, args);
+	}
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* a series computes as a whole, see derive_series() for its
+		 * derivative
+		 */
+		return (MathDual) {
+			math_computegroup(ctx, group),
+			dual_varies(group, frame) ? NAN : 0
+		};
+	case GROUP_ADD:
+		left = dual_group(ctx, group->left, frame);
+		right = dual_group(ctx, group->right, frame);
+		return (MathDual) {
+			left.value + right.value,
+			left.derivative + right.derivative
+		};
+	case GROUP_SUBTRACT:
+	case GROUP_EQUALS:
+		left = dual_group(ctx, group->left, frame);
+		right = dual_group(ctx, group->right, frame);
+		return (MathDual) {
+			left.value - right.value,
+			left.derivative - right.derivative
+		};
+	case GROUP_MULTIPLY:
+		left = dual_group(ctx, group->left, frame);
+		right = dual_group(ctx, group->right, frame);
+		return (MathDual) {
+			left.value * right.value,
+			left.derivative * right.value +
+				left.value * right.derivative
+		};
+	case GROUP_DIVIDE:
+		left = dual_group(ctx, group->left, frame);
+		right = dual_group(ctx, group->right, frame);
+		return (MathDual) {
+			left.value / right.value,
+			(left.derivative * right.value -
+				left.value * right.derivative) /
+				(right.value * right.value)
+		};
+	case GROUP_MOD: {
+		number_t n;
+
+		left = dual_group(ctx, group->left, frame);
+		right = dual_group(ctx, group->right, frame);
+		n = floorl(left.value / right.value);
+		return (MathDual) {
+			left.value - right.value * n,
+			left.derivative - right.derivative * n
+		};
+	}
+	default:
+		return (MathDual) { math_computegroup(ctx, group), 0 };
+	}
+}
+
+/* computes the function and its derivative by the given parameter,
+ * the arguments are the top locals like for math_computefunction()
+ */
+MathDual math_computedual(MathContext *ctx, const MathFunction *func,
+		size_t parameter)
+{
+	const number_t *const locals =
+		&ctx->locals[ctx->numLocals - func->numParameters];
+	MathDual args[func->numParameters + 1];
+	number_t derivatives[func->numParameters + 1];
+	struct dual_frame body;
+	MathDual result;
+	size_t frame;
+
+	for (size_t i = 0; i < func->numParameters; i++) {
+		args[i] = (MathDual) { locals[i], i == parameter };
+		derivatives[i] = i == parameter;
+	}
+	if (func->group == NULL)
+		return dual_apply(ctx, func, args);
+	body = (struct dual_frame) { derivatives, func->numParameters };
+	frame = ctx->frame;
+	ctx->frame = ctx->numLocals - func->numParameters;
+	result = dual_group(ctx, func->group, &body);
+	ctx->frame = frame;
+	return result;
+}
+
+static MathGroup *make_number(MathContext *ctx, number_t value)
+{
+	MathGroup *group;
+
+	group = malloc(sizeof(*group));
+	if (group == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	group->type = GROUP_NUMBER;
+	group->value = value;
+	return group;
+}
+
+static bool is_number(const MathGroup *group, number_t value)
+{
+	return group->type == GROUP_NUMBER && group->value == value;
+}
+
+static MathGroup *make_negate(MathContext *ctx, MathGroup *operand)
+{
+	MathGroup *group;
+
+	if (operand == NULL)
+		return NULL;
+	if (operand->type == GROUP_NUMBER) {
+		operand->value = -operand->value;
+		return operand;
+	}
+	if (operand->type == GROUP_NEGATE) {
+		group = operand->group;
+		free(operand);
+		return group;
+	}
+	group = malloc(sizeof(*group));
+	if (group == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		math_freegroup(ctx, operand);
+		return NULL;
+	}
+	group->type = GROUP_NEGATE;
+	group->group = operand;
+	return group;
+}
+
+/* builds `left type right`, folding the neutral and absorbing numbers
+ * so the derivatives of polynomials stay small; frees the operands on
+ * failure
+ */
+static MathGroup *make_binary(MathContext *ctx, enum math_group_type type,
+		MathGroup *left, MathGroup *right)
+{
+	MathGroup *group;
+
+	if (left == NULL || right == NULL) {
+		math_freegroup(ctx, left);
+		math_freegroup(ctx, right);
+		return NULL;
+	}
+	if (left->type == GROUP_NUMBER && right->type == GROUP_NUMBER &&
+			type >= GROUP_ADD && type <= GROUP_DIVIDE) {
+		switch (type) {
+		case GROUP_ADD:
+			left->value += right->value;
+			break;
+		case GROUP_SUBTRACT:
+			left->value -= right->value;
+			break;
+		case GROUP_MULTIPLY:
+			left->value *= right->value;
+			break;
+		default:
+			left->value /= right->value;
+		}
+		free(right);
+		return left;
+	}
+	switch (type) {
+	case GROUP_ADD:
+		if (is_number(left, 0)) {
+			free(left);
+			return right;
+		}
+		/* fall through */
+	case GROUP_SUBTRACT:
+		if (is_number(right, 0)) {
+			free(right);
+			return left;
+		}
+		if (is_number(left, 0)) {
+			free(left);
+			return make_negate(ctx, right);
+		}
+		break;
+	case GROUP_MULTIPLY:
+		if (is_number(left, 0) || is_number(right, 0)) {
+			math_freegroup(ctx, left);
+			math_freegroup(ctx, right);
+			return make_number(ctx, 0);
+		}
+		if (is_number(left, 1)) {
+			free(left);
+			return right;
+		}
+		/* fall through */
+	case GROUP_DIVIDE:
+		if (is_number(right, 1)) {
+			free(right);
+			return left;
+		}
+		if (is_number(left, 0)) {
+			math_freegroup(ctx, right);
+			return left;
+		}
+		break;
+	default:
+		break;
+	}
+	group = malloc(sizeof(*group));
+	if (group == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		math_freegroup(ctx, left);
+		math_freegroup(ctx, right);
+		return NULL;
+	}
+	group->type = type;
+	group->left = left;
+	group->right = right;
+	return group;
+}
+
+static MathGroup *make_call(MathContext *ctx, enum math_system system,
+		MathGroup *first, MathGroup *second)
+{
+	MathFunction *const func = math_systemfunction(system);
+	MathGroup *group;
+
+	if (first == NULL || (func->numParameters == 2 && second == NULL))
+		goto err;
+	group = malloc(sizeof(*group));
+	if (group == NULL)
+		goto err;
+	group->type = GROUP_CALL;
+	group->function = func;
+	group->callee[0] = '\0';
+	group->numArguments = func->numParameters;
+	group->arguments = malloc(sizeof(*group->arguments) *
+			group->numArguments);
+	if (group->arguments == NULL) {
+		free(group);
+		goto err;
+	}
+	group->arguments[0] = first;
+	if (func->numParameters == 2)
+		group->arguments[1] = second;
+	return group;
+
+err:
+	math_seterror(ctx, MATH_MEMORY, errno);
+	math_freegroup(ctx, first);
+	math_freegroup(ctx, second);
+	return NULL;
+}
+
+#define NUM(v) make_number(ctx, (v))
+#define NEG(a) make_negate(ctx, (a))
+#define ADD(a, b) make_binary(ctx, GROUP_ADD, (a), (b))
+#define SUB(a, b) make_binary(ctx, GROUP_SUBTRACT, (a), (b))
+#define MUL(a, b) make_binary(ctx, GROUP_MULTIPLY, (a), (b))
+#define DIV(a, b) make_binary(ctx, GROUP_DIVIDE, (a), (b))
+#define CALL(s, a) make_call(ctx, SYSTEM_##s, (a), NULL)
+#define CALL2(s, a, b) make_call(ctx, SYSTEM_##s, (a), (b))
+#define COPY(a) math_copygroup(ctx, (a))
+
+/* the derivative of a single parameter system function at u */
+static MathGroup *derive_system(MathContext *ctx, enum math_system system,
+		const MathGroup *u)
+{
+	switch (system) {
+	case SYSTEM_FLOOR:
+	case SYSTEM_CEIL:
+		return NUM(0);
+	case SYSTEM_EXP:
+		return CALL(EXP, COPY(u));
+	case SYSTEM_ERFC:
+		return MUL(NUM(-2 / sqrtl(M_PI)),
+				CALL(EXP, NEG(MUL(COPY(u), COPY(u)))));
+	case SYSTEM_SQRT:
+		return DIV(NUM(1), MUL(NUM(2), CALL(SQRT, COPY(u))));
+	case SYSTEM_CBRT:
+		return DIV(NUM(1), MUL(NUM(3),
+				MUL(CALL(CBRT, COPY(u)), CALL(CBRT, COPY(u)))));
+	case SYSTEM_LOG10:
+		return DIV(NUM(1), MUL(COPY(u), NUM(logl(10))));
+	case SYSTEM_LN:
+		return DIV(NUM(1), COPY(u));
+	case SYSTEM_SIN:
+		return CALL(COS, COPY(u));
+	case SYSTEM_COS:
+		return NEG(CALL(SIN, COPY(u)));
+	case SYSTEM_TAN:
+		return DIV(NUM(1), MUL(CALL(COS, COPY(u)), CALL(COS, COPY(u))));
+	case SYSTEM_COT:
+		return NEG(DIV(NUM(1),
+				MUL(CALL(SIN, COPY(u)), CALL(SIN, COPY(u)))));
+	case SYSTEM_SEC:
+		return MUL(CALL(TAN, COPY(u)), CALL(SEC, COPY(u)));
+	case SYSTEM_CSC:
+		return NEG(MUL(CALL(COT, COPY(u)), CALL(CSC, COPY(u))));
+	case SYSTEM_SINH:
+		return CALL(COSH, COPY(u));
+	case SYSTEM_COSH:
+		return CALL(SINH, COPY(u));
+	case SYSTEM_TANH:
+		return DIV(NUM(1),
+				MUL(CALL(COSH, COPY(u)), CALL(COSH, COPY(u))));
+	case SYSTEM_ASINH:
+		return DIV(NUM(1),
+				CALL(SQRT, ADD(MUL(COPY(u), COPY(u)), NUM(1))));
+	case SYSTEM_ACOSH:
+		return DIV(NUM(1),
+				CALL(SQRT, SUB(MUL(COPY(u), COPY(u)), NUM(1))));
+	case SYSTEM_ATANH:
+		return DIV(NUM(1), SUB(NUM(1), MUL(COPY(u), COPY(u))));
+	case SYSTEM_GAMMA:
+		return MUL(CALL(GAMMA, COPY(u)), CALL(DIGAMMA, COPY(u)));
+	default:
+		/* there is no trigamma to call */
+		math_seterror(ctx, MATH_INVALID_CALL, 0);
+		return NULL;
+	}
+}
+
+/* copies the group with every parameter replaced by its argument; the
+ * name of a series would need a parameter index of where the copy goes,
+ * so series become NaN
+ */
+static MathGroup *substitute(MathContext *ctx, const MathGroup *group,
+		MathGroup *const *args)
+{
+	MathGroup *copy;
+
+	switch (group->type) {
+	case GROUP_PARAMETER:
+		return COPY(args[group->index]);
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		return NUM(NAN);
+	case GROUP_NEGATE:
+		return NEG(substitute(ctx, group->group, args));
+	case GROUP_CALL:
+	case GROUP_LIST:
+		copy = malloc(sizeof(*copy));
+		if (copy == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return NULL;
+		}
+		*copy = *group;
+		copy->arguments = calloc(group->numArguments,
+				sizeof(*copy->arguments));
+		if (copy->arguments == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			free(copy);
+			return NULL;
+		}
+		for (size_t i = 0; i < copy->numArguments; i++) {
+			copy->arguments[i] = substitute(ctx,
+					group->arguments[i], args);
+			if (copy->arguments[i] == NULL) {
+				math_freegroup(ctx, copy);
+				return NULL;
+			}
+		}
+		return copy;
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_GLOBAL:
+		return COPY(group);
+	default:
+		return make_binary(ctx, group->type,
+				substitute(ctx, group->left, args),
+				substitute(ctx, group->right, args));
+	}
+}
+
+/* the series with another body, frees the body on failure */
+static MathGroup *make_series(MathContext *ctx, enum math_group_type type,
+		const MathGroup *series, MathGroup *body)
+{
+	MathGroup *group;
+
+	if (body == NULL)
+		return NULL;
+	group = math_copygroup(ctx, series);
+	if (group == NULL) {
+		math_freegroup(ctx, body);
+		return NULL;
+	}
+	group->type = type;
+	math_freegroup(ctx, group->arguments[3]);
+	group->arguments[3] = body;
+	return group;
+}
+
+/* the body of the series with its name replaced by the value */
+static MathGroup *derive_at(MathContext *ctx, const MathGroup *group,
+		const MathGroup *value)
+{
+	const size_t index = group->arguments[0]->index;
+	MathGroup parameters[index + 1];
+	MathGroup *args[index + 1];
+
+	for (size_t i = 0; i < index; i++) {
+		parameters[i].type = GROUP_PARAMETER;
+		parameters[i].name[0] = '\0';
+		parameters[i].index = i;
+		args[i] = &parameters[i];
+	}
+	args[index] = (MathGroup *) value;
+	return substitute(ctx, group->arguments[3], args);
+}
+
+/* the bounds of sums and products step, so only the terms change; the
+ * bounds of an integral add the body at them
+ */
+static MathGroup *derive_series(MathContext *ctx, const MathGroup *group,
+		size_t parameter)
+{
+	MathGroup *const *const args = group->arguments;
+
+	if (!math_references(group, parameter))
+		return NUM(0);
+	switch (group->type) {
+	case GROUP_SUM:
+		return make_series(ctx, GROUP_SUM, group,
+				math_derivegroup(ctx, args[3], parameter));
+	case GROUP_PRODUCT:
+		/* prod(f) * sum(f' / f) */
+		return MUL(COPY(group), make_series(ctx, GROUP_SUM, group,
+				DIV(math_derivegroup(ctx, args[3], parameter),
+					COPY(args[3]))));
+	default:
+		return ADD(make_series(ctx, GROUP_INTEGRAL, group,
+				math_derivegroup(ctx, args[3], parameter)),
+			SUB(MUL(derive_at(ctx, group, args[2]),
+					math_derivegroup(ctx, args[2],
+						parameter)),
+				MUL(derive_at(ctx, group, args[1]),
+					math_derivegroup(ctx, args[1],
+						parameter))));
+	}
+}
+
+static MathGroup *derive_call(MathContext *ctx, const MathGroup *group,
+		size_t parameter)
+{
+	MathGroup *const *const args = group->arguments;
+	const MathFunction *const func = group->function;
+	enum math_system system;
+	MathGroup *result, *body;
+
+	if (func == NULL) {
+		math_seterror(ctx, MATH_UNDEFINED, 0);
+		return NULL;
+	}
+	system = math_systemof(func);
+	switch (system) {
+	case SYSTEM_POW:
+		if (!math_references(args[1], parameter))
+			return MUL(MUL(COPY(args[1]), CALL2(POW, COPY(args[0]),
+						SUB(COPY(args[1]), NUM(1)))),
+					math_derivegroup(ctx, args[0],
+						parameter));
+		return MUL(CALL2(POW, COPY(args[0]), COPY(args[1])),
+			ADD(MUL(math_derivegroup(ctx, args[1], parameter),
+					CALL(LN, COPY(args[0]))),
+				DIV(MUL(COPY(args[1]),
+					math_derivegroup(ctx, args[0],
+						parameter)),
+					COPY(args[0]))));
+	case SYSTEM_ROOT:
+		/* an odd root of a negative number is real, so ln|x| is
+		 * written as ln(x * x) / 2
+		 */
+		return MUL(CALL2(ROOT, COPY(args[0]), COPY(args[1])),
+			SUB(DIV(math_derivegroup(ctx, args[1], parameter),
+					MUL(COPY(args[0]), COPY(args[1]))),
+				DIV(MUL(DIV(CALL(LN, MUL(COPY(args[1]),
+							COPY(args[1]))),
+						NUM(2)),
+					math_derivegroup(ctx, args[0],
+						parameter)),
+					MUL(COPY(args[0]), COPY(args[0])))));
+	case SYSTEM_LOG:
+		return SUB(DIV(math_derivegroup(ctx, args[1], parameter),
+				MUL(COPY(args[1]), CALL(LN, COPY(args[0])))),
+			DIV(MUL(CALL2(LOG, COPY(args[0]), COPY(args[1])),
+					math_derivegroup(ctx, args[0],
+						parameter)),
+				MUL(COPY(args[0]), CALL(LN, COPY(args[0])))));
+	case SYSTEM_NONE:
+		break;
+	default:
+		if (!math_references(args[0], parameter))
+			return NUM(0);
+		return MUL(derive_system(ctx, system, args[0]),
+			math_derivegroup(ctx, args[0], parameter));
+	}
+
+	/* user function: the sum of the partial derivatives of the body
+	 * with the arguments put in, each times the argument derivative
+	 */
+	if (ctx->depth == MATH_MAX_DEPTH) {
+		math_seterror(ctx, MATH_RECURSIVE, 0);
+		return NULL;
+	}
+	ctx->depth++;
+	result = NUM(0);
+	for (size_t i = 0; i < func->numParameters && result != NULL; i++) {
+		if (!math_references(args[i], parameter))
+			continue;
+		body = math_derivegroup(ctx, func->group, i);
+		if (body == NULL) {
+			math_freegroup(ctx, result);
+			result = NULL;
+			break;
+		}
+		result = ADD(result, MUL(substitute(ctx, body, args),
+				math_derivegroup(ctx, args[i], parameter)));
+		math_freegroup(ctx, body);
+	}
+	ctx->depth--;
+	return result;
+}
+
+/* symbolic derivative of a bound group by one of its parameters */
+MathGroup *math_derivegroup(MathContext *ctx, const MathGroup *group,
+		size_t parameter)
+{
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_GLOBAL:
+		return NUM(0);
+	case GROUP_PARAMETER:
+		return NUM(group->index == parameter);
+	case GROUP_NEGATE:
+		return NEG(math_derivegroup(ctx, group->group, parameter));
+	case GROUP_CALL:
+		return derive_call(ctx, group, parameter);
+	case GROUP_LIST:
+	case GROUP_RANGE:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* computes as NaN */
+		return NUM(NAN);
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+		if (group->arguments[0]->type != GROUP_PARAMETER)
+			return NUM(NAN);
+		return derive_series(ctx, group, parameter);
+	case GROUP_ADD:
+		return ADD(math_derivegroup(ctx, group->left, parameter),
+			math_derivegroup(ctx, group->right, parameter));
+	case GROUP_SUBTRACT:
+	case GROUP_EQUALS:
+		return SUB(math_derivegroup(ctx, group->left, parameter),
+			math_derivegroup(ctx, group->right, parameter));
+	case GROUP_MULTIPLY:
+		return ADD(MUL(math_derivegroup(ctx, group->left, parameter),
+				COPY(group->right)),
+			MUL(COPY(group->left),
+				math_derivegroup(ctx, group->right,
+					parameter)));
+	case GROUP_DIVIDE:
+		return DIV(SUB(MUL(math_derivegroup(ctx, group->left,
+						parameter),
+					COPY(group->right)),
+				MUL(COPY(group->left),
+					math_derivegroup(ctx, group->right,
+						parameter))),
+			MUL(COPY(group->right), COPY(group->right)));
+	case GROUP_MOD:
+		/* left - right * floor(left / right) */
+		return SUB(math_derivegroup(ctx, group->left, parameter),
+			MUL(math_derivegroup(ctx, group->right, parameter),
+				CALL(FLOOR, DIV(COPY(group->left),
+						COPY(group->right)))));
+	default:
+		/* the logic operators are flat almost everywhere */
+		return NUM(0);
+	}
+}
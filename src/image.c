@@ -0,0 +1,980 @@
+#include "cake.h"
+
+/* sections are aligned for the numbers they may hold */
+#define IMAGE_ALIGN 16
+
+/* a growing section of the file while it is written */
+struct image_array {
+	void *data;
+	size_t count, max;
+};
+
+struct image_writer {
+	MathContext *ctx;
+	const MathProgram *program;
+	struct image_array nodes;
+	struct image_array constants;
+	struct image_array arguments;
+	struct image_array dependencies;
+	struct image_array strings;
+};
+
+/* appends count elements and returns the index of the first */
+static uint32_t image_append(MathContext *ctx, struct image_array *array,
+		const void *values, size_t count, size_t size)
+{
+	void *newData;
+	size_t newMax;
+
+	if (array->count + count > array->max) {
+		newMax = MAX(array->max * 2, array->count + count);
+		/* the offsets and indices of the file are 32 bit */
+		if (newMax > UINT32_MAX / size) {
+			math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+			return -1;
+		}
+		newData = realloc(array->data, newMax * size);
+		if (newData == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return -1;
+		}
+		array->data = newData;
+		array->max = newMax;
+	}
+	memcpy((char *) array->data + array->count * size, values,
+			count * size);
+	array->count += count;
+	return array->count - count;
+}
+
+static uint32_t image_addstring(struct image_writer *writer, const char *str)
+{
+	return image_append(writer->ctx, &writer->strings, str,
+			strlen(str) + 1, 1);
+}
+
+static uint32_t image_addconstant(struct image_writer *writer, number_t value)
+{
+	return image_append(writer->ctx, &writer->constants, &value, 1,
+			sizeof(value));
+}
+
+/* appends the nodes of the group, constant parts folded into numbers */
+static uint32_t image_addnode(struct image_writer *writer,
+		const MathGroup *group)
+{
+	MathNode node;
+
+	memset(&node, 0, sizeof(node));
+	node.type = group->type;
+	if (group->type != GROUP_NUMBER && math_isconstant(group)) {
+		node.type = GROUP_NUMBER;
+		node.a = image_addconstant(writer,
+				math_computegroup(writer->ctx, group));
+		if (node.a == (uint32_t) -1)
+			return -1;
+		return image_append(writer->ctx, &writer->nodes, &node, 1,
+				sizeof(node));
+	}
+	switch (group->type) {
+	case GROUP_NUMBER:
+		node.a = image_addconstant(writer, group->value);
+		if (node.a == (uint32_t) -1)
+			return -1;
+		break;
+	case GROUP_PARAMETER:
+	case GROUP_GLOBAL:
+		node.a = group->index;
+		break;
+	case GROUP_NEGATE:
+		node.a = image_addnode(writer, group->group);
+		if (node.a == (uint32_t) -1)
+			return -1;
+		break;
+	case GROUP_CALL: {
+		uint32_t args[group->numArguments];
+
+		if (group->function == NULL) {
+			/* unresolved, computes as NaN like the name */
+			node.type = GROUP_VARIABLE;
+			break;
+		}
+		for (size_t i = 0; i < group->numArguments; i++) {
+			args[i] = image_addnode(writer, group->arguments[i]);
+			if (args[i] == (uint32_t) -1)
+				return -1;
+		}
+		node.b = image_append(writer->ctx, &writer->arguments, args,
+				group->numArguments, sizeof(*args));
+		if (node.b == (uint32_t) -1)
+			return -1;
+		node.numArguments = group->numArguments;
+		node.a = math_systemof(group->function);
+		if (node.a == SYSTEM_NONE)
+			node.a = SYSTEM_MAX + (group->function -
+					writer->program->functions);
+		break;
+	}
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL: {
+		/* the bounds and the body */
+		uint32_t args[3];
+
+		if (group->arguments[0]->type != GROUP_PARAMETER) {
+			node.type = GROUP_VARIABLE;
+			break;
+		}
+		for (size_t i = 0; i < ARRLEN(args); i++) {
+			args[i] = image_addnode(writer, group->arguments[i + 1]);
+			if (args[i] == (uint32_t) -1)
+				return -1;
+		}
+		node.b = image_append(writer->ctx, &writer->arguments, args,
+				ARRLEN(args), sizeof(*args));
+		if (node.b == (uint32_t) -1)
+			return -1;
+		node.numArguments = ARRLEN(args);
+		node.a = group->arguments[0]->index;
+		break;
+	}
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* a list, curve or complex body computes as NaN */
+		node.type = GROUP_VARIABLE;
+		break;
+	default:
+		node.a = image_addnode(writer, group->left);
+		if (node.a == (uint32_t) -1)
+			return -1;
+		node.b = image_addnode(writer, group->right);
+		if (node.b == (uint32_t) -1)
+			return -1;
+	}
+	return image_append(writer->ctx, &writer->nodes, &node, 1,
+			sizeof(node));
+}
+
+/* appends the variables and functions the group refers to directly,
+ * each once after first
+ */
+static bool image_adddependencies(struct image_writer *writer,
+		const MathGroup *group, size_t first)
+{
+	uint32_t dependency;
+
+	switch (group->type) {
+	case GROUP_GLOBAL:
+		dependency = group->index;
+		break;
+	case GROUP_NEGATE:
+		return image_adddependencies(writer, group->group, first);
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (!image_adddependencies(writer,
+						group->arguments[i], first))
+				return false;
+		if (group->type != GROUP_CALL || group->function == NULL ||
+				math_systemof(group->function) != SYSTEM_NONE)
+			return true;
+		dependency = writer->program->numVariables +
+			(group->function - writer->program->functions);
+		break;
+	case GROUP_NULL:
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_LIST:
+	case GROUP_RANGE:
+		return true;
+	default:
+		return image_adddependencies(writer, group->left, first) &&
+			image_adddependencies(writer, group->right, first);
+	}
+	for (size_t i = first; i < writer->dependencies.count; i++)
+		if (((uint32_t *) writer->dependencies.data)[i] == dependency)
+			return true;
+	return image_append(writer->ctx, &writer->dependencies, &dependency,
+			1, sizeof(dependency)) != (uint32_t) -1;
+}
+
+static bool image_writesection(FILE *fp, const void *data, size_t size,
+		uint32_t *offset, size_t *position)
+{
+	static const char padding[IMAGE_ALIGN];
+	const size_t pad = (IMAGE_ALIGN - *position % IMAGE_ALIGN) %
+		IMAGE_ALIGN;
+
+	if (fwrite(padding, 1, pad, fp) != pad)
+		return false;
+	*position += pad;
+	if (*position > UINT32_MAX)
+		return false;
+	*offset = *position;
+	if (size > 0 && fwrite(data, 1, size, fp) != size)
+		return false;
+	*position += size;
+	return true;
+}
+
+/* writes the bound program, its variables with their computed values */
+bool math_writeimage(MathContext *ctx, const MathProgram *program, FILE *fp)
+{
+	const MathProgram *const oldProgram = ctx->program;
+	struct image_writer writer;
+	MathImageHeader header;
+	MathImageVariable *variables = NULL;
+	MathImageFunction *functions = NULL;
+	size_t position;
+	bool success = false;
+
+	memset(&writer, 0, sizeof(writer));
+	writer.ctx = ctx;
+	writer.program = program;
+	ctx->program = program;
+	ctx->frame = ctx->numLocals;
+	variables = calloc(program->numVariables, sizeof(*variables));
+	functions = calloc(program->numFunctions, sizeof(*functions));
+	if ((variables == NULL && program->numVariables > 0) ||
+			(functions == NULL && program->numFunctions > 0)) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		goto end;
+	}
+	/* the strings are never empty so the last one always ends */
+	if (image_addstring(&writer, "") == (uint32_t) -1)
+		goto end;
+
+	for (size_t i = 0; i < program->numVariables; i++) {
+		const MathVariable *const var = &program->variables[i];
+		MathImageVariable *const out = &variables[i];
+
+		out->value = var->value;
+		out->name = image_addstring(&writer, var->name);
+		out->node = image_addnode(&writer, var->group);
+		out->dependencies = writer.dependencies.count;
+		if (out->name == (uint32_t) -1 || out->node == (uint32_t) -1 ||
+				!image_adddependencies(&writer, var->group,
+					out->dependencies))
+			goto end;
+		out->numDependencies = writer.dependencies.count -
+			out->dependencies;
+	}
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		const MathFunction *const func = &program->functions[i];
+		MathImageFunction *const out = &functions[i];
+
+		out->name = image_addstring(&writer, func->name);
+		out->parameters = writer.strings.count;
+		for (size_t p = 0; p < func->numParameters; p++)
+			if (image_addstring(&writer, func->parameters[p]) ==
+					(uint32_t) -1)
+				goto end;
+		out->numParameters = func->numParameters;
+		out->node = image_addnode(&writer, func->group);
+		out->dependencies = writer.dependencies.count;
+		if (out->name == (uint32_t) -1 || out->node == (uint32_t) -1 ||
+				!image_adddependencies(&writer, func->group,
+					out->dependencies))
+			goto end;
+		out->numDependencies = writer.dependencies.count -
+			out->dependencies;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MATH_IMAGE_MAGIC, sizeof(header.magic));
+	header.version = MATH_IMAGE_VERSION;
+	header.numberSize = sizeof(number_t);
+	header.numSystem = SYSTEM_MAX;
+	header.numNodes = writer.nodes.count;
+	header.numConstants = writer.constants.count;
+	header.numArguments = writer.arguments.count;
+	header.numVariables = program->numVariables;
+	header.numFunctions = program->numFunctions;
+	header.numDependencies = writer.dependencies.count;
+	header.stringsSize = writer.strings.count;
+
+	/* the header is written twice, the second time with the offsets */
+	for (int pass = 0; pass < 2; pass++) {
+		position = 0;
+		if (fseek(fp, 0, SEEK_SET) != 0 ||
+				fwrite(&header, sizeof(header), 1, fp) != 1)
+			goto io;
+		position = sizeof(header);
+		if (!image_writesection(fp, writer.nodes.data, sizeof(MathNode) *
+					writer.nodes.count, &header.nodes,
+					&position) ||
+				!image_writesection(fp, writer.constants.data,
+					sizeof(number_t) * writer.constants.count,
+					&header.constants, &position) ||
+				!image_writesection(fp, writer.arguments.data,
+					sizeof(uint32_t) * writer.arguments.count,
+					&header.arguments, &position) ||
+				!image_writesection(fp, variables,
+					sizeof(*variables) *
+					program->numVariables,
+					&header.variables, &position) ||
+				!image_writesection(fp, functions,
+					sizeof(*functions) *
+					program->numFunctions,
+					&header.functions, &position) ||
+				!image_writesection(fp, writer.dependencies.data,
+					sizeof(uint32_t) *
+					writer.dependencies.count,
+					&header.dependencies, &position) ||
+				!image_writesection(fp, writer.strings.data,
+					writer.strings.count, &header.strings,
+					&position))
+			goto io;
+	}
+	success = true;
+	goto end;
+
+io:
+	math_seterror(ctx, MATH_INVALID_IMAGE, errno);
+end:
+	ctx->program = oldProgram;
+	free(writer.nodes.data);
+	free(writer.constants.data);
+	free(writer.arguments.data);
+	free(writer.dependencies.data);
+	free(writer.strings.data);
+	free(variables);
+	free(functions);
+	return success;
+}
+
+static bool image_section(const MathImage *image, uint32_t offset,
+		size_t count, size_t size)
+{
+	return offset % IMAGE_ALIGN == 0 && offset <= image->size &&
+		count <= (image->size - offset) / size;
+}
+
+/* maps the file and checks its layout; the writer appends the operands
+ * before the node, so a node referring to a later one is a cycle
+ */
+bool math_mapimage(MathContext *ctx, MathImage *image, const char *path)
+{
+	const MathImageHeader *header;
+	struct stat st;
+	int fd;
+
+	memset(image, 0, sizeof(*image));
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, errno);
+		return false;
+	}
+	if (fstat(fd, &st) < 0) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, errno);
+		close(fd);
+		return false;
+	}
+	image->size = st.st_size;
+	if (image->size < sizeof(*header)) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+		close(fd);
+		return false;
+	}
+	image->data = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image->data == MAP_FAILED) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, errno);
+		image->data = NULL;
+		return false;
+	}
+
+	header = image->data;
+	if (memcmp(header->magic, MATH_IMAGE_MAGIC, sizeof(header->magic)) ||
+			header->version != MATH_IMAGE_VERSION ||
+			header->numberSize != sizeof(number_t) ||
+			header->numSystem != SYSTEM_MAX ||
+			!image_section(image, header->nodes, header->numNodes,
+				sizeof(MathNode)) ||
+			!image_section(image, header->constants,
+				header->numConstants, sizeof(number_t)) ||
+			!image_section(image, header->arguments,
+				header->numArguments, sizeof(uint32_t)) ||
+			!image_section(image, header->variables,
+				header->numVariables,
+				sizeof(MathImageVariable)) ||
+			!image_section(image, header->functions,
+				header->numFunctions,
+				sizeof(MathImageFunction)) ||
+			!image_section(image, header->dependencies,
+				header->numDependencies, sizeof(uint32_t)) ||
+			!image_section(image, header->strings,
+				header->stringsSize, 1) ||
+			header->stringsSize == 0)
+		goto err;
+
+	image->header = header;
+	image->nodes = (const void *) ((const char *) image->data +
+			header->nodes);
+	image->constants = (const void *) ((const char *) image->data +
+			header->constants);
+	image->arguments = (const void *) ((const char *) image->data +
+			header->arguments);
+	image->variables = (const void *) ((const char *) image->data +
+			header->variables);
+	image->functions = (const void *) ((const char *) image->data +
+			header->functions);
+	image->dependencies = (const void *) ((const char *) image->data +
+			header->dependencies);
+	image->strings = (const char *) image->data + header->strings;
+	if (image->strings[header->stringsSize - 1] != '\0')
+		goto err;
+
+	/* names must be inside the strings so they can be compared */
+	for (uint32_t i = 0; i < header->numVariables; i++) {
+		const MathImageVariable *const var = &image->variables[i];
+		if (var->name >= header->stringsSize ||
+				var->dependencies > header->numDependencies ||
+				var->numDependencies > header->numDependencies -
+				var->dependencies)
+			goto err;
+	}
+	for (uint32_t i = 0; i < header->numFunctions; i++) {
+		const MathImageFunction *const func = &image->functions[i];
+		if (func->name >= header->stringsSize ||
+				func->parameters > header->stringsSize ||
+				func->dependencies > header->numDependencies ||
+				func->numDependencies >
+				header->numDependencies - func->dependencies)
+			goto err;
+	}
+	for (uint32_t i = 0; i < header->numNodes; i++) {
+		const MathNode *const node = &image->nodes[i];
+
+		switch (node->type) {
+		case GROUP_NEGATE:
+			if (node->a >= i)
+				goto err;
+			break;
+		case GROUP_CALL:
+		case GROUP_SUM:
+		case GROUP_PRODUCT:
+		case GROUP_INTEGRAL:
+			if (node->b > header->numArguments ||
+					node->numArguments >
+					header->numArguments - node->b)
+				goto err;
+			for (uint32_t a = 0; a < node->numArguments; a++)
+				if (image->arguments[node->b + a] >= i)
+					goto err;
+			break;
+		case GROUP_ADD:
+		case GROUP_SUBTRACT:
+		case GROUP_EQUALS:
+		case GROUP_MULTIPLY:
+		case GROUP_DIVIDE:
+		case GROUP_MOD:
+		case GROUP_AND:
+		case GROUP_OR:
+		case GROUP_XOR:
+			if (node->a >= i || node->b >= i)
+				goto err;
+			break;
+		}
+	}
+	return true;
+
+err:
+	math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+	math_unmapimage(image);
+	return false;
+}
+
+void math_unmapimage(MathImage *image)
+{
+	if (image->data != NULL)
+		munmap(image->data, image->size);
+	memset(image, 0, sizeof(*image));
+}
+
+/* the string at the offset if it fits a name, NULL otherwise */
+static const char *image_name(const MathImage *image, uint32_t offset)
+{
+	const char *name;
+
+	if (offset >= image->header->stringsSize)
+		return NULL;
+	name = &image->strings[offset];
+	return strlen(name) < sizeof(((MathVariable *) NULL)->name) ?
+		name : NULL;
+}
+
+/* the names of the parameters after those of the function are bound by
+ * series, they are named by their index which no parsed name can be
+ */
+static void image_parametername(const MathFunction *func, uint32_t index,
+		char *name)
+{
+	if (index < func->numParameters)
+		strcpy(name, func->parameters[index]);
+	else
+		sprintf(name, "%u", (unsigned) index);
+}
+
+static MathGroup *image_group(MathContext *ctx, const MathImage *image,
+		const MathFunction *func, uint32_t index);
+
+/* the groups of the arguments of the node from first on */
+static bool image_arguments(MathContext *ctx, const MathImage *image,
+		const MathFunction *func, const MathNode *node,
+		MathGroup *group, size_t first)
+{
+	group->arguments = calloc(first + node->numArguments,
+			sizeof(*group->arguments));
+	if (group->arguments == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	group->numArguments = first + node->numArguments;
+	for (size_t i = 0; i < node->numArguments; i++) {
+		group->arguments[first + i] = image_group(ctx, image, func,
+				image->arguments[node->b + i]);
+		if (group->arguments[first + i] == NULL)
+			return false;
+	}
+	return true;
+}
+
+/* the unbound group of the node, names are resolved again on binding */
+static MathGroup *image_group(MathContext *ctx, const MathImage *image,
+		const MathFunction *func, uint32_t index)
+{
+	const MathImageHeader *const header = image->header;
+	const MathNode *node;
+	const char *name;
+	MathGroup *group;
+
+	if (index >= header->numNodes) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+		return NULL;
+	}
+	node = &image->nodes[index];
+	group = calloc(1, sizeof(*group));
+	if (group == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	group->type = node->type;
+	switch (node->type) {
+	case GROUP_NUMBER:
+		if (node->a >= header->numConstants)
+			goto err;
+		group->value = image->constants[node->a];
+		return group;
+	case GROUP_VARIABLE:
+		/* unresolved names and lists were written as NaN */
+		group->type = GROUP_NUMBER;
+		group->value = NAN;
+		return group;
+	case GROUP_PARAMETER:
+		image_parametername(func, node->a, group->name);
+		group->index = node->a;
+		return group;
+	case GROUP_GLOBAL:
+		if (node->a >= header->numVariables)
+			goto err;
+		name = image_name(image, image->variables[node->a].name);
+		if (name == NULL)
+			goto err;
+		strcpy(group->name, name);
+		group->index = node->a;
+		return group;
+	case GROUP_NEGATE:
+		group->group = image_group(ctx, image, func, node->a);
+		if (group->group == NULL)
+			goto fail;
+		return group;
+	case GROUP_CALL:
+		if (node->a < SYSTEM_MAX) {
+			group->function = math_systemfunction(node->a);
+			if (group->function->numParameters !=
+					node->numArguments)
+				goto err;
+		} else {
+			if (node->a - SYSTEM_MAX >= header->numFunctions)
+				goto err;
+			name = image_name(image,
+					image->functions[node->a -
+					SYSTEM_MAX].name);
+			if (name == NULL || name[0] == '\0' ||
+					strlen(name) >= sizeof(group->callee))
+				goto err;
+			strcpy(group->callee, name);
+		}
+		if (!image_arguments(ctx, image, func, node, group, 0))
+			goto fail;
+		return group;
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+		/* the bound name before the bounds and the body */
+		if (node->numArguments != 3)
+			goto err;
+		if (!image_arguments(ctx, image, func, node, group, 1))
+			goto fail;
+		group->arguments[0] = calloc(1, sizeof(*group->arguments[0]));
+		if (group->arguments[0] == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			goto fail;
+		}
+		group->arguments[0]->type = GROUP_PARAMETER;
+		image_parametername(func, node->a, group->arguments[0]->name);
+		group->arguments[0]->index = node->a;
+		return group;
+	case GROUP_ADD:
+	case GROUP_SUBTRACT:
+	case GROUP_EQUALS:
+	case GROUP_MULTIPLY:
+	case GROUP_DIVIDE:
+	case GROUP_MOD:
+	case GROUP_AND:
+	case GROUP_OR:
+	case GROUP_XOR:
+		group->left = image_group(ctx, image, func, node->a);
+		if (group->left == NULL)
+			goto fail;
+		group->right = image_group(ctx, image, func, node->b);
+		if (group->right == NULL)
+			goto fail;
+		return group;
+	}
+
+err:
+	math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+fail:
+	math_freegroup(ctx, group);
+	return NULL;
+}
+
+/* appends the definitions of the image to the program as if their lines
+ * were defined, the program must be bound afterwards; lists, solve,
+ * curve and ℂ were written as NaN and stay so
+ */
+bool math_loadimage(MathContext *ctx, MathProgram *program,
+		const MathImage *image)
+{
+	const MathImageHeader *const header = image->header;
+	MathVariable *newVariables;
+	MathFunction *newFunctions;
+	MathFunction constant;
+	const char *name;
+
+	/* the definitions move, nothing is remembered until bound again */
+	program->generation = 0;
+	newVariables = realloc(program->variables,
+			sizeof(*program->variables) *
+			(program->numVariables + header->numVariables));
+	if (newVariables == NULL && program->numVariables +
+			header->numVariables > 0) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	program->variables = newVariables;
+	newFunctions = realloc(program->functions,
+			sizeof(*program->functions) *
+			(program->numFunctions + header->numFunctions));
+	if (newFunctions == NULL && program->numFunctions +
+			header->numFunctions > 0) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	program->functions = newFunctions;
+
+	/* variables have no parameters but those of their series */
+	memset(&constant, 0, sizeof(constant));
+	for (uint32_t i = 0; i < header->numVariables; i++) {
+		const MathImageVariable *const in = &image->variables[i];
+		MathVariable *const var =
+			&program->variables[program->numVariables];
+
+		memset(var, 0, sizeof(*var));
+		name = image_name(image, in->name);
+		if (name == NULL)
+			goto err;
+		strcpy(var->name, name);
+		var->group = image_group(ctx, image, &constant, in->node);
+		if (var->group == NULL)
+			return false;
+		program->numVariables++;
+	}
+	for (uint32_t i = 0; i < header->numFunctions; i++) {
+		const MathImageFunction *const in = &image->functions[i];
+		MathFunction *const func =
+			&program->functions[program->numFunctions];
+		uint32_t offset = in->parameters;
+
+		memset(func, 0, sizeof(*func));
+		name = image_name(image, in->name);
+		if (name == NULL)
+			goto err;
+		strcpy(func->name, name);
+		func->parameters = calloc(in->numParameters,
+				sizeof(*func->parameters));
+		if (func->parameters == NULL && in->numParameters > 0) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return false;
+		}
+		func->numParameters = in->numParameters;
+		for (uint32_t p = 0; p < in->numParameters; p++) {
+			name = image_name(image, offset);
+			if (name == NULL) {
+				free(func->parameters);
+				goto err;
+			}
+			strcpy(func->parameters[p], name);
+			offset += strlen(name) + 1;
+		}
+		func->group = image_group(ctx, image, func, in->node);
+		if (func->group == NULL) {
+			free(func->parameters);
+			return false;
+		}
+		program->numFunctions++;
+	}
+	return true;
+
+err:
+	math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+	return false;
+}
+
+size_t math_imagevariable(const MathImage *image, const char *name)
+{
+	for (size_t i = 0; i < image->header->numVariables; i++)
+		if (strcmp(&image->strings[image->variables[i].name],
+					name) == 0)
+			return i;
+	return (size_t) -1;
+}
+
+/* equations have no name and can only be reached by their index */
+size_t math_imagefunction(const MathImage *image, const char *name)
+{
+	for (size_t i = 0; i < image->header->numFunctions; i++)
+		if (strcmp(&image->strings[image->functions[i].name],
+					name) == 0)
+			return i;
+	return (size_t) -1;
+}
+
+/* the name of a function of the image, empty for an equation */
+const char *math_imagename(const MathImage *image, size_t function)
+{
+	return &image->strings[image->functions[function].name];
+}
+
+/* the name of a parameter of a function of the image, empty when the
+ * names run past the strings
+ */
+const char *math_imageparameter(const MathImage *image, size_t function,
+		size_t index)
+{
+	const uint32_t size = image->header->stringsSize;
+	uint32_t offset = image->functions[function].parameters;
+
+	for (size_t p = 0; p < index && offset < size; p++)
+		offset += strlen(&image->strings[offset]) + 1;
+	return offset < size ? &image->strings[offset] : "";
+}
+
+static number_t image_compute(MathContext *ctx, const MathImage *image,
+		uint32_t index);
+
+/* the body of a series in an image with the parameters around it */
+struct image_series {
+	const MathImage *image;
+	uint32_t body;
+	const number_t *outer;
+	size_t index;
+};
+
+static void image_seriesbody(MathContext *ctx, void *arg, number_t *y,
+		const number_t *t, size_t count)
+{
+	const struct image_series *const series = arg;
+	const size_t frame = ctx->frame;
+	const size_t numLocals = ctx->numLocals;
+
+	for (size_t i = 0; i < count; i++) {
+		ctx->frame = numLocals;
+		for (size_t p = 0; p <= series->index; p++)
+			if (math_pushlocal(ctx, p < series->index ?
+						series->outer[p] : t[i]) ==
+					(size_t) -1)
+				break;
+		y[i] = ctx->numLocals - numLocals == series->index + 1 ?
+			image_compute(ctx, series->image, series->body) : NAN;
+		ctx->numLocals = numLocals;
+		ctx->frame = frame;
+	}
+}
+
+/* the arguments are the top locals */
+static number_t image_call(MathContext *ctx, const MathImage *image,
+		const MathImageFunction *func)
+{
+	size_t frame;
+	number_t value;
+
+	if (ctx->depth == MATH_MAX_DEPTH) {
+		math_seterror(ctx, MATH_RECURSIVE, 0);
+		return NAN;
+	}
+	frame = ctx->frame;
+	ctx->frame = ctx->numLocals - func->numParameters;
+	ctx->depth++;
+	value = image_compute(ctx, image, func->node);
+	ctx->depth--;
+	ctx->frame = frame;
+	return value;
+}
+
+static number_t image_compute(MathContext *ctx, const MathImage *image,
+		uint32_t index)
+{
+	const MathImageHeader *const header = image->header;
+	const MathNode *node;
+	number_t value;
+
+	if (index >= header->numNodes)
+		goto err;
+	node = &image->nodes[index];
+	switch (node->type) {
+	case GROUP_NUMBER:
+		if (node->a >= header->numConstants)
+			goto err;
+		return image->constants[node->a];
+	case GROUP_VARIABLE:
+		return NAN;
+	case GROUP_PARAMETER:
+		if (ctx->frame + node->a >= ctx->numLocals)
+			goto err;
+		return ctx->locals[ctx->frame + node->a];
+	case GROUP_GLOBAL:
+		if (node->a >= header->numVariables)
+			goto err;
+		return image->variables[node->a].value;
+	case GROUP_NEGATE:
+		return -image_compute(ctx, image, node->a);
+	case GROUP_CALL: {
+		const MathFunction *system = NULL;
+		const MathImageFunction *func = NULL;
+
+		if (node->a < SYSTEM_MAX) {
+			system = math_systemfunction(node->a);
+			if (system->numParameters != node->numArguments)
+				goto err;
+		} else {
+			if (node->a - SYSTEM_MAX >= header->numFunctions)
+				goto err;
+			func = &image->functions[node->a - SYSTEM_MAX];
+			if (func->numParameters != node->numArguments)
+				goto err;
+		}
+		if (node->b > header->numArguments ||
+				node->numArguments > header->numArguments -
+				node->b)
+			goto err;
+		for (size_t i = 0; i < node->numArguments; i++) {
+			value = image_compute(ctx, image,
+					image->arguments[node->b + i]);
+			if (math_pushlocal(ctx, value) == (size_t) -1) {
+				ctx->numLocals -= i;
+				return NAN;
+			}
+		}
+		value = system != NULL ? math_computefunction(ctx, system) :
+			image_call(ctx, image, func);
+		ctx->numLocals -= node->numArguments;
+		return value;
+	}
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL: {
+		struct image_series series;
+		number_t lo, hi;
+
+		if (node->numArguments != 3 || node->b > header->numArguments ||
+				3 > header->numArguments - node->b ||
+				ctx->frame + node->a > ctx->numLocals)
+			goto err;
+		lo = image_compute(ctx, image, image->arguments[node->b]);
+		hi = image_compute(ctx, image, image->arguments[node->b + 1]);
+		/* copied since the locals move when they grow */
+		number_t outer[node->a + 1];
+		memcpy(outer, &ctx->locals[ctx->frame],
+				sizeof(*outer) * node->a);
+		series.image = image;
+		series.body = image->arguments[node->b + 2];
+		series.outer = outer;
+		series.index = node->a;
+		return math_series(ctx, node->type, lo, hi, image_seriesbody,
+				&series);
+	}
+	case GROUP_ADD:
+		return image_compute(ctx, image, node->a) +
+			image_compute(ctx, image, node->b);
+	case GROUP_SUBTRACT:
+	case GROUP_EQUALS:
+		return image_compute(ctx, image, node->a) -
+			image_compute(ctx, image, node->b);
+	case GROUP_MULTIPLY:
+		return image_compute(ctx, image, node->a) *
+			image_compute(ctx, image, node->b);
+	case GROUP_DIVIDE:
+		return image_compute(ctx, image, node->a) /
+			image_compute(ctx, image, node->b);
+	case GROUP_MOD: {
+		const number_t left = image_compute(ctx, image, node->a);
+		const number_t right = image_compute(ctx, image, node->b);
+		return left - right * floorl(left / right);
+	}
+	case GROUP_AND:
+		return (image_compute(ctx, image, node->a) != 0) &
+			(image_compute(ctx, image, node->b) != 0);
+	case GROUP_OR:
+		return (image_compute(ctx, image, node->a) != 0) |
+			(image_compute(ctx, image, node->b) != 0);
+	case GROUP_XOR:
+		return (image_compute(ctx, image, node->a) != 0) ^
+			(image_compute(ctx, image, node->b) != 0);
+	default:
+		return 0;
+	}
+
+err:
+	math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+	return NAN;
+}
+
+/* computes a function of the image, the arguments are the top locals
+ * like for math_computefunction()
+ */
+number_t math_computeimage(MathContext *ctx, const MathImage *image,
+		size_t function)
+{
+	const MathImageFunction *func;
+
+	if (function >= image->header->numFunctions) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+		return NAN;
+	}
+	func = &image->functions[function];
+	if (func->numParameters > ctx->numLocals) {
+		math_seterror(ctx, MATH_INVALID_IMAGE, 0);
+		return NAN;
+	}
+	return image_call(ctx, image, func);
+}
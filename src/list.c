@@ -0,0 +1,202 @@
+#include "cake.h"
+
+/* an element that depends on parameters is NaN, it has no single value */
+static number_t list_element(MathContext *ctx, const MathGroup *group)
+{
+	if (!math_isconstant(group))
+		return NAN;
+	return math_computegroup(ctx, group);
+}
+
+/* the first value and the number of values of `left..right` */
+static bool list_range(MathContext *ctx, const MathGroup *group,
+		number_t *first, size_t *count)
+{
+	const number_t left = list_element(ctx, group->left);
+	const number_t right = list_element(ctx, group->right);
+
+	if (!isfinite(left) || !isfinite(right) || right - left >=
+			(number_t) (SIZE_MAX / sizeof(number_t))) {
+		math_seterror(ctx, MATH_INVALID_RANGE, 0);
+		return false;
+	}
+	*first = left;
+	*count = right < left ? 0 : (size_t) floorl(right - left) + 1;
+	return true;
+}
+
+/* whether the group computes to a list, the variables it refers to are
+ * computed to know whether they are lists; each called function is only
+ * visited once
+ */
+static bool list_find(MathContext *ctx, const MathGroup *group,
+		bool *visited)
+{
+	size_t index;
+
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_RANGE:
+	/* the body of a series computes with lists as NaN */
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		return false;
+	case GROUP_LIST:
+	case GROUP_SOLVE:
+		return true;
+	case GROUP_GLOBAL: {
+		MathVariable *const var =
+			&ctx->program->variables[group->index];
+		if (var->state != VARIABLE_COMPUTED)
+			math_computevariable(ctx, var);
+		return var->list != NULL;
+	}
+	case GROUP_NEGATE:
+		return list_find(ctx, group->group, visited);
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (list_find(ctx, group->arguments[i], visited))
+				return true;
+		if (group->function == NULL || group->function->group == NULL)
+			return false;
+		index = group->function - ctx->program->functions;
+		if (visited[index])
+			return false;
+		visited[index] = true;
+		return list_find(ctx, group->function->group, visited);
+	default:
+		return list_find(ctx, group->left, visited) ||
+			list_find(ctx, group->right, visited);
+	}
+}
+
+/* whether the bound group of a variable computes to a list */
+bool math_islist(MathContext *ctx, const MathGroup *group)
+{
+	bool visited[ctx->program->numFunctions + 1];
+
+	memset(visited, 0, sizeof(visited));
+	return list_find(ctx, group, visited);
+}
+
+/* the values of a literal like `[1, 2, 10..20]`, a literal of one range
+ * is not stored but generated when it is read
+ */
+bool math_literallist(MathContext *ctx, const MathGroup *group,
+		MathList *list)
+{
+	MathGroup *const *const elements = group->arguments;
+	size_t count = 0, n, index = 0;
+	number_t first;
+
+	memset(list, 0, sizeof(*list));
+	for (size_t i = 0; i < group->numArguments; i++) {
+		if (elements[i]->type != GROUP_RANGE) {
+			count++;
+			continue;
+		}
+		if (!list_range(ctx, elements[i], &first, &n))
+			return false;
+		if (group->numArguments == 1) {
+			list->count = n;
+			list->first = first;
+			return true;
+		}
+		count += n;
+		if (count < n || count > SIZE_MAX / sizeof(number_t)) {
+			math_seterror(ctx, MATH_MEMORY, 0);
+			return false;
+		}
+	}
+	list->values = malloc(sizeof(*list->values) *
+			MAX(count, (size_t) 1));
+	if (list->values == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return false;
+	}
+	list->count = count;
+	for (size_t i = 0; i < group->numArguments; i++) {
+		if (elements[i]->type != GROUP_RANGE) {
+			list->values[index++] = list_element(ctx, elements[i]);
+			continue;
+		}
+		list_range(ctx, elements[i], &first, &n);
+		for (size_t j = 0; j < n; j++)
+			list->values[index++] = first + (number_t) j;
+	}
+	return true;
+}
+
+/* computes the bound group element by element: operators and functions
+ * apply to the elements of all lists at the same index, in blocks of
+ * MATH_BLOCK elements, and numbers go along with each
+ */
+bool math_computelist(MathContext *ctx, const MathGroup *group,
+		MathList *list)
+{
+	MathFunction func;
+	MathBlock block;
+	const MathOperation *op;
+	size_t count;
+	bool result = false;
+
+	memset(list, 0, sizeof(*list));
+	memset(&func, 0, sizeof(func));
+	memset(&block, 0, sizeof(block));
+	func.group = (MathGroup *) group;
+	block.lists = true;
+	if (!math_blockfunction(ctx, &block, &func))
+		goto end;
+	count = block.numLeaves == 0 ? 1 : block.count;
+	op = &block.operations[block.results[0]];
+	/* a range is still only a range */
+	if (op->type == GROUP_LIST &&
+			block.leaves[op->index].values == NULL) {
+		list->count = count;
+		list->first = block.leaves[op->index].first;
+		result = true;
+		goto end;
+	}
+	list->values = malloc(sizeof(*list->values) *
+			MAX(count, (size_t) 1));
+	if (list->values == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		goto end;
+	}
+	list->count = count;
+	for (size_t offset = 0; offset < count; offset += MATH_BLOCK) {
+		const size_t n = MIN(count - offset, (size_t) MATH_BLOCK);
+
+		block.offset = offset;
+		if (!math_computeblock(ctx, &block, NULL, n)) {
+			math_freelist(list);
+			goto end;
+		}
+		memcpy(&list->values[offset], math_blockresult(&block, 0),
+				sizeof(*list->values) * n);
+	}
+	result = true;
+
+end:
+	math_freeblock(&block);
+	return result;
+}
+
+number_t math_listelement(const MathList *list, size_t index)
+{
+	if (list->values == NULL)
+		return list->first + (number_t) index;
+	return list->values[index];
+}
+
+void math_freelist(MathList *list)
+{
+	if (!list->borrowed)
+		free(list->values);
+	memset(list, 0, sizeof(*list));
+}
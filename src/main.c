@@ -1,6 +1,583 @@
 #include "cake.h"
 
-int main(void)
+static void usage(const char *program)
 {
+	fprintf(stderr, "usage: %s [-o FILE.ppm] [-s WIDTHxHEIGHT] "
+			"[-c X,Y] [-z ZOOM] [-H LO,HI[,BANDS]] [-b COUNT] [-T] "
+			"[-a exact|double|fast] [-w FILE.cake] [-l FILE.cake] "
+			"[-g FILE.c] [-p NAME] [-t NAME,... -r LO,HI,COUNT... "
+			"[-f csv|binary]] [LINE...]\n"
+			"-H colors the values of the first equation from LO to "
+			"HI, in BANDS bands\n"
+			"-T renders -o in bands of tiles, in bounded memory "
+			"for any size, without labels\n"
+			"-l loads the worksheet written by -w before the "
+			"lines\n"
+			"-p prints the values of the variable NAME, one per line\n"
+			"-t writes the functions NAME,... on the grid of one "
+			"-r for each parameter\n"
+			"   to -o FILE or stdout\n"
+			"without -o, -w, -g, -p or -t the interactive window "
+			"is opened\n",
+			program);
+}
+
+/* loads the compiled worksheet if there is one, then defines the
+ * worksheet lines after it and binds them all
+ */
+static int define_lines(MathContext *ctx, MathProgram *program,
+		const char *load, char **texts, int numTexts)
+{
+	MathImage image;
+	bool loaded;
+
+	if (load != NULL) {
+		if (!math_mapimage(ctx, &image, load)) {
+			fprintf(stderr, "'%s': %s\n", load, math_error(ctx));
+			return -1;
+		}
+		loaded = math_loadimage(ctx, program, &image);
+		math_unmapimage(&image);
+		if (!loaded) {
+			fprintf(stderr, "'%s': %s\n", load, math_error(ctx));
+			return -1;
+		}
+	}
+	for (int i = 0; i < numTexts; i++) {
+		enum math_definition definition;
+		size_t address;
+
+		if (!math_define(ctx, program, texts[i], &definition,
+					&address)) {
+			fprintf(stderr, "'%s': %s\n", texts[i],
+					math_error(ctx));
+			return -1;
+		}
+	}
+	if (!math_bindprogram(ctx, program)) {
+		fprintf(stderr, "%s\n", math_error(ctx));
+		return -1;
+	}
+	return 0;
+}
+
+/* writes the compiled worksheet lines so they can be mapped later */
+static int write_image(char **texts, int numTexts, const char *load,
+		const char *output, enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	FILE *fp;
+	int result = -1;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	if (define_lines(&ctx, &program, load, texts, numTexts) < 0)
+		goto end;
+	fp = fopen(output, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "'%s' could not be opened: %s\n", output,
+				strerror(errno));
+		goto end;
+	}
+	if (!math_writeimage(&ctx, &program, fp)) {
+		fprintf(stderr, "Failed writing '%s': %s\n", output,
+				math_error(&ctx));
+		fclose(fp);
+	} else if (fclose(fp) != 0) {
+		fprintf(stderr, "Failed writing '%s'\n", output);
+	} else {
+		result = 0;
+	}
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
+
+/* prints the value a variable of the mapped worksheet was written with,
+ * the image is not loaded into a program; lists were written as NaN
+ */
+static int print_imagevariable(const char *load, const char *name)
+{
+	MathContext ctx;
+	MathImage image;
+	size_t index;
+
+	memset(&ctx, 0, sizeof(ctx));
+	if (!math_mapimage(&ctx, &image, load)) {
+		fprintf(stderr, "'%s': %s\n", load, math_error(&ctx));
+		return -1;
+	}
+	index = math_imagevariable(&image, name);
+	if (index == (size_t) -1)
+		fprintf(stderr, "'%s' is not defined\n", name);
+	else
+		printf("%.*Lg\n", LDBL_DIG, image.variables[index].value);
+	math_unmapimage(&image);
+	return index == (size_t) -1 ? -1 : 0;
+}
+
+/* prints the value of a variable or each element of a list variable */
+static int print_variable(char **texts, int numTexts, const char *load,
+		const char *name, enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	const MathVariable *var = NULL;
+	int result = -1;
+
+	if (load != NULL && numTexts == 0)
+		return print_imagevariable(load, name);
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	if (define_lines(&ctx, &program, load, texts, numTexts) < 0)
+		goto end;
+	for (size_t i = 0; i < program.numVariables; i++)
+		if (strcmp(program.variables[i].name, name) == 0)
+			var = &program.variables[i];
+	if (var == NULL) {
+		fprintf(stderr, "'%s' is not defined\n", name);
+		goto end;
+	}
+	if (var->list == NULL)
+		printf("%.*Lg\n", LDBL_DIG, var->value);
+	else
+		for (size_t i = 0; i < var->list->count; i++)
+			printf("%.*Lg\n", LDBL_DIG,
+					math_listelement(var->list, i));
+	result = 0;
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
+
+/* writes the worksheet lines as C functions to compile with a program;
+ * the file is written next to the output and renamed when it is
+ * complete, so a failure leaves no half written file
+ */
+static int write_source(char **texts, int numTexts, const char *load,
+		const char *output, enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	char temporary[strlen(output) + sizeof(".XXXXXX")];
+	const MathFunction *func;
+	size_t failed, equation = 0;
+	mode_t mask;
+	FILE *fp;
+	int fd;
+	int result = -1;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	if (define_lines(&ctx, &program, load, texts, numTexts) < 0)
+		goto end;
+	snprintf(temporary, sizeof(temporary), "%s.XXXXXX", output);
+	fd = mkstemp(temporary);
+	if (fd < 0) {
+		fprintf(stderr, "'%s' could not be opened: %s\n", output,
+				strerror(errno));
+		goto end;
+	}
+	/* the permissions a new file would have */
+	mask = umask(0);
+	umask(mask);
+	fchmod(fd, 0666 & ~mask);
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "'%s' could not be opened: %s\n", output,
+				strerror(errno));
+		close(fd);
+		unlink(temporary);
+		goto end;
+	}
+	if (!math_writesource(&ctx, &program, fp, &failed)) {
+		func = &program.functions[failed];
+		if (func->name[0] != '\0') {
+			fprintf(stderr, "'%s' could not be generated: %s\n",
+					func->name, math_error(&ctx));
+		} else {
+			for (size_t i = 0; i < failed; i++)
+				equation += program.functions[i].name[0] ==
+					'\0';
+			fprintf(stderr, "equation %zu could not be generated: "
+					"%s\n", equation, math_error(&ctx));
+		}
+		fclose(fp);
+	} else if (fclose(fp) != 0) {
+		fprintf(stderr, "Failed writing '%s'\n", output);
+	} else if (rename(temporary, output) != 0) {
+		fprintf(stderr, "'%s' could not be replaced: %s\n", output,
+				strerror(errno));
+	} else {
+		result = 0;
+	}
+	if (result < 0)
+		unlink(temporary);
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
+
+/* writes the functions named in the comma separated list on the grid
+ * of the axes to the output file or stdout
+ */
+static int write_sweep(char **texts, int numTexts, const char *load,
+		char *names, const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, const char *output,
+		enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	MathImage image;
+	const MathFunction *functions[strlen(names) + 1];
+	size_t indices[strlen(names) + 1];
+	size_t numFunctions = 0, numParameters;
+	/* a mapped worksheet alone is computed as it is, not loaded */
+	const bool mapped = load != NULL && numTexts == 0;
+	bool swept;
+	FILE *fp = stdout;
+	int result = -1;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	memset(&image, 0, sizeof(image));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	if (mapped) {
+		if (!math_mapimage(&ctx, &image, load)) {
+			fprintf(stderr, "'%s': %s\n", load, math_error(&ctx));
+			goto end;
+		}
+	} else if (define_lines(&ctx, &program, load, texts, numTexts) < 0) {
+		goto end;
+	}
+	for (char *name = strtok(names, ","); name != NULL;
+			name = strtok(NULL, ",")) {
+		functions[numFunctions] = NULL;
+		indices[numFunctions] = mapped ?
+			math_imagefunction(&image, name) : (size_t) -1;
+		for (size_t i = 0; !mapped && i < program.numFunctions; i++)
+			if (strcmp(program.functions[i].name, name) == 0)
+				functions[numFunctions] =
+					&program.functions[i];
+		if (mapped ? indices[numFunctions] == (size_t) -1 :
+				functions[numFunctions] == NULL) {
+			fprintf(stderr, "'%s' is not defined\n", name);
+			goto end;
+		}
+		numParameters = mapped ?
+			image.functions[indices[numFunctions]].numParameters :
+			functions[numFunctions]->numParameters;
+		if (numParameters != numAxes) {
+			fprintf(stderr, "'%s' needs %zu ranges\n", name,
+					numParameters);
+			goto end;
+		}
+		numFunctions++;
+	}
+	if (output != NULL) {
+		fp = fopen(output, format == SWEEP_BINARY ? "wb" : "w");
+		if (fp == NULL) {
+			fprintf(stderr, "'%s' could not be opened: %s\n",
+					output, strerror(errno));
+			goto end;
+		}
+	}
+	swept = mapped ? math_sweepimage(&ctx, &image, indices, numFunctions,
+			axes, numAxes, format, fp, 0) :
+		math_sweep(&ctx, functions, numFunctions, axes, numAxes,
+				format, fp, 0);
+	if (!swept)
+		fprintf(stderr, "Failed writing '%s': %s\n",
+				output == NULL ? "stdout" : output,
+				math_error(&ctx));
+	else
+		result = 0;
+	if (output != NULL && fclose(fp) != 0) {
+		fprintf(stderr, "Failed writing '%s'\n", output);
+		result = -1;
+	}
+
+end:
+	if (mapped)
+		math_unmapimage(&image);
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
+
+/* renders the worksheet lines into a PPM file of any size, a band of
+ * tiles at a time
+ */
+static int export_headless(char **texts, int numTexts, const char *load,
+		const char *output, int width, int height, Vector center,
+		number_t zoom, PlotHeat heat, enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	Plot plot;
+	FILE *fp;
+	int result = -1;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	/* only the view of the plot, the tiles have their own surfaces */
+	memset(&plot, 0, sizeof(plot));
+	plot_setheat(&plot, heat);
+	plot.zoom = zoom;
+	plot.translation.x = center.x - width / (2 * zoom);
+	plot.translation.y = -center.y - height / (2 * zoom);
+	if (define_lines(&ctx, &program, load, texts, numTexts) < 0)
+		goto end;
+	fp = fopen(output, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "'%s' could not be opened: %s\n", output,
+				strerror(errno));
+		goto end;
+	}
+	if (plot_export(&plot, &ctx, width, height, fp) < 0) {
+		fprintf(stderr, "Failed writing '%s'\n", output);
+		fclose(fp);
+	} else if (fclose(fp) != 0) {
+		fprintf(stderr, "Failed writing '%s'\n", output);
+	} else {
+		result = 0;
+	}
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
+
+/* renders the worksheet lines into a PPM file without opening a window */
+static int render_headless(char **texts, int numTexts, const char *load,
+		const char *output, int width, int height, Vector center,
+		number_t zoom, PlotHeat heat, int benchmark,
+		enum math_accuracy accuracy)
+{
+	MathProgram program;
+	MathContext ctx;
+	Plot plot;
+	FILE *fp;
+	Uint64 start, end;
+	int result = -1;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	ctx.accuracy = accuracy;
+	if (plot_init(&plot, width, height) < 0)
+		return -1;
+	/* a single frame gains nothing from the tile cache and the frames
+	 * of a benchmark must not come from it
+	 */
+	tile_uninit(&plot.tiles);
+	plot_setheat(&plot, heat);
+	plot.zoom = zoom;
+	plot.translation.x = center.x - width / (2 * zoom);
+	plot.translation.y = -center.y - height / (2 * zoom);
+	if (TTF_Init() == 0)
+		plot.font = TTF_OpenFont("font.ttf", 16);
+	if (plot.font == NULL)
+		fprintf(stderr, "'font.ttf' could not be opened, "
+				"rendering without labels\n");
+
+	if (define_lines(&ctx, &program, load, texts, numTexts) < 0)
+		goto end;
+
+	start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < benchmark; i++)
+		plot_render(&plot, &ctx);
+	end = SDL_GetPerformanceCounter();
+	if (benchmark > 1)
+		fprintf(stderr, "%d frames, %.3f ms per frame\n", benchmark,
+				(end - start) * 1000.0 /
+				SDL_GetPerformanceFrequency() / benchmark);
+
+	fp = fopen(output, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "'%s' could not be opened: %s\n", output,
+				strerror(errno));
+		goto end;
+	}
+	if (plot_writeppm(&plot, fp) < 0 || fclose(fp) != 0)
+		fprintf(stderr, "Failed writing '%s'\n", output);
+	else
+		result = 0;
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	if (plot.font != NULL)
+		TTF_CloseFont(plot.font);
+	plot_uninit(&plot);
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL;
+	const char *image = NULL;
+	const char *load = NULL;
+	const char *print = NULL;
+	const char *source = NULL;
+	char *sweep = NULL;
+	MathAxis axes[16];
+	size_t numAxes = 0;
+	enum math_sweep_format format = SWEEP_CSV;
+	int width = 640, height = 480;
+	Vector center = { 0, 0 };
+	number_t zoom = 10;
+	PlotHeat heat = { 0, 0, 0 };
+	int benchmark = 1;
+	bool tiled = false;
+	enum math_accuracy accuracy = ACCURACY_DOUBLE;
+	Window window;
+	int opt;
+
+	/* the tokenizer reads utf8 like ° as wide characters */
+	setlocale(LC_CTYPE, "");
+	while ((opt = getopt(argc, argv,
+				"o:s:c:z:H:b:Ta:w:l:g:p:t:r:f:h")) != -1) {
+		switch (opt) {
+		case 'o':
+			output = optarg;
+			break;
+		case 's':
+			if (sscanf(optarg, "%dx%d", &width, &height) != 2 ||
+					width <= 0 || height <= 0) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'c':
+			if (sscanf(optarg, "%Lf,%Lf", &center.x,
+						&center.y) != 2) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'z':
+			zoom = strtold(optarg, NULL);
+			if (!(zoom > 0)) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'H':
+			heat.bands = 0;
+			if (sscanf(optarg, "%f,%f,%d", &heat.lo, &heat.hi,
+						&heat.bands) < 2 ||
+					!(heat.lo < heat.hi) ||
+					heat.bands < 0) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'b':
+			benchmark = atoi(optarg);
+			if (benchmark < 1) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'T':
+			tiled = true;
+			break;
+		case 'a':
+			if (strcmp(optarg, "exact") == 0) {
+				accuracy = ACCURACY_EXACT;
+			} else if (strcmp(optarg, "double") == 0) {
+				accuracy = ACCURACY_DOUBLE;
+			} else if (strcmp(optarg, "fast") == 0) {
+				accuracy = ACCURACY_FAST;
+			} else {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'w':
+			image = optarg;
+			break;
+		case 'l':
+			load = optarg;
+			break;
+		case 'g':
+			source = optarg;
+			break;
+		case 'p':
+			print = optarg;
+			break;
+		case 't':
+			sweep = optarg;
+			break;
+		case 'r':
+			if (numAxes == ARRLEN(axes) ||
+					sscanf(optarg, "%Lf,%Lf,%zu",
+						&axes[numAxes].lo,
+						&axes[numAxes].hi,
+						&axes[numAxes].count) != 3 ||
+					axes[numAxes].count == 0) {
+				usage(argv[0]);
+				return 1;
+			}
+			numAxes++;
+			break;
+		case 'f':
+			if (strcmp(optarg, "csv") == 0) {
+				format = SWEEP_CSV;
+			} else if (strcmp(optarg, "binary") == 0) {
+				format = SWEEP_BINARY;
+			} else {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return opt != 'h';
+		}
+	}
+
+	if (sweep != NULL)
+		return write_sweep(&argv[optind], argc - optind, load, sweep,
+				axes, numAxes, format, output, accuracy) < 0;
+	if (print != NULL)
+		return print_variable(&argv[optind], argc - optind, load,
+				print, accuracy) < 0;
+	if (source != NULL)
+		return write_source(&argv[optind], argc - optind, load,
+				source, accuracy) < 0;
+	if (image != NULL)
+		return write_image(&argv[optind], argc - optind, load, image,
+				accuracy) < 0;
+	if (output != NULL && tiled)
+		return export_headless(&argv[optind], argc - optind, load,
+				output, width, height, center, zoom, heat,
+				accuracy) < 0;
+	if (output != NULL)
+		return render_headless(&argv[optind], argc - optind, load,
+				output, width, height, center, zoom, heat,
+				benchmark, accuracy) < 0;
+
+	if (window_init(&window) < 0)
+		return 1;
+	window_show(&window);
 	return 0;
 }
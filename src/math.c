@@ -1,12 +1,68 @@
 #include "cake.h"
 
-number_t math_computegroup(MathContext *ctx, MathGroup *group)
+number_t math_computegroup(MathContext *ctx, const MathGroup *group)
 {
+	number_t value;
+
 	switch (group->type) {
 	case GROUP_NEGATE:
 		return -math_computegroup(ctx, group->group);
 	case GROUP_NUMBER:
 		return group->value;
+	case GROUP_VARIABLE:
+		/* binding failed */
+		return NAN;
+	case GROUP_PARAMETER:
+		return ctx->locals[ctx->frame + group->index];
+	case GROUP_GLOBAL: {
+		const MathVariable *const var =
+			&ctx->program->variables[group->index];
+		if (var->state == VARIABLE_COMPUTED)
+			return var->value;
+		/* only while math_bindprogram() computes the variables */
+		return math_computevariable(ctx, (MathVariable *) var);
+	}
+	case GROUP_CALL:
+		if (group->function == NULL)
+			return NAN;
+		for (size_t i = 0; i < group->numArguments; i++) {
+			value = math_computegroup(ctx, group->arguments[i]);
+			if (math_pushlocal(ctx, value) == (size_t) -1) {
+				ctx->numLocals -= i;
+				return NAN;
+			}
+		}
+		value = math_computefunction(ctx, group->function);
+		ctx->numLocals -= group->numArguments;
+		return value;
+	case GROUP_LIST:
+	case GROUP_RANGE:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* a list is no number, see math_computelist(), and a curve
+		 * or complex body is only drawn
+		 */
+		return NAN;
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL: {
+		const MathGroup *const name = group->arguments[0];
+		const size_t index = name->type == GROUP_PARAMETER ?
+			name->index : 0;
+		number_t outer[index + 1];
+
+		if (name->type != GROUP_PARAMETER)
+			return NAN;
+		/* the parameters of the function and the series around */
+		for (size_t i = 0; i < index; i++)
+			outer[i] = ctx->frame + i < ctx->numLocals ?
+				ctx->locals[ctx->frame + i] : NAN;
+		return math_computeseries(ctx, group,
+				math_computegroup(ctx, group->arguments[1]),
+				math_computegroup(ctx, group->arguments[2]),
+				outer);
+	}
 	case GROUP_ADD:
 		return math_computegroup(ctx, group->left) +
 			math_computegroup(ctx, group->right);
@@ -19,17 +75,101 @@ number_t math_computegroup(MathContext *ctx, MathGroup *group)
 	case GROUP_DIVIDE:
 		return math_computegroup(ctx, group->left) /
 			math_computegroup(ctx, group->right);
+	case GROUP_EQUALS:
+		return math_computegroup(ctx, group->left) -
+			math_computegroup(ctx, group->right);
+	case GROUP_MOD: {
+		const number_t left = math_computegroup(ctx, group->left);
+		const number_t right = math_computegroup(ctx, group->right);
+		/* takes the sign of the right side */
+		return left - right * floorl(left / right);
+	}
+	case GROUP_AND:
+		return (math_computegroup(ctx, group->left) != 0) &
+			(math_computegroup(ctx, group->right) != 0);
+	case GROUP_OR:
+		return (math_computegroup(ctx, group->left) != 0) |
+			(math_computegroup(ctx, group->right) != 0);
+	case GROUP_XOR:
+		return (math_computegroup(ctx, group->left) != 0) ^
+			(math_computegroup(ctx, group->right) != 0);
 	default:
 		return 0;
 	}
 }
 
-number_t math_computefunction(MathContext *ctx, MathFunction *func)
+/* the slot of the call in the memo of the context, NULL when the function
+ * does not remember its results; the arguments are copied to the keys
+ */
+static MathMemo *memo_slot(MathContext *ctx, const MathFunction *func,
+		const number_t *args, number_t *keys)
+{
+	const MathProgram *const program = ctx->program;
+	uint64_t hash = (uintptr_t) func * 0x100000001b3;
+
+	if (!func->pure || ctx->memoize == MEMOIZE_NONE ||
+			(ctx->memoize == MEMOIZE_RECURSIVE &&
+			 !func->recursive) ||
+			func->numParameters > MATH_MEMO_ARGUMENTS ||
+			program == NULL || program->generation == 0)
+		return NULL;
+	if (ctx->memo == NULL) {
+		ctx->memo = malloc(sizeof(*ctx->memo) * MATH_MEMO_SIZE);
+		if (ctx->memo == NULL)
+			return NULL;
+		ctx->memoGeneration = 0;
+	}
+	if (ctx->memoGeneration != program->generation ||
+			ctx->memoAccuracy != ctx->accuracy) {
+		for (size_t i = 0; i < MATH_MEMO_SIZE; i++)
+			ctx->memo[i].function = NULL;
+		ctx->memoGeneration = program->generation;
+		ctx->memoAccuracy = ctx->accuracy;
+	}
+	for (size_t i = 0; i < func->numParameters; i++) {
+		/* a long double is exactly the sum of two doubles, which
+		 * unlike its bytes have no padding
+		 */
+		const double high = args[i];
+		const double low = args[i] - high;
+		uint64_t bits;
+
+		keys[i] = args[i];
+		memcpy(&bits, &high, sizeof(bits));
+		hash = (hash ^ bits) * 0x100000001b3;
+		memcpy(&bits, &low, sizeof(bits));
+		hash = (hash ^ bits) * 0x100000001b3;
+	}
+	/* the bits of small numbers differ at the top only */
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccd;
+	hash ^= hash >> 33;
+	return &ctx->memo[hash & (MATH_MEMO_SIZE - 1)];
+}
+
+/* -0 and 0 are told apart, 1 / x differs for them */
+static bool memo_equal(const MathMemo *memo, const MathFunction *func,
+		const number_t *keys)
+{
+	if (memo->function != func)
+		return false;
+	for (size_t i = 0; i < func->numParameters; i++)
+		if (memo->arguments[i] != keys[i] ||
+				signbit(memo->arguments[i]) != signbit(keys[i]))
+			return false;
+	return true;
+}
+
+number_t math_computefunction(MathContext *ctx, const MathFunction *func)
 {
 	number_t (*funcZero)(MathContext *ctx);
 	number_t (*funcSingle)(MathContext *ctx, number_t);
 	number_t (*funcDouble)(MathContext *ctx, number_t, number_t);
 	number_t (*funcTriple)(MathContext *ctx, number_t, number_t, number_t);
+	size_t frame;
+	number_t value;
+	number_t keys[MATH_MEMO_ARGUMENTS];
+	MathMemo *memo;
 
 	if (func->group == NULL) {
 		const number_t *const args =
@@ -51,22 +191,503 @@ number_t math_computefunction(MathContext *ctx, MathFunction *func)
 		}
 		return 0;
 	}
-	return math_computegroup(ctx, func->group);
+	/* there are no conditions, so deep recursion never ends */
+	if (ctx->depth == MATH_MAX_DEPTH) {
+		math_seterror(ctx, MATH_RECURSIVE, 0);
+		return NAN;
+	}
+	memo = memo_slot(ctx, func,
+			&ctx->locals[ctx->numLocals - func->numParameters],
+			keys);
+	if (memo != NULL) {
+		if (memo_equal(memo, func, keys)) {
+			ctx->memoHits++;
+			/* a recursion that never ends is cut wherever it
+			 * was first computed
+			 */
+			if (memo->recursive)
+				math_seterror(ctx, MATH_RECURSIVE, 0);
+			return memo->value;
+		}
+		ctx->memoMisses++;
+	}
+	frame = ctx->frame;
+	ctx->frame = ctx->numLocals - func->numParameters;
+	ctx->depth++;
+	value = math_computegroup(ctx, func->group);
+	ctx->depth--;
+	ctx->frame = frame;
+	if (memo != NULL) {
+		memo->function = func;
+		memcpy(memo->arguments, keys,
+				sizeof(*keys) * func->numParameters);
+		memo->value = value;
+		memo->recursive = ctx->error == MATH_RECURSIVE;
+	}
+	return value;
+}
+
+/* computes the variable once, later calls return the same value */
+number_t math_computevariable(MathContext *ctx, MathVariable *var)
+{
+	size_t frame;
+
+	switch (var->state) {
+	case VARIABLE_COMPUTED:
+		return var->value;
+	case VARIABLE_COMPUTING:
+		math_seterror(ctx, MATH_RECURSIVE, 0);
+		return NAN;
+	default:
+	}
+	var->state = VARIABLE_COMPUTING;
+	frame = ctx->frame;
+	ctx->frame = ctx->numLocals;
+	if (math_islist(ctx, var->group)) {
+		var->value = NAN;
+		var->list = malloc(sizeof(*var->list));
+		if (var->list == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+		} else if (!math_computelist(ctx, var->group, var->list)) {
+			free(var->list);
+			var->list = NULL;
+		}
+	} else {
+		var->value = math_computegroup(ctx, var->group);
+	}
+	ctx->frame = frame;
+	var->state = VARIABLE_COMPUTED;
+	return var->value;
+}
+
+/* the first argument of a group that binds a name which is in the scope
+ * of the name, those before are its bounds
+ */
+static size_t bind_firstbody(const MathGroup *group)
+{
+	return group->type == GROUP_COMPLEX ? 1 : 3;
+}
+
+/* the names bound by the series around a group, innermost first */
+struct bind_scope {
+	const char *name;
+	/* parameter index, after those of the function */
+	size_t index;
+	const struct bind_scope *next;
+};
+
+/* every group is visited even after a failure, so that no call keeps
+ * pointing to a function that has moved
+ */
+static bool bind_group(MathContext *ctx, const MathFunction *func,
+		MathGroup *group, const struct bind_scope *scope)
+{
+	const MathProgram *const program = ctx->program;
+	struct bind_scope inner;
+	bool bound;
+
+	switch (group->type) {
+	case GROUP_NUMBER:
+		return true;
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_GLOBAL:
+		for (const struct bind_scope *s = scope; s != NULL;
+				s = s->next)
+			if (strcmp(s->name, group->name) == 0) {
+				group->type = GROUP_PARAMETER;
+				group->index = s->index;
+				return true;
+			}
+		for (size_t i = 0; i < func->numParameters; i++)
+			if (strcmp(func->parameters[i], group->name) == 0) {
+				group->type = GROUP_PARAMETER;
+				group->index = i;
+				return true;
+			}
+		for (size_t i = 0; program != NULL &&
+				i < program->numVariables; i++)
+			if (strcmp(program->variables[i].name,
+						group->name) == 0) {
+				group->type = GROUP_GLOBAL;
+				group->index = i;
+				return true;
+			}
+		group->type = GROUP_VARIABLE;
+		math_seterror(ctx, MATH_UNDEFINED, 0);
+		return false;
+	case GROUP_NEGATE:
+		return bind_group(ctx, func, group->group, scope);
+	case GROUP_CALL:
+		bound = true;
+		for (size_t i = 0; i < group->numArguments; i++)
+			bound &= bind_group(ctx, func, group->arguments[i],
+					scope);
+		if (group->function != NULL &&
+				math_systemof(group->function) != SYSTEM_NONE)
+			return bound;
+		group->function = NULL;
+		for (size_t i = 0; program != NULL &&
+				i < program->numFunctions; i++) {
+			const MathFunction *const f = &program->functions[i];
+			if (f->name[0] == '\0' ||
+					strcmp(f->name, group->callee) != 0)
+				continue;
+			if (f->numParameters != group->numArguments) {
+				math_seterror(ctx, MATH_INVALID_CALL, 0);
+				return false;
+			}
+			group->function = f;
+			return bound;
+		}
+		math_seterror(ctx, MATH_UNDEFINED, 0);
+		return false;
+	case GROUP_LIST:
+		bound = true;
+		for (size_t i = 0; i < group->numArguments; i++)
+			bound &= bind_group(ctx, func, group->arguments[i],
+					scope);
+		return bound;
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* the bounds are outside of the scope of the name */
+		inner.name = group->arguments[0]->name;
+		inner.index = scope == NULL ? func->numParameters :
+			scope->index + 1;
+		inner.next = scope;
+		group->arguments[0]->type = GROUP_PARAMETER;
+		group->arguments[0]->index = inner.index;
+		bound = true;
+		/* a curve has two bodies and ℂ no bounds */
+		for (size_t i = 1; i < group->numArguments; i++)
+			bound &= bind_group(ctx, func, group->arguments[i],
+					i < bind_firstbody(group) ?
+					scope : &inner);
+		return bound;
+	default:
+		bound = bind_group(ctx, func, group->left, scope);
+		return bind_group(ctx, func, group->right, scope) && bound;
+	}
+}
+
+/* resolves the names of the function group to its parameters and the
+ * variables and functions of the context program
+ */
+bool math_bindfunction(MathContext *ctx, MathFunction *func)
+{
+	return bind_group(ctx, func, func->group, NULL);
+}
+
+bool math_references(const MathGroup *group, size_t parameter)
+{
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_GLOBAL:
+		return false;
+	case GROUP_PARAMETER:
+		return group->index == parameter;
+	case GROUP_NEGATE:
+		return math_references(group->group, parameter);
+	case GROUP_CALL:
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (math_references(group->arguments[i], parameter))
+				return true;
+		return false;
+	default:
+		return math_references(group->left, parameter) ||
+			math_references(group->right, parameter);
+	}
+}
+
+/* whether the bound group computes the same for any arguments: user
+ * functions only see their arguments and variables and the elements of
+ * a literal list are computed once for all of them
+ */
+bool math_isconstant(const MathGroup *group)
+{
+	switch (group->type) {
+	case GROUP_PARAMETER:
+		return false;
+	case GROUP_NULL:
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_GLOBAL:
+	case GROUP_LIST:
+	case GROUP_RANGE:
+		return true;
+	case GROUP_NEGATE:
+		return math_isconstant(group->group);
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (!math_isconstant(group->arguments[i]))
+				return false;
+		return true;
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		/* the body may use its own name but no parameter around */
+		if (group->arguments[0]->type != GROUP_PARAMETER)
+			return true;
+		for (size_t j = 1; j < bind_firstbody(group); j++)
+			if (!math_isconstant(group->arguments[j]))
+				return false;
+		for (size_t i = 0; i < group->arguments[0]->index; i++)
+			for (size_t j = bind_firstbody(group);
+					j < group->numArguments; j++)
+				if (math_references(group->arguments[j], i))
+					return false;
+		return true;
+	default:
+		return math_isconstant(group->left) &&
+			math_isconstant(group->right);
+	}
+}
+
+static uint64_t hash_mix(uint64_t hash, uint64_t value)
+{
+	return (hash ^ value) * 0x100000001b3;
+}
+
+static uint64_t hash_number(uint64_t hash, number_t value)
+{
+	number_t mantissa;
+	int exponent;
+
+	if (!isfinite(value))
+		return hash_mix(hash, isnan(value) ? 1 : 2 + (value > 0));
+	mantissa = frexpl(value, &exponent);
+	hash = hash_mix(hash, (int64_t) ldexpl(mantissa, 62));
+	return hash_mix(hash, exponent);
+}
+
+static uint64_t hash_string(uint64_t hash, const char *str)
+{
+	while (*str != '\0')
+		hash = hash_mix(hash, (unsigned char) *str++);
+	return hash;
+}
+
+/* the body of each called function is hashed where it is first called,
+ * later calls only hash its index
+ */
+static uint64_t hash_group(const MathContext *ctx, const MathGroup *group,
+		uint64_t hash, bool *visited)
+{
+	size_t index;
+
+	hash = hash_mix(hash, group->type);
+	switch (group->type) {
+	case GROUP_NUMBER:
+		return hash_number(hash, group->value);
+	case GROUP_VARIABLE:
+		return hash_string(hash, group->name);
+	case GROUP_PARAMETER:
+		return hash_mix(hash, group->index);
+	case GROUP_GLOBAL:
+		return hash_number(hash,
+				ctx->program->variables[group->index].value);
+	case GROUP_NEGATE:
+		return hash_group(ctx, group->group, hash, visited);
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			hash = hash_group(ctx, group->arguments[i], hash,
+					visited);
+		return hash;
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			hash = hash_group(ctx, group->arguments[i], hash,
+					visited);
+		if (group->function == NULL)
+			return hash_string(hash, group->callee);
+		if (group->function->group == NULL)
+			return hash_mix(hash, math_systemof(group->function));
+		index = group->function - ctx->program->functions;
+		if (visited[index])
+			return hash_mix(hash, index);
+		visited[index] = true;
+		return hash_group(ctx, group->function->group, hash, visited);
+	default:
+		hash = hash_group(ctx, group->left, hash, visited);
+		return hash_group(ctx, group->right, hash, visited);
+	}
+}
+
+/* identifies what the bound function computes: the values of variables
+ * and the bodies of called functions are part of it, so equal hashes
+ * mean equal results
+ */
+uint64_t math_hashfunction(const MathContext *ctx, const MathFunction *func)
+{
+	bool visited[ctx->program->numFunctions + 1];
+
+	memset(visited, 0, sizeof(visited));
+	return hash_group(ctx, func->group, 0xcbf29ce484222325, visited);
+}
+
+/* if the bound group has the form `p = g` or `g = p` and g does not
+ * depend on the parameter p, returns g; otherwise NULL
+ */
+MathGroup *math_solvedgroup(MathGroup *group, size_t parameter)
+{
+	MathGroup *side, *other;
+
+	if (group->type != GROUP_EQUALS)
+		return NULL;
+	side = group->left;
+	other = group->right;
+	if (side->type != GROUP_PARAMETER || side->index != parameter) {
+		side = group->right;
+		other = group->left;
+		if (side->type != GROUP_PARAMETER || side->index != parameter)
+			return NULL;
+	}
+	if (math_references(other, parameter))
+		return NULL;
+	return other;
+}
+
+MathGroup *math_copygroup(MathContext *ctx, const MathGroup *group)
+{
+	MathGroup *copy;
+
+	copy = malloc(sizeof(*copy));
+	if (copy == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	*copy = *group;
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_GLOBAL:
+		return copy;
+	case GROUP_NEGATE:
+		copy->group = math_copygroup(ctx, group->group);
+		if (copy->group == NULL)
+			goto err;
+		return copy;
+	case GROUP_CALL:
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		copy->arguments = calloc(group->numArguments,
+				sizeof(*copy->arguments));
+		if (copy->arguments == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			free(copy);
+			return NULL;
+		}
+		for (size_t i = 0; i < group->numArguments; i++) {
+			copy->arguments[i] = math_copygroup(ctx,
+					group->arguments[i]);
+			if (copy->arguments[i] == NULL)
+				goto err;
+		}
+		return copy;
+	default:
+		copy->left = math_copygroup(ctx, group->left);
+		copy->right = NULL;
+		if (copy->left == NULL)
+			goto err;
+		copy->right = math_copygroup(ctx, group->right);
+		if (copy->right == NULL)
+			goto err;
+		return copy;
+	}
+err:
+	math_freegroup(ctx, copy);
+	return NULL;
+}
+
+void math_freegroup(MathContext *ctx, MathGroup *group)
+{
+	if (group == NULL)
+		return;
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_GLOBAL:
+		break;
+	case GROUP_NEGATE:
+		math_freegroup(ctx, group->group);
+		break;
+	case GROUP_CALL:
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			math_freegroup(ctx, group->arguments[i]);
+		free(group->arguments);
+		break;
+	default:
+		math_freegroup(ctx, group->left);
+		math_freegroup(ctx, group->right);
+	}
+	free(group);
 }
 
 size_t math_pushlocal(MathContext *ctx, number_t value)
 {
 	number_t *newLocals;
+	size_t newMax;
 
-	newLocals = realloc(ctx->locals, sizeof(*ctx->locals) *
-			(ctx->numLocals + 1));
-	if (newLocals == NULL)
-		return (size_t) -1;
-	ctx->locals = newLocals;
+	if (ctx->numLocals == ctx->maxLocals) {
+		newMax = ctx->maxLocals * 2 + 8;
+		newLocals = realloc(ctx->locals, sizeof(*ctx->locals) *
+				newMax);
+		if (newLocals == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			return (size_t) -1;
+		}
+		ctx->locals = newLocals;
+		ctx->maxLocals = newMax;
+	}
 	ctx->locals[ctx->numLocals] = value;
 	return ctx->numLocals++;
 }
 
+void math_freecontext(MathContext *ctx)
+{
+	math_freeseries(ctx);
+	free(ctx->locals);
+	free(ctx->memo);
+	ctx->locals = NULL;
+	ctx->memo = NULL;
+	ctx->numLocals = 0;
+	ctx->maxLocals = 0;
+}
+
 bool math_poplocal(MathContext *ctx)
 {
 	if (ctx->numLocals == 0)
@@ -92,14 +713,29 @@ char *math_error(MathContext *ctx)
 		[MATH_INVALID_TOKEN] = "the token is invalid",
 		[MATH_DOUBLE_PLUS_MINUS] = "double +/-",
 		[MATH_HANGING_OPERATOR] = "the operator is hanging at the end",
+		[MATH_INVALID_CALL] = "the call is invalid",
+		[MATH_UNBALANCED] = "the parentheses are unbalanced",
+		[MATH_UNDEFINED] = "the variable is undefined",
+		[MATH_RECURSIVE] = "the definition refers to itself",
+		[MATH_INVALID_IMAGE] = "the compiled worksheet is invalid",
+		[MATH_INVALID_RANGE] = "the range is invalid",
+		[MATH_LIST_LENGTH] = "the lists have different lengths",
+		[MATH_WRITE] = "failed writing",
 	};
-	static char error[1024];
+	int length;
 
-	if (ctx->errorNumber == 0) {
-		strcpy(error, errors[ctx->error]);
-	} else {
-		sprintf(error, "%s: %s", errors[ctx->error],
-				strerror(ctx->errorNumber));
-	}
-	return error;
+	length = snprintf(ctx->message, sizeof(ctx->message), "%s",
+			errors[ctx->error]);
+	if (ctx->errorNumber == 0)
+		return ctx->message;
+	length += snprintf(&ctx->message[length],
+			sizeof(ctx->message) - length, ": ");
+	/* strerror() may share its buffer between threads, each context
+	 * has its own
+	 */
+	if (strerror_r(ctx->errorNumber, &ctx->message[length],
+				sizeof(ctx->message) - length) != 0)
+		snprintf(&ctx->message[length], sizeof(ctx->message) - length,
+				"error %d", ctx->errorNumber);
+	return ctx->message;
 }
@@ -6,6 +6,7 @@ enum math_token_type {
 	
 	TOKEN_AND, TOKEN_OR, TOKEN_XOR,
 	TOKEN_MOD,
+	TOKEN_EQUALS,
 
 	TOKEN_FLOOR, TOKEN_CEIL,
 	TOKEN_EXP, TOKEN_POW, TOKEN_ERFC,
@@ -17,6 +18,9 @@ enum math_token_type {
 	TOKEN_SINH, TOKEN_COSH, TOKEN_TANH,
 	TOKEN_ASINH, TOKEN_ACOSH, TOKEN_ATANH,
 	TOKEN_GAMMA,
+	/* followed by `(` like the system functions */
+	TOKEN_SUM, TOKEN_PROD, TOKEN_INTEGRAL, TOKEN_SOLVE, TOKEN_CURVE,
+	TOKEN_COMPLEX_NUMBERS,
 
 	TOKEN_PERCENT,
 	TOKEN_BANG,
@@ -26,7 +30,6 @@ enum math_token_type {
 	TOKEN_INTERSECTION,
 	TOKEN_UNION,
 	TOKEN_REAL_NUMBERS,
-	TOKEN_COMPLEX_NUMBERS,
 	TOKEN_INTEGERS,
 	TOKEN_NATURAL_NUMBERS,
 	TOKEN_MAPS_TO,
@@ -37,6 +40,9 @@ enum math_token_type {
 	TOKEN_OPEN_CURLY, TOKEN_CLOSED_CURLY,
 	TOKEN_OPEN_ROUND, TOKEN_CLOSED_ROUND,
 	TOKEN_RAISE, TOKEN_LOWER,
+	TOKEN_COMMA,
+	/* `..` between the bounds of a range */
+	TOKEN_RANGE,
 
 	TOKEN_NUMBER,
 	TOKEN_VARIABLE,
@@ -54,6 +60,7 @@ typedef struct math_token {
 typedef struct math_tokenizer {
 	MathToken *tokens;
 	size_t numTokens;
+	size_t maxTokens;
 	size_t position;
 } MathTokenizer;
 
@@ -61,8 +68,44 @@ enum math_group_type {
 	GROUP_NULL,
 
 	GROUP_NUMBER,
+	/* unresolved name, see math_bindfunction() */
+	GROUP_VARIABLE,
+	/* parameter of the function that is being computed */
+	GROUP_PARAMETER,
+	/* variable of the program */
+	GROUP_GLOBAL,
 
 	GROUP_NEGATE,
+	GROUP_CALL,
+	/* `[a, b..c]`, the elements are the arguments; a list computes as
+	 * NaN except with math_computelist()
+	 */
+	GROUP_LIST,
+	/* `left..right` as element of a list: the steps of one from left
+	 * up to right
+	 */
+	GROUP_RANGE,
+	/* `sum(k, a, b, body)` and the like, the arguments are the bound
+	 * name, the bounds and the body; binding makes the name a parameter
+	 * after those of the function and the series it is in, see series.c
+	 */
+	GROUP_SUM,
+	GROUP_PRODUCT,
+	GROUP_INTEGRAL,
+	/* `solve(t, a, b, body)` is the list of the roots of the body
+	 * between the bounds, see solve.c
+	 */
+	GROUP_SOLVE,
+	/* `curve(t, a, b, x, y)` is the parametric curve of the points
+	 * (x, y) for t between the bounds; it computes as NaN and is only
+	 * drawn by the plot
+	 */
+	GROUP_CURVE,
+	/* `ℂ(z, body)` is the body with z complex, see complex.c; it
+	 * computes as NaN and the plot colors each point z = x + iy by the
+	 * complex value
+	 */
+	GROUP_COMPLEX,
 
 	GROUP_ADD,
 	GROUP_SUBTRACT,
@@ -74,6 +117,9 @@ enum math_group_type {
 	GROUP_AND,
 	GROUP_OR,
 	GROUP_XOR,
+
+	/* computes as left - right, so the zero set is the equation */
+	GROUP_EQUALS,
 };
 
 typedef struct math_group {
@@ -83,6 +129,17 @@ typedef struct math_group {
 		struct {
 			char name[256];
 			size_t numParameters;
+			/* parameter or program variable, the name is kept
+			 * so that the group can be bound again
+			 */
+			size_t index;
+		};
+		struct {
+			const struct math_function *function;
+			struct math_group **arguments;
+			size_t numArguments;
+			/* name of a user function, resolved on binding */
+			char callee[8];
 		};
 		struct {
 			struct math_group *left;
@@ -92,19 +149,64 @@ typedef struct math_group {
 	};
 } MathGroup;
 
+enum math_variable_state {
+	VARIABLE_UNCOMPUTED,
+	VARIABLE_COMPUTING,
+	VARIABLE_COMPUTED,
+};
+
 typedef struct math_variable {
 	char name[256];
 	MathGroup *group;
+	/* computed by math_bindprogram() or math_setvariable(), NaN for
+	 * lists
+	 */
+	number_t value;
+	/* the values of a variable that is a list or NULL */
+	struct math_list *list;
+	enum math_variable_state state;
 } MathVariable;
 
+/* equations have no name and the parameters x and y */
 typedef struct math_function {
 	char name[256];
 	char (*parameters)[256];
 	size_t numParameters;
 	MathGroup *group;
 	void *system;
+	/* derivative of a single parameter system function */
+	void *derivative;
+	/* set by math_bindprogram(): the result only depends on the
+	 * arguments, and the function calls itself through its body
+	 */
+	bool pure;
+	bool recursive;
 } MathFunction;
 
+/* in the same order as the tokens of their names */
+enum math_system {
+	SYSTEM_FLOOR, SYSTEM_CEIL,
+	SYSTEM_EXP, SYSTEM_POW, SYSTEM_ERFC,
+	SYSTEM_SQRT, SYSTEM_CBRT, SYSTEM_ROOT,
+	SYSTEM_LOG10, SYSTEM_LOG, SYSTEM_LN,
+	SYSTEM_SIN, SYSTEM_COS,
+	SYSTEM_TAN, SYSTEM_COT,
+	SYSTEM_SEC, SYSTEM_CSC,
+	SYSTEM_SINH, SYSTEM_COSH, SYSTEM_TANH,
+	SYSTEM_ASINH, SYSTEM_ACOSH, SYSTEM_ATANH,
+	SYSTEM_GAMMA,
+	/* not callable by name, the derivative of ln(gamma(x)) */
+	SYSTEM_DIGAMMA,
+
+	SYSTEM_MAX,
+	SYSTEM_NONE = SYSTEM_MAX,
+};
+
+typedef struct math_dual {
+	number_t value;
+	number_t derivative;
+} MathDual;
+
 enum math_error {
 	MATH_SUCCESS,
 
@@ -114,29 +216,306 @@ enum math_error {
 	MATH_HANGING_OPERATOR,
 	MATH_DOUBLE_PLUS_MINUS,
 	MATH_INVALID_CALL,
+	MATH_UNBALANCED,
+	MATH_UNDEFINED,
+	MATH_RECURSIVE,
+	MATH_INVALID_IMAGE,
+	MATH_INVALID_RANGE,
+	MATH_LIST_LENGTH,
+	MATH_WRITE,
 };
 
-typedef struct math_context {
+/* what a line of a worksheet defines */
+enum math_definition {
+	DEFINITION_EQUATION,
+	DEFINITION_VARIABLE,
+	DEFINITION_FUNCTION,
+};
+
+/* the definitions of a worksheet, any number of contexts may compute
+ * them at once as long as the program is not changed meanwhile
+ */
+typedef struct math_program {
 	MathVariable *variables;
 	size_t numVariables;
-	number_t *locals;
-	size_t numLocals;
 	MathFunction *functions;
 	size_t numFunctions;
-	MathGroup *group;
+	/* different for every binding, 0 while not bound */
+	uint64_t generation;
+} MathProgram;
+
+/* how system functions are computed */
+enum math_accuracy {
+	/* long double libm */
+	ACCURACY_EXACT,
+	/* the double approximations, within a few ulp */
+	ACCURACY_DOUBLE,
+	/* the float approximations, about 1e-7 relative */
+	ACCURACY_FAST,
+};
+
+/* deepest nesting of user function calls */
+#define MATH_MAX_DEPTH 256
+
+/* remembered calls of a context, a power of two */
+#define MATH_MEMO_SIZE 4096
+/* functions with more parameters are not remembered */
+#define MATH_MEMO_ARGUMENTS 4
+
+/* which pure functions remember their results */
+enum math_memoize {
+	/* recursive ones, they are exponential otherwise */
+	MEMOIZE_RECURSIVE,
+	MEMOIZE_PURE,
+	MEMOIZE_NONE,
+};
+
+typedef struct math_memo {
+	const MathFunction *function;
+	/* exact, arguments that differ beyond a double are other calls */
+	number_t arguments[MATH_MEMO_ARGUMENTS];
+	number_t value;
+	/* the computation was cut at MATH_MAX_DEPTH */
+	bool recursive;
+} MathMemo;
+
+/* evaluation state, one per thread */
+typedef struct math_context {
+	const MathProgram *program;
+	number_t *locals;
+	size_t numLocals;
+	size_t maxLocals;
+	/* first local of the function that is being computed */
+	size_t frame;
+	size_t depth;
+	enum math_accuracy accuracy;
+	/* MATH_MEMO_SIZE calls, allocated when first used and cleared
+	 * when the program or accuracy changes
+	 */
+	enum math_memoize memoize;
+	MathMemo *memo;
+	uint64_t memoGeneration;
+	enum math_accuracy memoAccuracy;
+	size_t memoHits, memoMisses;
+	/* bodies of series compiled into blocks, MATH_SERIES_CACHE of
+	 * them allocated when first used
+	 */
+	struct math_series_body *series;
+	/* a worker of math_parallel(), it starts no threads itself */
+	bool nested;
 	enum math_error error;
 	int errorNumber;
+	/* filled by math_error() */
+	char message[1024];
 } MathContext;
 
+/* a compiled program in a position independent layout, every offset is
+ * from the start of the file, see image.c
+ */
+#define MATH_IMAGE_MAGIC "CAKE"
+#define MATH_IMAGE_VERSION 6
+
+typedef struct math_image_header {
+	char magic[4];
+	uint32_t version;
+	/* numbers and system functions are stored as they are in memory */
+	uint32_t numberSize;
+	uint32_t numSystem;
+	uint32_t numNodes;
+	uint32_t numConstants;
+	uint32_t numArguments;
+	uint32_t numVariables;
+	uint32_t numFunctions;
+	uint32_t numDependencies;
+	uint32_t stringsSize;
+	uint32_t nodes;
+	uint32_t constants;
+	uint32_t arguments;
+	uint32_t variables;
+	uint32_t functions;
+	uint32_t dependencies;
+	uint32_t strings;
+} MathImageHeader;
+
+typedef struct math_node {
+	uint16_t type;
+	uint16_t numArguments;
+	/* constant, parameter, variable, operand or called function; calls
+	 * of user functions are SYSTEM_MAX + their index; the parameter
+	 * index of the bound name of a series
+	 */
+	uint32_t a;
+	/* second operand or first argument */
+	uint32_t b;
+} MathNode;
+
+/* dependencies are indices of variables, followed by the functions */
+typedef struct math_image_variable {
+	number_t value;
+	uint32_t name;
+	uint32_t node;
+	uint32_t dependencies;
+	uint32_t numDependencies;
+} MathImageVariable;
+
+typedef struct math_image_function {
+	uint32_t name;
+	/* the names follow each other */
+	uint32_t parameters;
+	uint32_t numParameters;
+	uint32_t node;
+	uint32_t dependencies;
+	uint32_t numDependencies;
+} MathImageFunction;
+
+typedef struct math_image {
+	void *data;
+	size_t size;
+	const MathImageHeader *header;
+	const MathNode *nodes;
+	const number_t *constants;
+	const uint32_t *arguments;
+	const MathImageVariable *variables;
+	const MathImageFunction *functions;
+	const uint32_t *dependencies;
+	const char *strings;
+} MathImage;
+
+/* values of a list, without values the range first, first + 1, ... */
+typedef struct math_list {
+	number_t *values;
+	size_t count;
+	number_t first;
+	/* the values belong to another list */
+	bool borrowed;
+} MathList;
+
+/* samples computed by one operation of a block at once */
+#define MATH_BLOCK 128
+/* operands of an operation, a series has its bounds and the parameters
+ * it is in as operands
+ */
+#define MATH_OPERATION_ARGUMENTS 8
+
+/* an operation on the values of earlier operations */
+typedef struct math_operation {
+	/* numbers, parameters and the operators of the groups; user
+	 * functions are inlined unless they are recursive
+	 */
+	enum math_group_type type;
+	const MathFunction *function;
+	/* the series, it is computed for every sample on its own */
+	const MathGroup *group;
+	size_t arguments[MATH_OPERATION_ARGUMENTS];
+	/* number, parameter index or list index */
+	number_t value;
+	size_t index;
+} MathOperation;
+
+/* functions of the same parameters computed together: each distinct
+ * subexpression is one operation for all of them
+ */
+typedef struct math_block {
+	MathOperation *operations;
+	size_t numOperations, maxOperations;
+	/* operation that computes each function */
+	size_t *results;
+	size_t numResults;
+	/* open addressing table of the operations by their contents */
+	size_t *table;
+	size_t tableSize;
+	/* MATH_BLOCK values of every operation, of a complex block the
+	 * real parts followed by the imaginary parts
+	 */
+	number_t *values;
+	size_t numValues;
+	/* computed by math_computecomplexblock() only */
+	bool complex;
+	/* with lists set, the lists are computed element by element: the
+	 * sample i is the element offset + i of each list, otherwise a list
+	 * is NaN
+	 */
+	bool lists;
+	MathList *leaves;
+	size_t numLeaves;
+	/* length of all lists, scalars go along with every element */
+	size_t count;
+	size_t offset;
+} MathBlock;
+
+/* compiled series bodies a context keeps, see series.c */
+#define MATH_SERIES_CACHE 16
+
+typedef struct math_series_body {
+	const MathGroup *group;
+	/* of the program it was compiled for, 0 if the slot is empty */
+	uint64_t generation;
+	/* a series in the body uses another slot meanwhile */
+	bool busy;
+	MathBlock block;
+} MathSeriesBody;
+
+/* value of one expression of a batch */
+typedef struct math_result {
+	number_t value;
+	enum math_error error;
+	int errorNumber;
+} MathResult;
+
+/* count values from lo to hi, evenly apart; the values of one parameter
+ * in a sweep
+ */
+typedef struct math_axis {
+	number_t lo, hi;
+	size_t count;
+} MathAxis;
+
+enum math_sweep_format {
+	/* a header of the names, then a row of the parameters and the
+	 * values of the functions for every point
+	 */
+	SWEEP_CSV,
+	/* native doubles, each column after the other */
+	SWEEP_BINARY,
+};
+
 #define math_seterror(ctx, err, errno) ({ \
 	MathContext *const _ctx = (ctx); \
 	_ctx->error = (err); \
 	_ctx->errorNumber = (errno); \
 })
 
-number_t math_computegroup(MathContext *ctx, MathGroup *group);
-number_t math_computefunction(MathContext *ctx, MathFunction *func);
+number_t math_computegroup(MathContext *ctx, const MathGroup *group);
+number_t math_computefunction(MathContext *ctx, const MathFunction *func);
 number_t math_computevariable(MathContext *ctx, MathVariable *var);
+void math_freecontext(MathContext *ctx);
+
+bool math_bindfunction(MathContext *ctx, MathFunction *func);
+bool math_define(MathContext *ctx, MathProgram *program, const char *text,
+		enum math_definition *definition, size_t *address);
+void math_undefine(MathContext *ctx, MathProgram *program,
+		enum math_definition definition, size_t address);
+int math_redefine(MathContext *ctx, MathProgram *program, const char *text,
+		enum math_definition definition, size_t address);
+bool math_bindprogram(MathContext *ctx, MathProgram *program);
+bool math_setvariable(MathContext *ctx, MathProgram *program,
+		size_t address, number_t value);
+void math_freeprogram(MathContext *ctx, MathProgram *program);
+bool math_references(const MathGroup *group, size_t parameter);
+bool math_isconstant(const MathGroup *group);
+uint64_t math_hashfunction(const MathContext *ctx, const MathFunction *func);
+MathGroup *math_solvedgroup(MathGroup *group, size_t parameter);
+MathGroup *math_copygroup(MathContext *ctx, const MathGroup *group);
+void math_freegroup(MathContext *ctx, MathGroup *group);
+
+MathFunction *math_systemfunction(enum math_system system);
+enum math_system math_systemof(const MathFunction *func);
+enum math_system math_systemtoken(enum math_token_type type);
+
+MathDual math_computedual(MathContext *ctx, const MathFunction *func,
+		size_t parameter);
+MathGroup *math_derivegroup(MathContext *ctx, const MathGroup *group,
+		size_t parameter);
 
 size_t math_pushlocal(MathContext *ctx, number_t value);
 bool math_poplocal(MathContext *ctx);
@@ -144,7 +523,97 @@ bool math_setlocal(MathContext *ctx, size_t addr, number_t value);
 
 char *math_error(MathContext *ctx);
 
+/* vectorizable approximations, see approx.c */
+#define MATH_APPROX(name) \
+	double math_##name(double x); \
+	float math_##name##f(float x); \
+	void math_##name##v(double *restrict y, const double *restrict x, \
+			size_t n); \
+	void math_##name##vf(float *restrict y, const float *restrict x, \
+			size_t n);
+MATH_APPROX(sin)
+MATH_APPROX(cos)
+MATH_APPROX(exp)
+MATH_APPROX(log)
+MATH_APPROX(sqrt)
+MATH_APPROX(erfc)
+MATH_APPROX(gamma)
+#undef MATH_APPROX
+
+bool math_blockfunction(MathContext *ctx, MathBlock *block,
+		const MathFunction *func);
+bool math_computeblock(MathContext *ctx, MathBlock *block,
+		const number_t *const *parameters, size_t count);
+const number_t *math_blockresult(const MathBlock *block, size_t result);
+void math_freeblock(MathBlock *block);
+
+bool math_computecomplexblock(MathContext *ctx, MathBlock *block,
+		const number_t *const *re, const number_t *const *im,
+		size_t count);
+const number_t *math_blockimaginary(const MathBlock *block, size_t result);
+
+bool math_islist(MathContext *ctx, const MathGroup *group);
+bool math_literallist(MathContext *ctx, const MathGroup *group,
+		MathList *list);
+bool math_computelist(MathContext *ctx, const MathGroup *group,
+		MathList *list);
+number_t math_listelement(const MathList *list, size_t index);
+void math_freelist(MathList *list);
+
+number_t math_series(MathContext *ctx, enum math_group_type type,
+		number_t lo, number_t hi,
+		void (*body)(MathContext *ctx, void *arg, number_t *y,
+			const number_t *t, size_t count),
+		void *arg);
+number_t math_computeseries(MathContext *ctx, const MathGroup *group,
+		number_t lo, number_t hi, const number_t *outer);
+void math_freeseries(MathContext *ctx);
+
+bool math_solve(MathContext *ctx, const MathFunction *func, size_t parameter,
+		const number_t *arguments, number_t lo, number_t hi,
+		MathList *roots);
+bool math_solvegroup(MathContext *ctx, const MathGroup *group,
+		MathList *roots);
+
+bool math_sweep(MathContext *ctx, const MathFunction *const *functions,
+		size_t numFunctions, const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, FILE *fp, unsigned numThreads);
+bool math_sweepimage(MathContext *ctx, const MathImage *image,
+		const size_t *functions, size_t numFunctions,
+		const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, FILE *fp, unsigned numThreads);
+
+bool math_writesource(MathContext *ctx, const MathProgram *program,
+		FILE *fp, size_t *failed);
+
+bool math_writeimage(MathContext *ctx, const MathProgram *program,
+		FILE *fp);
+bool math_mapimage(MathContext *ctx, MathImage *image, const char *path);
+void math_unmapimage(MathImage *image);
+bool math_loadimage(MathContext *ctx, MathProgram *program,
+		const MathImage *image);
+size_t math_imagevariable(const MathImage *image, const char *name);
+size_t math_imagefunction(const MathImage *image, const char *name);
+const char *math_imagename(const MathImage *image, size_t function);
+const char *math_imageparameter(const MathImage *image, size_t function,
+		size_t index);
+number_t math_computeimage(MathContext *ctx, const MathImage *image,
+		size_t function);
+
+unsigned math_threadcount(void);
+void math_parallel(const MathProgram *program, size_t count, size_t chunk,
+		void (*work)(MathContext *ctx, void *arg, size_t begin,
+			size_t end),
+		void *arg, unsigned numThreads);
+void math_computebatch(const MathProgram *program,
+		const MathGroup *const *groups, size_t count,
+		MathResult *results, unsigned numThreads);
+void math_evaluatebatch(const MathProgram *program,
+		const char *const *texts, size_t count,
+		MathResult *results, unsigned numThreads);
+
 bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text);
 void math_freetokenizer(MathContext *ctx, MathTokenizer *tokenizer);
 MathGroup *math_parsegroup(MathContext *ctx, MathTokenizer *tokenizer);
+MathGroup *math_parse(MathContext *ctx, const char *text);
 
@@ -1,156 +1,594 @@
 #include "cake.h"
 
+/* the operators by their token, direct indexed; a precedence of zero
+ * means the token is not such an operator
+ */
+struct math_operator {
+	enum math_group_type groupType;
+	int precedence;
+	bool rightAssociative;
+};
+
+/* a sign binds weaker than `^`, so -x^2 is -(x^2) */
+#define PARSE_NEGATE 6
+
+static const struct math_operator parse_infix[] = {
+	/* only directly within `[]` */
+	[TOKEN_RANGE] = { GROUP_RANGE, 1, false },
+	/* only once and outside of any parentheses */
+	[TOKEN_EQUALS] = { GROUP_EQUALS, 1, false },
+
+	[TOKEN_AND] = { GROUP_AND, 2, false },
+	[TOKEN_OR] = { GROUP_OR, 2, false },
+	[TOKEN_XOR] = { GROUP_XOR, 2, false },
+
+	[TOKEN_PLUS] = { GROUP_ADD, 3, false },
+	[TOKEN_MINUS] = { GROUP_SUBTRACT, 3, false },
+
+	[TOKEN_MOD] = { GROUP_MOD, 4, false },
+
+	[TOKEN_MULTIPLY] = { GROUP_MULTIPLY, 5, false },
+	[TOKEN_DIVIDE] = { GROUP_DIVIDE, 5, false },
+
+	/* pow(left, right) */
+	[TOKEN_RAISE] = { GROUP_CALL, 7, true },
+};
+
+/* postfix operators bind strongest and apply to the last operand, so
+ * they need no precedence; they become existing groups:
+ * x! is gamma(x + 1), x% is x / 100 and x° is x * pi / 180
+ */
+static const bool parse_postfix[] = {
+	[TOKEN_BANG] = true,
+	[TOKEN_PERCENT] = true,
+	[TOKEN_DEGREES] = true,
+};
+
+/* what waits on the operator stack for its operands */
+enum parse_pending {
+	PENDING_INFIX,
+	PENDING_NEGATE,
+	PENDING_ROUND,
+	PENDING_CALL,
+	PENDING_LIST,
+};
+
+struct parse_frame {
+	enum parse_pending pending;
+	/* the infix operator */
+	enum math_token_type token;
+	int precedence;
+	/* the call or list that collects its arguments */
+	MathGroup *call;
+	/* number of operands when the parenthesis opened */
+	size_t base;
+};
+
 struct math_parser {
 	MathContext *ctx;
 	MathTokenizer tokens;
+	MathGroup **operands;
+	size_t numOperands, maxOperands;
+	struct parse_frame *frames;
+	size_t numFrames, maxFrames;
 };
 
-struct math_operator {
-	enum math_token_type tokenType;
-	enum math_group_type groupType;
-	int precedence;
-};
+static MathGroup *parse_newgroup(struct math_parser *parser,
+		enum math_group_type type)
+{
+	MathGroup *group;
+
+	group = malloc(sizeof(*group));
+	if (group == NULL) {
+		math_seterror(parser->ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	group->type = type;
+	return group;
+}
 
-static const struct math_operator *get_operator(enum math_token_type type)
+static MathGroup *parse_newnumber(struct math_parser *parser, number_t value)
 {
-	static const struct math_operator precedences[] = {
-		{ TOKEN_AND, GROUP_AND, 1 },
-		{ TOKEN_OR, GROUP_OR, 1 },
-		{ TOKEN_XOR, GROUP_XOR, 1 },
+	MathGroup *group;
 
-		{ TOKEN_PLUS, GROUP_ADD, 2 },
-		{ TOKEN_MINUS, GROUP_SUBTRACT, 2 },
+	group = parse_newgroup(parser, GROUP_NUMBER);
+	if (group != NULL)
+		group->value = value;
+	return group;
+}
 
-		{ TOKEN_MOD, GROUP_MOD, 3 },
+static MathGroup *parse_newbinary(struct math_parser *parser,
+		enum math_group_type type, MathGroup *left, MathGroup *right)
+{
+	MathGroup *group;
 
-		{ TOKEN_MULTIPLY, GROUP_MULTIPLY, 4 },
-		{ TOKEN_DIVIDE, GROUP_DIVIDE, 4 },
-	};
+	if (left == NULL || right == NULL)
+		goto err;
+	group = parse_newgroup(parser, type);
+	if (group == NULL)
+		goto err;
+	group->left = left;
+	group->right = right;
+	return group;
 
-	for(size_t i = 0; i < ARRLEN(precedences); i++)
-		if (precedences[i].tokenType == type)
-			return &precedences[i];
+err:
+	math_freegroup(parser->ctx, left);
+	math_freegroup(parser->ctx, right);
 	return NULL;
-
 }
 
-static bool parser_consumetoken(struct math_parser *parser)
+/* a call with the arguments taken from the top of the operand stack */
+static MathGroup *parse_newcall(struct math_parser *parser,
+		const MathFunction *func, size_t numArguments)
 {
-	if (parser->tokens.numTokens == 0)
-		return false;
-	parser->tokens.tokens++;
-	parser->tokens.numTokens--;
-	return true;
+	MathGroup *group;
+
+	group = parse_newgroup(parser, GROUP_CALL);
+	if (group == NULL)
+		return NULL;
+	group->function = func;
+	group->numArguments = 0;
+	group->callee[0] = '\0';
+	group->arguments = malloc(sizeof(*group->arguments) * numArguments);
+	if (group->arguments == NULL) {
+		math_seterror(parser->ctx, MATH_MEMORY, errno);
+		free(group);
+		return NULL;
+	}
+	parser->numOperands -= numArguments;
+	memcpy(group->arguments, &parser->operands[parser->numOperands],
+			sizeof(*group->arguments) * numArguments);
+	group->numArguments = numArguments;
+	return group;
 }
 
-static bool parser_peektoken(struct math_parser *parser, MathToken *token)
+/* the operand is freed when it can not be pushed */
+static bool parse_pushoperand(struct math_parser *parser, MathGroup *group)
 {
-	if (parser->tokens.numTokens == 0)
+	MathGroup **newOperands;
+	size_t newMax;
+
+	if (group == NULL)
 		return false;
-	*token = *parser->tokens.tokens;
+	if (parser->numOperands == parser->maxOperands) {
+		newMax = parser->maxOperands * 2 + 16;
+		newOperands = realloc(parser->operands,
+				sizeof(*parser->operands) * newMax);
+		if (newOperands == NULL) {
+			math_seterror(parser->ctx, MATH_MEMORY, errno);
+			math_freegroup(parser->ctx, group);
+			return false;
+		}
+		parser->operands = newOperands;
+		parser->maxOperands = newMax;
+	}
+	parser->operands[parser->numOperands++] = group;
 	return true;
 }
 
-static MathGroup *parse_expression(struct math_parser *parser, int precedence)
+static bool parse_pushframe(struct math_parser *parser,
+		struct parse_frame frame)
 {
-	MathToken token;
-	MathGroup *group = NULL, *parent, *right;
-	const struct math_operator *opr;
+	struct parse_frame *newFrames;
+	size_t newMax;
 
-	if (!parser_peektoken(parser, &token))
-		return NULL;
-	switch (token.type) {
-	case TOKEN_PLUS:
-		parser_consumetoken(parser);
-		break;
-	case TOKEN_MINUS:
-		group = malloc(sizeof(*group));
-		if (group == NULL) {
+	if (parser->numFrames == parser->maxFrames) {
+		newMax = parser->maxFrames * 2 + 16;
+		newFrames = realloc(parser->frames,
+				sizeof(*parser->frames) * newMax);
+		if (newFrames == NULL) {
 			math_seterror(parser->ctx, MATH_MEMORY, errno);
-			goto err;
+			if (frame.call != NULL)
+				math_freegroup(parser->ctx, frame.call);
+			return false;
 		}
-		group->type = GROUP_NEGATE;
-		parser_consumetoken(parser);
-		break;
-	default:
+		parser->frames = newFrames;
+		parser->maxFrames = newMax;
 	}
+	parser->frames[parser->numFrames++] = frame;
+	return true;
+}
 
-	parent = group;
-	if (!parser_peektoken(parser, &token)) {
-		math_seterror(parser->ctx, MATH_HANGING_OPERATOR, 0);
-		goto err;
-	}
-	switch(token.type) {
-	case TOKEN_PLUS:
-	case TOKEN_MINUS:
-		math_seterror(parser->ctx, MATH_DOUBLE_PLUS_MINUS, 0);
-		goto err;
-	case TOKEN_NUMBER:
-		group = malloc(sizeof(*group));
-		if (group == NULL) {
-			math_seterror(parser->ctx, MATH_MEMORY, errno);
-			goto err;
+/* applies the operators on top of the stack that bind at least as
+ * strong as the given precedence, parentheses stop it
+ */
+static bool parse_reduce(struct math_parser *parser, int precedence,
+		bool rightAssociative)
+{
+	struct parse_frame *frame;
+	MathGroup *left, *right, *group;
+
+	while (parser->numFrames > 0) {
+		frame = &parser->frames[parser->numFrames - 1];
+		if (frame->pending == PENDING_ROUND ||
+				frame->pending == PENDING_CALL ||
+				frame->pending == PENDING_LIST ||
+				frame->precedence < precedence ||
+				(frame->precedence == precedence &&
+				 rightAssociative))
+			break;
+		parser->numFrames--;
+		right = parser->operands[--parser->numOperands];
+		if (frame->pending == PENDING_NEGATE) {
+			group = parse_newgroup(parser, GROUP_NEGATE);
+			if (group == NULL) {
+				math_freegroup(parser->ctx, right);
+				return false;
+			}
+			group->group = right;
+		} else if (frame->token == TOKEN_RAISE) {
+			if (!parse_pushoperand(parser, right))
+				return false;
+			group = parse_newcall(parser,
+					math_systemfunction(SYSTEM_POW), 2);
+		} else {
+			left = parser->operands[--parser->numOperands];
+			group = parse_newbinary(parser,
+					parse_infix[frame->token].groupType,
+					left, right);
 		}
-		group->type = GROUP_NUMBER;
-		group->value = token.value;
+		if (!parse_pushoperand(parser, group))
+			return false;
+	}
+	return true;
+}
+
+static bool parse_postfixoperator(struct math_parser *parser,
+		enum math_token_type type)
+{
+	MathGroup *operand = parser->operands[--parser->numOperands];
+	MathGroup *group;
+
+	switch (type) {
+	case TOKEN_BANG:
+		group = parse_newbinary(parser, GROUP_ADD, operand,
+				parse_newnumber(parser, 1));
+		if (!parse_pushoperand(parser, group))
+			return false;
+		group = parse_newcall(parser,
+				math_systemfunction(SYSTEM_GAMMA), 1);
 		break;
-	case TOKEN_OPEN_ROUND:
-		parser_consumetoken(parser);
-		group = parse_expression(parser, 0);
+	case TOKEN_PERCENT:
+		group = parse_newbinary(parser, GROUP_DIVIDE, operand,
+				parse_newnumber(parser, 100));
 		break;
 	default:
-		math_seterror(parser->ctx, MATH_INVALID_TOKEN, 0);
-		goto err;
+		group = parse_newbinary(parser, GROUP_MULTIPLY, operand,
+				parse_newnumber(parser, M_PI / 180));
+	}
+	return parse_pushoperand(parser, group);
+}
+
+/* a name, system function or series followed by `(` */
+static bool parse_opencall(struct math_parser *parser,
+		enum math_group_type type, const MathFunction *func,
+		const MathToken *token)
+{
+	MathGroup *group;
+
+	group = parse_newgroup(parser, type);
+	if (group == NULL)
+		return false;
+	/* user functions are NULL and resolved by name when binding */
+	group->function = func;
+	group->arguments = NULL;
+	group->numArguments = 0;
+	group->callee[0] = '\0';
+	if (type == GROUP_CALL && func == NULL)
+		strcpy(group->callee, token->word);
+	return parse_pushframe(parser, (struct parse_frame) {
+		.pending = PENDING_CALL,
+		.call = group,
+		.base = parser->numOperands,
+	});
+}
+
+/* `[` opens a list that collects its elements like a call */
+static bool parse_openlist(struct math_parser *parser)
+{
+	MathGroup *group;
+
+	group = parse_newgroup(parser, GROUP_LIST);
+	if (group == NULL)
+		return false;
+	group->function = NULL;
+	group->arguments = NULL;
+	group->numArguments = 0;
+	group->callee[0] = '\0';
+	return parse_pushframe(parser, (struct parse_frame) {
+		.pending = PENDING_LIST,
+		.call = group,
+		.base = parser->numOperands,
+	});
+}
+
+/* the arguments of the call or list on top of the stack were parsed */
+static bool parse_closecall(struct math_parser *parser)
+{
+	struct parse_frame *const frame =
+		&parser->frames[--parser->numFrames];
+	const size_t numArguments = parser->numOperands - frame->base;
+	MathGroup *const group = frame->call;
+
+	if ((group->function != NULL &&
+			numArguments != group->function->numParameters) ||
+			/* a series binds a name for its body */
+			(group->type >= GROUP_SUM &&
+			 group->type <= GROUP_COMPLEX &&
+			 (numArguments != (group->type == GROUP_CURVE ? 5 :
+					   group->type == GROUP_COMPLEX ?
+					   2 : 4) ||
+			  parser->operands[frame->base]->type !=
+			  GROUP_VARIABLE))) {
+		math_seterror(parser->ctx, MATH_INVALID_CALL, 0);
+		math_freegroup(parser->ctx, group);
+		return false;
 	}
-	if (parent != NULL) {
-		parent->group = group;
-		group = parent;
+	group->arguments = malloc(sizeof(*group->arguments) * numArguments);
+	if (group->arguments == NULL) {
+		math_seterror(parser->ctx, MATH_MEMORY, errno);
+		math_freegroup(parser->ctx, group);
+		return false;
 	}
-	parser_consumetoken(parser);
-	if (!parser_peektoken(parser, &token) ||
-			token.type == TOKEN_CLOSED_ROUND)
-		return group;
+	parser->numOperands = frame->base;
+	memcpy(group->arguments, &parser->operands[frame->base],
+			sizeof(*group->arguments) * numArguments);
+	group->numArguments = numArguments;
+	return parse_pushoperand(parser, group);
+}
 
-	while ((opr = get_operator(token.type)) != NULL) {
-		if (opr->precedence <= precedence)
-			break;
-		parent = malloc(sizeof(*parent));
-		if (parent == NULL) {
-			parser->ctx->error = MATH_MEMORY;
-			parser->ctx->errorNumber = errno;
-			goto err;
+/* operator precedence parsing with explicit stacks, so the nesting is
+ * only limited by memory and every token is handled once
+ */
+static MathGroup *parse_expression(struct math_parser *parser)
+{
+	const MathToken *token, *next;
+	bool expectOperand = true, sign = false, equals = false;
+	enum math_token_type type;
+	MathGroup *group;
+
+	for (size_t i = 0; i <= parser->tokens.numTokens; i++) {
+		token = i < parser->tokens.numTokens ?
+			&parser->tokens.tokens[i] : NULL;
+		next = i + 1 < parser->tokens.numTokens ?
+			&parser->tokens.tokens[i + 1] : NULL;
+		type = token == NULL ? TOKEN_NULL : token->type;
+
+		if (expectOperand) {
+			if (sign && (type == TOKEN_PLUS ||
+						type == TOKEN_MINUS)) {
+				math_seterror(parser->ctx,
+						MATH_DOUBLE_PLUS_MINUS, 0);
+				return NULL;
+			}
+			sign = false;
+			switch (type) {
+			case TOKEN_NULL:
+				math_seterror(parser->ctx,
+						MATH_HANGING_OPERATOR, 0);
+				return NULL;
+			case TOKEN_PLUS:
+				sign = true;
+				continue;
+			case TOKEN_MINUS:
+				sign = true;
+				if (!parse_pushframe(parser,
+						(struct parse_frame) {
+					.pending = PENDING_NEGATE,
+					.precedence = PARSE_NEGATE,
+				}))
+					return NULL;
+				continue;
+			case TOKEN_OPEN_ROUND:
+				if (!parse_pushframe(parser,
+						(struct parse_frame) {
+					.pending = PENDING_ROUND,
+					.base = parser->numOperands,
+				}))
+					return NULL;
+				continue;
+			case TOKEN_OPEN_CORNER:
+				if (!parse_openlist(parser))
+					return NULL;
+				continue;
+			case TOKEN_NUMBER:
+				if (!parse_pushoperand(parser,
+						parse_newnumber(parser,
+							token->value)))
+					return NULL;
+				break;
+			case TOKEN_VARIABLE:
+				if (next != NULL &&
+						next->type == TOKEN_OPEN_ROUND) {
+					if (!parse_opencall(parser, GROUP_CALL,
+								NULL, token))
+						return NULL;
+					i++;
+					continue;
+				}
+				group = parse_newgroup(parser,
+						GROUP_VARIABLE);
+				if (group != NULL)
+					strcpy(group->name, token->word);
+				if (!parse_pushoperand(parser, group))
+					return NULL;
+				break;
+			case TOKEN_SUM:
+			case TOKEN_PROD:
+			case TOKEN_INTEGRAL:
+			case TOKEN_SOLVE:
+			case TOKEN_CURVE:
+			case TOKEN_COMPLEX_NUMBERS:
+				if (next == NULL ||
+						next->type != TOKEN_OPEN_ROUND) {
+					math_seterror(parser->ctx,
+						MATH_INVALID_CALL, 0);
+					return NULL;
+				}
+				if (!parse_opencall(parser, GROUP_SUM +
+						(type - TOKEN_SUM), NULL,
+						token))
+					return NULL;
+				i++;
+				continue;
+			default:
+				if (math_systemtoken(type) != SYSTEM_NONE) {
+					if (next == NULL || next->type !=
+							TOKEN_OPEN_ROUND) {
+						math_seterror(parser->ctx,
+							MATH_INVALID_CALL, 0);
+						return NULL;
+					}
+					if (!parse_opencall(parser, GROUP_CALL,
+						math_systemfunction(
+						math_systemtoken(type)),
+								token))
+						return NULL;
+					i++;
+					continue;
+				}
+				if (parser->numFrames > 0 &&
+						parser->frames[parser->numFrames
+						- 1].pending == PENDING_CALL)
+					math_seterror(parser->ctx,
+							MATH_INVALID_CALL, 0);
+				else
+					math_seterror(parser->ctx,
+							MATH_INVALID_TOKEN, 0);
+				return NULL;
+			}
+			expectOperand = false;
+			continue;
 		}
-		parent->type = opr->groupType;
-		parent->left = group;
-		parent->right = NULL;
-		group = parent;
-
-		parser_consumetoken(parser);
-		if (!parser_peektoken(parser, &token)) {
-			math_seterror(parser->ctx, MATH_HANGING_OPERATOR, 0);
-			goto err;
+
+		if (type < ARRLEN(parse_infix) &&
+				parse_infix[type].precedence > 0) {
+			if (!parse_reduce(parser, parse_infix[type].precedence,
+					parse_infix[type].rightAssociative))
+				return NULL;
+			/* a range is no operand and only an element */
+			if (parser->operands[parser->numOperands - 1]->type ==
+					GROUP_RANGE || (type == TOKEN_RANGE &&
+					(parser->numFrames == 0 ||
+					 parser->frames[parser->numFrames -
+					 1].pending != PENDING_LIST))) {
+				math_seterror(parser->ctx, MATH_INVALID_RANGE,
+						0);
+				return NULL;
+			}
+			if (type == TOKEN_EQUALS) {
+				if (equals || parser->numFrames > 0) {
+					math_seterror(parser->ctx,
+							MATH_INVALID_TOKEN, 0);
+					return NULL;
+				}
+				equals = true;
+			}
+			if (!parse_pushframe(parser,
+						(struct parse_frame) {
+					.pending = PENDING_INFIX,
+					.token = type,
+					.precedence =
+						parse_infix[type].precedence,
+				}))
+				return NULL;
+			expectOperand = true;
+			continue;
 		}
-		right = parse_expression(parser, opr->precedence);
-		if (right == NULL)
-			goto err;
-		group->right = right;
-		if (!parser_peektoken(parser, &token))
+		if (type < ARRLEN(parse_postfix) && parse_postfix[type]) {
+			if (!parse_postfixoperator(parser, type))
+				return NULL;
+			continue;
+		}
+		if (!parse_reduce(parser, 0, false))
+			return NULL;
+		switch (type) {
+		case TOKEN_NULL:
+			if (parser->numFrames > 0) {
+				math_seterror(parser->ctx, MATH_UNBALANCED, 0);
+				return NULL;
+			}
+			return parser->operands[--parser->numOperands];
+		case TOKEN_COMMA:
+			if (parser->numFrames == 0 ||
+					(parser->frames[parser->numFrames -
+					 1].pending != PENDING_CALL &&
+					 parser->frames[parser->numFrames -
+					 1].pending != PENDING_LIST)) {
+				math_seterror(parser->ctx, MATH_INVALID_CALL,
+						0);
+				return NULL;
+			}
+			expectOperand = true;
+			break;
+		case TOKEN_CLOSED_ROUND:
+			if (parser->numFrames == 0) {
+				math_seterror(parser->ctx, MATH_UNBALANCED, 0);
+				return NULL;
+			}
+			if (parser->frames[parser->numFrames - 1].pending ==
+					PENDING_ROUND) {
+				parser->numFrames--;
+			} else if (parser->frames[parser->numFrames -
+					1].pending != PENDING_CALL) {
+				math_seterror(parser->ctx, MATH_UNBALANCED, 0);
+				return NULL;
+			} else if (!parse_closecall(parser)) {
+				return NULL;
+			}
+			break;
+		case TOKEN_CLOSED_CORNER:
+			if (parser->numFrames == 0 ||
+					parser->frames[parser->numFrames -
+					1].pending != PENDING_LIST) {
+				math_seterror(parser->ctx, MATH_UNBALANCED, 0);
+				return NULL;
+			}
+			if (!parse_closecall(parser))
+				return NULL;
 			break;
+		default:
+			math_seterror(parser->ctx, MATH_INVALID_TOKEN, 0);
+			return NULL;
+		}
 	}
-	return group;
-
-err:
-	free(group);
-	/* TODO: call a function to deallocate even the sub groups */
+	/* the end of the tokens returns */
 	return NULL;
 }
 
-
 MathGroup *math_parsegroup(MathContext *ctx, MathTokenizer *tokenizer)
 {
 	struct math_parser parser;
+	MathGroup *group;
 
+	memset(&parser, 0, sizeof(parser));
 	parser.ctx = ctx;
 	parser.tokens = *tokenizer;
-	return parse_expression(&parser, 0);
+	group = parse_expression(&parser);
+	/* left when parsing failed */
+	for (size_t i = 0; i < parser.numOperands; i++)
+		math_freegroup(ctx, parser.operands[i]);
+	for (size_t i = 0; i < parser.numFrames; i++)
+		if (parser.frames[i].call != NULL)
+			math_freegroup(ctx, parser.frames[i].call);
+	free(parser.operands);
+	free(parser.frames);
+	return group;
+}
+
+/* tokenizes and parses the text */
+MathGroup *math_parse(MathContext *ctx, const char *text)
+{
+	MathTokenizer tokenizer;
+	MathGroup *group;
+
+	memset(&tokenizer, 0, sizeof(tokenizer));
+	math_seterror(ctx, MATH_SUCCESS, 0);
+	if (!math_tokenize(ctx, &tokenizer, text)) {
+		math_freetokenizer(ctx, &tokenizer);
+		return NULL;
+	}
+	group = math_parsegroup(ctx, &tokenizer);
+	math_freetokenizer(ctx, &tokenizer);
+	return group;
 }
@@ -0,0 +1,1433 @@
+#include "cake.h"
+
+int plot_init(Plot *plot, int width, int height)
+{
+	memset(plot, 0, sizeof(*plot));
+	/* the format of the streaming texture of the window, so the
+	 * pixels are copied without conversion
+	 */
+	plot->surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+			PLOT_FORMAT);
+	if (plot->surface == NULL) {
+		fprintf(stderr, "Failed creating plot surface: %s\n",
+				SDL_GetError());
+		return -1;
+	}
+	plot->zoom = 10;
+	plot->translation = (Vector) {
+		-width / 20.0, -height / 20.0
+	};
+	plot->image = (SDL_Rect) { 0, 0, width, height };
+	plot->scale = 1;
+	/* works without the cache */
+	tile_init(&plot->tiles, TILE_MEMORY);
+	return 0;
+}
+
+/* replaces the surface with one of width x height, the top left pixel
+ * stays where it is
+ */
+int plot_resize(Plot *plot, int width, int height)
+{
+	SDL_Surface *surface;
+
+	surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+			PLOT_FORMAT);
+	if (surface == NULL) {
+		fprintf(stderr, "Failed creating plot surface: %s\n",
+				SDL_GetError());
+		return -1;
+	}
+	SDL_FreeSurface(plot->surface);
+	plot->surface = surface;
+	plot->image = (SDL_Rect) { 0, 0, width, height };
+	return 0;
+}
+
+void plot_uninit(Plot *plot)
+{
+	tile_uninit(&plot->tiles);
+	SDL_FreeSurface(plot->surface);
+	free(plot->samples);
+}
+
+/* draws the segment from (x0, y0) to (x1, y1) of the image, clipped to
+ * the surface
+ */
+static void plot_drawsegment(const Plot *plot, float x0, float y0,
+		float x1, float y1, Uint32 color)
+{
+	SDL_Surface *const surface = plot->surface;
+	Uint32 *const pixels = surface->pixels;
+	const Sint32 pitch = surface->pitch / sizeof(*pixels);
+	float dx, dy;
+	Sint32 steps;
+
+	dx = x1 - x0;
+	dy = y1 - y0;
+	steps = fabsf(dx) > fabsf(dy) ? fabsf(dx) : fabsf(dy);
+	steps++;
+	dx /= steps;
+	dy /= steps;
+	for (Sint32 s = 0; s <= steps; s++) {
+		/* rounded down so that what is left of the surface is
+		 * not drawn at its edge
+		 */
+		const Sint32 x = floorf(x0 + dx * s + 0.5f) - plot->image.x;
+		const Sint32 y = floorf(y0 + dy * s + 0.5f) - plot->image.y;
+		if (x < 0 || y < 0 || x >= surface->w || y >= surface->h)
+			continue;
+		pixels[x + y * pitch] = color;
+	}
+}
+
+/* function whose zero contour is drawn */
+struct contour {
+	Plot *plot;
+	MathContext *ctx;
+	const MathFunction *function;
+	size_t xAddr, yAddr;
+	Uint32 color;
+};
+
+/* crossing on edge n of the cell at (i, j) of the image, going from
+ * corner n to n + 1, interpolated linearly and then improved by one Newton
+ * step along the edge if that step stays on it
+ */
+static void plot_crossing(struct contour *contour, Sint32 i, Sint32 j,
+		const sample_t *v, Sint32 n, float *px, float *py)
+{
+	Plot *const plot = contour->plot;
+	MathContext *const ctx = contour->ctx;
+	const bool horizontal = n % 2 == 0;
+	MathDual dual;
+	float t, lo, step;
+
+	t = v[n] / (v[n] - v[(n + 1) % 4]);
+	if (n >= 2)
+		t = 1 - t;
+	*px = n == 1 ? i + 1 : n == 3 ? i : i + t;
+	*py = n == 2 ? j + 1 : n == 0 ? j : j + t;
+
+	math_setlocal(ctx, contour->xAddr,
+			*px / plot->zoom + plot->translation.x);
+	math_setlocal(ctx, contour->yAddr,
+			-(*py / plot->zoom + plot->translation.y));
+	if (horizontal) {
+		dual = math_computedual(ctx, contour->function, 0);
+		step = dual.value / dual.derivative * plot->zoom;
+		lo = i;
+		if (isfinite(step) && *px - step >= lo && *px - step <= lo + 1)
+			*px -= step;
+	} else {
+		dual = math_computedual(ctx, contour->function, 1);
+		step = -dual.value / dual.derivative * plot->zoom;
+		lo = j;
+		if (isfinite(step) && *py - step >= lo && *py - step <= lo + 1)
+			*py -= step;
+	}
+}
+
+/* marching squares over the padded sample grid; the sample at (i, j)
+ * lies on pixel (i, j) and each cell emits up to two line segments
+ * between crossings on the cell edges
+ */
+static void plot_contour(struct contour *contour, const sample_t *values,
+		Sint32 stride)
+{
+	/* corner order: top left, top right, bottom right, bottom left */
+	static const Sint8 edges[16][4] = {
+		[1] = { 3, 0, -1, -1 }, [2] = { 0, 1, -1, -1 },
+		[3] = { 3, 1, -1, -1 }, [4] = { 1, 2, -1, -1 },
+		[5] = { 3, 0, 1, 2 }, [6] = { 0, 2, -1, -1 },
+		[7] = { 3, 2, -1, -1 }, [8] = { 2, 3, -1, -1 },
+		[9] = { 0, 2, -1, -1 }, [10] = { 0, 1, 2, 3 },
+		[11] = { 1, 2, -1, -1 }, [12] = { 1, 3, -1, -1 },
+		[13] = { 0, 1, -1, -1 }, [14] = { 0, 3, -1, -1 },
+	};
+	const Plot *const plot = contour->plot;
+	SDL_Surface *const surface = plot->surface;
+
+	for (Sint32 j = -1; j < surface->h; j++) {
+		const sample_t *const row = &values[(j + 1) * stride + 1];
+		for (Sint32 i = -1; i < surface->w; i++) {
+			const sample_t v[4] = {
+				row[i], row[i + 1],
+				row[i + 1 + stride], row[i + stride]
+			};
+			float px[4], py[4];
+			Sint32 config = 0;
+			Sint32 n;
+
+			for (n = 0; n < 4; n++)
+				config |= (v[n] > 0) << n;
+			if (config == 0 || config == 15)
+				continue;
+			if (isnan(v[0]) || isnan(v[1]) ||
+					isnan(v[2]) || isnan(v[3]))
+				continue;
+			/* resolve the saddle with the cell center */
+			if ((config == 5 || config == 10) &&
+					v[0] + v[1] + v[2] + v[3] > 0)
+				config ^= 15;
+			const Sint8 *const e = edges[config];
+			for (n = 0; n < 4 && e[n] >= 0; n++)
+				plot_crossing(contour, i + plot->image.x,
+						j + plot->image.y, v, e[n],
+						&px[n], &py[n]);
+			plot_drawsegment(contour->plot, px[0], py[0], px[1],
+					py[1], contour->color);
+			if (n == 4)
+				plot_drawsegment(contour->plot, px[2], py[2],
+						px[3], py[3], contour->color);
+		}
+	}
+}
+
+/* curve of an explicit function `y = g(x)` (or `x = g(y)` when vertical),
+ * sampled once per pixel along the independent axis u and drawn as a
+ * polyline in the dependent pixel coordinate v, both in the image
+ */
+struct explicit_curve {
+	Plot *plot;
+	MathContext *ctx;
+	MathFunction function;
+	size_t address;
+	bool vertical;
+	float extent;
+	Uint32 color;
+};
+
+static float plot_sampleexplicit(struct explicit_curve *curve, float u)
+{
+	Plot *const plot = curve->plot;
+	MathContext *const ctx = curve->ctx;
+	number_t a, b;
+
+	if (curve->vertical) {
+		a = -(u / plot->zoom + plot->translation.y);
+		math_setlocal(ctx, curve->address, a);
+		b = math_computefunction(ctx, &curve->function);
+		return (b - plot->translation.x) * plot->zoom;
+	}
+	a = u / plot->zoom + plot->translation.x;
+	math_setlocal(ctx, curve->address, a);
+	b = math_computefunction(ctx, &curve->function);
+	return (-b - plot->translation.y) * plot->zoom;
+}
+
+/* subdivides [u0, u1] until each piece moves at most a pixel along v;
+ * a jump that survives all subdivisions is a discontinuity and left open
+ */
+static void plot_refineexplicit(struct explicit_curve *curve,
+		float u0, float v0, float u1, float v1, int depth)
+{
+	float um, vm;
+
+	if (isfinite(v0) && isfinite(v1)) {
+		if ((v0 < 0 && v1 < 0) ||
+				(v0 > curve->extent && v1 > curve->extent))
+			return;
+		if (fabsf(v1 - v0) <= 1 || (depth == 0 &&
+					fabsf(v1 - v0) < curve->extent)) {
+			v0 = MIN(MAX(v0, -1.0f), curve->extent + 1);
+			v1 = MIN(MAX(v1, -1.0f), curve->extent + 1);
+			if (curve->vertical)
+				plot_drawsegment(curve->plot, v0, u0, v1, u1,
+						curve->color);
+			else
+				plot_drawsegment(curve->plot, u0, v0, u1, v1,
+						curve->color);
+			return;
+		}
+	} else if (!isfinite(v0) && !isfinite(v1)) {
+		return;
+	}
+	if (depth == 0)
+		return;
+	um = (u0 + u1) / 2;
+	vm = plot_sampleexplicit(curve, um);
+	plot_refineexplicit(curve, u0, v0, um, vm, depth - 1);
+	plot_refineexplicit(curve, um, vm, u1, v1, depth - 1);
+}
+
+/* intervals a parametric curve is sampled in before it is subdivided */
+#define PLOT_CURVE_SAMPLES 256
+/* halvings of each of them at most */
+#define PLOT_CURVE_DEPTH 12
+
+/* parametric curve `curve(t, a, b, x, y)`, the components are functions
+ * of the parameters of the equation and then t, which are NaN but t
+ */
+struct parametric_curve {
+	Plot *plot;
+	MathContext *ctx;
+	MathFunction x, y;
+	Uint32 color;
+};
+
+/* the point of the curve at t in the pixels of the image */
+static void plot_parametricpoint(struct parametric_curve *curve,
+		number_t t, float *px, float *py)
+{
+	Plot *const plot = curve->plot;
+	MathContext *const ctx = curve->ctx;
+	const size_t numLocals = ctx->numLocals;
+	number_t x = NAN, y = NAN;
+
+	for (size_t i = 1; i < curve->x.numParameters; i++)
+		if (math_pushlocal(ctx, NAN) == (size_t) -1)
+			goto end;
+	if (math_pushlocal(ctx, t) == (size_t) -1)
+		goto end;
+	x = math_computefunction(ctx, &curve->x);
+	y = math_computefunction(ctx, &curve->y);
+
+end:
+	ctx->numLocals = numLocals;
+	*px = (x - plot->translation.x) * plot->zoom;
+	*py = (-y - plot->translation.y) * plot->zoom;
+}
+
+/* whether the points lie beyond the same edge of the surface by more
+ * than the margin
+ */
+static bool plot_beyond(const Plot *plot, const float *xs, const float *ys,
+		size_t count, float margin)
+{
+	const float left = plot->image.x - margin;
+	const float top = plot->image.y - margin;
+	const float right = plot->image.x + plot->surface->w + margin;
+	const float bottom = plot->image.y + plot->surface->h + margin;
+	int sides = 15;
+
+	for (size_t i = 0; i < count; i++)
+		sides &= (xs[i] < left) | (xs[i] > right) << 1 |
+			(ys[i] < top) << 2 | (ys[i] > bottom) << 3;
+	return sides != 0;
+}
+
+/* subdivides [t0, t1] until the middle point is within half a pixel of
+ * the middle of the chord, then draws the two halves as segments; pieces
+ * that are still apart at the deepest level are left open
+ */
+static void plot_refineparametric(struct parametric_curve *curve,
+		number_t t0, float x0, float y0,
+		number_t t1, float x1, float y1, int depth)
+{
+	const number_t tm = (t0 + t1) / 2;
+	float xs[3], ys[3];
+	const Plot *const plot = curve->plot;
+	float ex, ey, deviation;
+
+	if (!(isfinite(x0) && isfinite(y0)) &&
+			!(isfinite(x1) && isfinite(y1)))
+		return;
+	plot_parametricpoint(curve, tm, &xs[1], &ys[1]);
+	xs[0] = x0;
+	ys[0] = y0;
+	xs[2] = x1;
+	ys[2] = y1;
+	ex = xs[1] - (x0 + x1) / 2;
+	ey = ys[1] - (y0 + y1) / 2;
+	deviation = sqrtf(ex * ex + ey * ey);
+	if (isfinite(x0) && isfinite(y0) && isfinite(x1) && isfinite(y1) &&
+			isfinite(deviation)) {
+		/* the curve between them bulges about twice as far */
+		if (plot_beyond(plot, xs, ys, 3, 2 * deviation + 1))
+			return;
+		if (deviation <= 0.5f || (depth == 0 &&
+					fabsf(x1 - x0) < plot->image.w &&
+					fabsf(y1 - y0) < plot->image.h)) {
+			plot_drawsegment(curve->plot, x0, y0, xs[1], ys[1],
+					curve->color);
+			plot_drawsegment(curve->plot, xs[1], ys[1], x1, y1,
+					curve->color);
+			return;
+		}
+	}
+	if (depth == 0)
+		return;
+	plot_refineparametric(curve, t0, x0, y0, tm, xs[1], ys[1], depth - 1);
+	plot_refineparametric(curve, tm, xs[1], ys[1], t1, x1, y1, depth - 1);
+}
+
+/* samples the curve at PLOT_CURVE_SAMPLES + 1 points, both components in
+ * one block, and subdivides each interval
+ */
+static void plot_parametric(Plot *plot, MathContext *ctx,
+		const MathGroup *group, Uint32 color)
+{
+	const size_t index = group->arguments[0]->index;
+	number_t nans[MATH_BLOCK], ts[MATH_BLOCK];
+	const number_t *parameters[index + 1];
+	float xs[PLOT_CURVE_SAMPLES + 1], ys[PLOT_CURVE_SAMPLES + 1];
+	struct parametric_curve curve;
+	MathFunction bound;
+	MathBlock block;
+	number_t lo, hi;
+	size_t n;
+
+	if (group->arguments[0]->type != GROUP_PARAMETER)
+		return;
+	memset(&curve, 0, sizeof(curve));
+	curve.plot = plot;
+	curve.ctx = ctx;
+	curve.color = color;
+	curve.x.group = group->arguments[3];
+	curve.y.group = group->arguments[4];
+	curve.x.numParameters = index + 1;
+	curve.y.numParameters = index + 1;
+	/* the bounds see the parameters around as NaN */
+	memset(&bound, 0, sizeof(bound));
+	bound.numParameters = index + 1;
+	for (size_t i = 0; i < MATH_BLOCK; i++)
+		nans[i] = NAN;
+	for (size_t i = 0; i <= index; i++)
+		if (math_pushlocal(ctx, NAN) == (size_t) -1)
+			return;
+	bound.group = group->arguments[1];
+	lo = math_computefunction(ctx, &bound);
+	bound.group = group->arguments[2];
+	hi = math_computefunction(ctx, &bound);
+	ctx->numLocals -= index + 1;
+	if (!isfinite(lo) || !isfinite(hi))
+		return;
+
+	memset(&block, 0, sizeof(block));
+	if (!math_blockfunction(ctx, &block, &curve.x) ||
+			!math_blockfunction(ctx, &block, &curve.y)) {
+		fprintf(stderr, "Failed sampling the curve: %s\n",
+				math_error(ctx));
+		goto end;
+	}
+	for (size_t i = 0; i < index; i++)
+		parameters[i] = nans;
+	parameters[index] = ts;
+	for (size_t i = 0; i <= PLOT_CURVE_SAMPLES; i += MATH_BLOCK) {
+		n = MIN(PLOT_CURVE_SAMPLES + 1 - i, (size_t) MATH_BLOCK);
+		for (size_t k = 0; k < n; k++)
+			ts[k] = lo + (hi - lo) * (number_t) (i + k) /
+				PLOT_CURVE_SAMPLES;
+		if (!math_computeblock(ctx, &block, parameters, n))
+			goto end;
+		for (size_t k = 0; k < n; k++) {
+			xs[i + k] = (math_blockresult(&block, 0)[k] -
+					plot->translation.x) * plot->zoom;
+			ys[i + k] = (-math_blockresult(&block, 1)[k] -
+					plot->translation.y) * plot->zoom;
+		}
+	}
+	for (size_t i = 0; i < PLOT_CURVE_SAMPLES; i++)
+		plot_refineparametric(&curve,
+				lo + (hi - lo) * (number_t) i /
+				PLOT_CURVE_SAMPLES, xs[i], ys[i],
+				lo + (hi - lo) * (number_t) (i + 1) /
+				PLOT_CURVE_SAMPLES, xs[i + 1], ys[i + 1],
+				PLOT_CURVE_DEPTH);
+
+end:
+	math_freeblock(&block);
+}
+
+/* colors each pixel by the value of the body at z = x + iy, computed in
+ * complex blocks: the hue is its argument and the brightness rises from
+ * 0.6 to 1 within each doubling of its modulus, zeros are black and NaN
+ * keeps the pixel
+ */
+static void plot_domain(Plot *plot, MathContext *ctx, const MathGroup *group)
+{
+	SDL_Surface *const surface = plot->surface;
+	const SDL_PixelFormat *const format = surface->format;
+	Uint32 *const pixels = surface->pixels;
+	const Sint32 pitch = surface->pitch / sizeof(*pixels);
+	const number_t invZoom = 1 / plot->zoom;
+	number_t xs[MATH_BLOCK], ys[MATH_BLOCK];
+	/* the body sees x, y and z */
+	const number_t *const re[] = { xs, ys, xs };
+	const number_t *const im[] = { NULL, NULL, ys };
+	float moduli[MATH_BLOCK], logs[MATH_BLOCK], squares[MATH_BLOCK];
+	MathFunction body;
+	MathBlock block;
+
+	if (group->arguments[0]->type != GROUP_PARAMETER ||
+			group->arguments[0]->index + 1 != ARRLEN(re))
+		return;
+	memset(&body, 0, sizeof(body));
+	body.group = group->arguments[1];
+	body.numParameters = ARRLEN(re);
+	memset(&block, 0, sizeof(block));
+	if (!math_blockfunction(ctx, &block, &body))
+		goto err;
+	for (Sint32 j = 0; j < surface->h; j++) {
+		const number_t y = -((j + plot->image.y) * invZoom +
+				plot->translation.y);
+		Uint32 *const out = &pixels[j * pitch];
+
+		for (Sint32 k = 0; k < MATH_BLOCK; k++)
+			ys[k] = y;
+		for (Sint32 i = 0; i < surface->w; i += MATH_BLOCK) {
+			const Sint32 m = MIN(surface->w - i, MATH_BLOCK);
+			const number_t *wr, *wi;
+
+			for (Sint32 k = 0; k < m; k++)
+				xs[k] = (i + k + plot->image.x) * invZoom +
+					plot->translation.x;
+			if (!math_computecomplexblock(ctx, &block, re, im, m))
+				goto err;
+			wr = math_blockresult(&block, 0);
+			wi = math_blockimaginary(&block, 0);
+			for (Sint32 k = 0; k < m; k++)
+				squares[k] = wr[k] * wr[k] + wi[k] * wi[k];
+			math_sqrtvf(moduli, squares, m);
+			math_logvf(logs, squares, m);
+			for (Sint32 k = 0; k < m; k++) {
+				const bool valid = isfinite(squares[k]) &&
+					moduli[k] > 0;
+				const float u = valid ? wr[k] / moduli[k] : 0;
+				const float v = valid ? wi[k] / moduli[k] : 0;
+				/* log2 |w| */
+				const float t = valid ?
+					logs[k] * (0.5f / M_LN2) : 0;
+				const float shade = valid ?
+					(0.6f + 0.4f * (t - floorf(t))) * 255 :
+					0;
+				const Uint32 p = format->Amask |
+					(Uint32) ((0.5f + 0.5f * u) * shade) <<
+					format->Rshift |
+					(Uint32) ((0.5f - 0.25f * u +
+						0.433f * v) * shade) <<
+					format->Gshift |
+					(Uint32) ((0.5f - 0.25f * u -
+						0.433f * v) * shade) <<
+					format->Bshift;
+
+				out[i + k] = squares[k] == squares[k] ? p :
+					out[i + k];
+			}
+		}
+	}
+	math_freeblock(&block);
+	return;
+
+err:
+	fprintf(stderr, "Failed sampling the complex body: %s\n",
+			math_error(ctx));
+	math_freeblock(&block);
+}
+
+/* plots the function in O(w) if it is explicit in x or y, a parametric
+ * curve or complex, returns false if the full grid must be sampled
+ * instead
+ */
+static bool plot_explicit(Plot *plot, MathContext *ctx,
+		const MathFunction *func,
+		size_t xAddr, size_t yAddr, Uint32 color)
+{
+	struct explicit_curve curve;
+	MathGroup *group;
+	Sint32 first, length;
+	float u, v, prev;
+
+	if (func->group->type == GROUP_CURVE) {
+		plot_parametric(plot, ctx, func->group, color);
+		return true;
+	}
+	if (func->group->type == GROUP_COMPLEX) {
+		plot_domain(plot, ctx, func->group);
+		return true;
+	}
+	curve.plot = plot;
+	curve.ctx = ctx;
+	curve.function = *func;
+	curve.color = color;
+	if ((group = math_solvedgroup(func->group, 1)) != NULL) {
+		curve.vertical = false;
+		curve.address = xAddr;
+		curve.extent = plot->image.h;
+		first = plot->image.x;
+		length = plot->surface->w;
+	} else if ((group = math_solvedgroup(func->group, 0)) != NULL) {
+		curve.vertical = true;
+		curve.address = yAddr;
+		curve.extent = plot->image.w;
+		first = plot->image.y;
+		length = plot->surface->h;
+	} else {
+		return false;
+	}
+	curve.function.group = group;
+
+	prev = plot_sampleexplicit(&curve, first - 1);
+	for (Sint32 i = 0; i <= length; i++) {
+		u = first + i;
+		v = plot_sampleexplicit(&curve, u);
+		plot_refineexplicit(&curve, u - 1, prev, u, v, 8);
+		prev = v;
+	}
+	return true;
+}
+
+/* makes room for the samples of count equations on a width x height
+ * surface
+ */
+static bool plot_reservesamples(Plot *plot, Sint32 width, Sint32 height,
+		size_t count)
+{
+	const size_t numSamples = (size_t) (width + 2) *
+		(size_t) (height + 2) * count;
+	sample_t *newSamples;
+
+	if (numSamples <= plot->numSamples)
+		return true;
+	newSamples = realloc(plot->samples, sizeof(*plot->samples) *
+			numSamples);
+	if (newSamples == NULL) {
+		fprintf(stderr, "Failed allocating plot samples: %s\n",
+				strerror(errno));
+		return false;
+	}
+	plot->samples = newSamples;
+	plot->numSamples = numSamples;
+	return true;
+}
+
+/* samples the equations together on the padded grid of the surface, the
+ * subexpressions they share are computed once for each point; the grid of
+ * equation n starts at samples[n * (w + 2) * (h + 2)]
+ */
+static bool plot_sample(Plot *plot, MathContext *ctx,
+		const MathFunction *const *functions, size_t count,
+		sample_t *samples)
+{
+	SDL_Surface *const surface = plot->surface;
+	const number_t invZoom = 1 / plot->zoom;
+	const Sint32 stride = surface->w + 2;
+	const size_t size = (size_t) stride * (size_t) (surface->h + 2);
+	number_t xs[MATH_BLOCK], ys[MATH_BLOCK];
+	const number_t *const parameters[] = { xs, ys };
+	MathBlock block;
+	bool result = false;
+
+	memset(&block, 0, sizeof(block));
+	for (size_t n = 0; n < count; n++)
+		if (!math_blockfunction(ctx, &block, functions[n]))
+			goto end;
+	for (Sint32 j = -1; j <= surface->h; j++) {
+		const number_t y = -((j + plot->image.y) * invZoom +
+				plot->translation.y);
+		for (Sint32 k = 0; k < MATH_BLOCK; k++)
+			ys[k] = y;
+		for (Sint32 i = -1; i <= surface->w; i += MATH_BLOCK) {
+			const Sint32 m = MIN(surface->w + 1 - i, MATH_BLOCK);
+			for (Sint32 k = 0; k < m; k++)
+				xs[k] = (i + k + plot->image.x) * invZoom +
+					plot->translation.x;
+			if (!math_computeblock(ctx, &block, parameters, m))
+				goto end;
+			for (size_t n = 0; n < count; n++) {
+				const number_t *const v =
+					math_blockresult(&block, n);
+				sample_t *const row = &samples[n * size +
+					(j + 1) * stride + i + 1];
+				for (Sint32 k = 0; k < m; k++)
+					row[k] = v[k];
+			}
+		}
+	}
+	result = true;
+
+end:
+	if (!result)
+		fprintf(stderr, "Failed sampling the equations: %s\n",
+				math_error(ctx));
+	math_freeblock(&block);
+	return result;
+}
+
+/* whether equation n of the plot is the one whose values are shown, a
+ * parametric curve or complex body has no real values
+ */
+static bool plot_isheat(const Plot *plot, size_t n, const MathFunction *f)
+{
+	return n == plot->heatEquation && plot->heat.lo < plot->heat.hi &&
+		f->group->type != GROUP_CURVE &&
+		f->group->type != GROUP_COMPLEX;
+}
+
+/* colors the pixels of the surface by the padded sample grid: a row of
+ * values is quantized into indices of the color table, which vectorizes,
+ * and then looked up; NaN keeps the pixel
+ */
+static void plot_heat(Plot *plot, const sample_t *values, Sint32 stride)
+{
+	SDL_Surface *const surface = plot->surface;
+	Uint32 *const pixels = surface->pixels;
+	const Sint32 pitch = surface->pitch / sizeof(*pixels);
+	const Uint32 *const colors = plot->heatColors;
+	const float scale = PLOT_HEAT_COLORS / (plot->heat.hi - plot->heat.lo);
+	const float offset = -plot->heat.lo * scale;
+	Sint32 indices[surface->w + 1];
+
+	for (Sint32 j = 0; j < surface->h; j++) {
+		const sample_t *const row = &values[(j + 1) * stride + 1];
+		Uint32 *const out = &pixels[j * pitch];
+
+		for (Sint32 i = 0; i < surface->w; i++) {
+			float t = row[i] * scale + offset;
+
+			t = t < PLOT_HEAT_COLORS - 1 ? t : PLOT_HEAT_COLORS - 1;
+			t = t > 0 ? t : 0;
+			indices[i] = row[i] == row[i] ? (Sint32) t :
+				PLOT_HEAT_COLORS;
+		}
+		for (Sint32 i = 0; i < surface->w; i++) {
+			const Uint32 p = colors[indices[i]];
+			out[i] = p != 0 ? p : out[i];
+		}
+	}
+}
+
+/* fills the surface with the colors of the values of the equation and
+ * draws its zero contour over them; the samples need room for one grid
+ */
+static bool plot_renderheat(Plot *plot, MathContext *ctx,
+		const MathFunction *f, size_t xAddr, size_t yAddr, Uint32 color)
+{
+	const Sint32 stride = plot->surface->w + 2;
+	struct contour contour = { plot, ctx, f, xAddr, yAddr, color };
+
+	if (!plot_sample(plot, ctx, &f, 1, plot->samples))
+		return false;
+	plot_heat(plot, plot->samples, stride);
+	plot_contour(&contour, plot->samples, stride);
+	return true;
+}
+
+/* draws the zero sets of all equations onto the surface of the plot,
+ * the explicit ones along their axis and the rest from one grid pass;
+ * the heat map comes before all curves
+ */
+static void plot_rendercurves(Plot *plot, MathContext *ctx,
+		size_t xAddr, size_t yAddr, Uint32 color)
+{
+	SDL_Surface *const surface = plot->surface;
+	const MathProgram *const program = ctx->program;
+	const MathFunction *functions[program->numFunctions + 1];
+	const size_t size = (size_t) (surface->w + 2) *
+		(size_t) (surface->h + 2);
+	size_t count = 0, numEquations = 0;
+	struct contour contour;
+
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		const MathFunction *const f = &program->functions[i];
+		/* only equations are drawn */
+		if (f->name[0] != '\0')
+			continue;
+		if (plot_isheat(plot, numEquations++, f)) {
+			if (!plot_reservesamples(plot, surface->w, surface->h,
+						1) ||
+					!plot_renderheat(plot, ctx, f, xAddr,
+						yAddr, color))
+				return;
+			continue;
+		}
+		if (!plot_explicit(plot, ctx, f, xAddr, yAddr, color))
+			functions[count++] = f;
+	}
+	if (count == 0 || !plot_reservesamples(plot, surface->w, surface->h,
+				count) ||
+			!plot_sample(plot, ctx, functions, count, plot->samples))
+		return;
+	for (size_t n = 0; n < count; n++) {
+		contour = (struct contour) {
+			plot, ctx, functions[n], xAddr, yAddr, color
+		};
+		plot_contour(&contour, &plot->samples[n * size],
+				surface->w + 2);
+	}
+}
+
+/* tiles of the same expression differ in their identity when computed
+ * with another accuracy or with the colors of another heat map
+ */
+static uint64_t plot_functionid(const Plot *plot, const MathContext *ctx,
+		size_t n, const MathFunction *f)
+{
+	uint64_t id = math_hashfunction(ctx, f) ^
+		(uint64_t) ctx->accuracy << 56;
+	uint32_t lo, hi;
+
+	if (plot_isheat(plot, n, f)) {
+		memcpy(&lo, &plot->heat.lo, sizeof(lo));
+		memcpy(&hi, &plot->heat.hi, sizeof(hi));
+		id ^= (((uint64_t) lo << 32 | hi) ^ (uint64_t)
+				plot->heat.bands) * 0x9e3779b97f4a7c15 + 1;
+	}
+	return id;
+}
+
+/* copies the drawn pixels of the tile to (x, y) of the surface */
+static void plot_drawtile(SDL_Surface *surface, const Tile *tile,
+		Sint64 x, Sint64 y)
+{
+	const Uint32 *const source = tile->surface->pixels;
+	const Sint32 sourcePitch = tile->surface->pitch / sizeof(*source);
+	Uint32 *const pixels = surface->pixels;
+	const Sint32 pitch = surface->pitch / sizeof(*pixels);
+	const Sint32 i0 = MAX(-x, 0), j0 = MAX(-y, 0);
+	const Sint32 i1 = MIN(surface->w - x, TILE_SIZE);
+	const Sint32 j1 = MIN(surface->h - y, TILE_SIZE);
+
+	for (Sint32 j = j0; j < j1; j++)
+		for (Sint32 i = i0; i < i1; i++) {
+			const Uint32 p = source[i + j * sourcePitch];
+			if (p != 0)
+				pixels[x + i + (y + j) * pitch] = p;
+		}
+}
+
+/* fills the missing tile (x, y) with the cached tiles of the zoom that
+ * is closest to that of the plot, scaled to it
+ */
+static void plot_placeholder(Plot *plot, uint64_t function, Sint64 x,
+		Sint64 y, const number_t origin[2])
+{
+	SDL_Surface *const surface = plot->surface;
+	Uint32 *const pixels = surface->pixels;
+	const Sint32 pitch = surface->pitch / sizeof(*pixels);
+	const double zoom = plot->zoom;
+	/* the missing tile in the plot coordinates */
+	const double left = (double) x * TILE_SIZE / zoom;
+	const double top = (double) y * TILE_SIZE / zoom;
+	const double right = left + TILE_SIZE / zoom;
+	const double bottom = top + TILE_SIZE / zoom;
+	/* and on the surface */
+	const Sint32 i0 = MAX(x * TILE_SIZE - (Sint64) origin[0], 0);
+	const Sint32 j0 = MAX(y * TILE_SIZE - (Sint64) origin[1], 0);
+	const Sint32 i1 = MIN(x * TILE_SIZE + TILE_SIZE - (Sint64) origin[0],
+			surface->w);
+	const Sint32 j1 = MIN(y * TILE_SIZE + TILE_SIZE - (Sint64) origin[1],
+			surface->h);
+	double best = INFINITY, bestZoom = 0;
+
+	for (int pass = 0; pass < 2; pass++)
+		for (const Tile *tile = plot->tiles.newest; tile != NULL;
+				tile = tile->older) {
+			const double z = tile->zoom;
+			const double tileLeft = (double) tile->x * TILE_SIZE / z;
+			const double tileTop = (double) tile->y * TILE_SIZE / z;
+			const Uint32 *const source = tile->surface->pixels;
+			const Sint32 sourcePitch = tile->surface->pitch /
+				sizeof(*source);
+			const double distance = fabs(log(z / zoom));
+
+			if (tile->function != function || z == zoom ||
+					tileLeft >= right || tileTop >= bottom ||
+					tileLeft + TILE_SIZE / z <= left ||
+					tileTop + TILE_SIZE / z <= top)
+				continue;
+			if (pass == 0) {
+				if (distance < best) {
+					best = distance;
+					bestZoom = z;
+				}
+				continue;
+			}
+			if (z != bestZoom)
+				continue;
+			for (Sint32 j = j0; j < j1; j++) {
+				const Sint64 b = floor((j + origin[1]) / zoom *
+						z) - tile->y * TILE_SIZE;
+				if (b < 0 || b >= TILE_SIZE)
+					continue;
+				for (Sint32 i = i0; i < i1; i++) {
+					const Sint64 a = floor((i + origin[0]) /
+							zoom * z) -
+						tile->x * TILE_SIZE;
+					if (a < 0 || a >= TILE_SIZE)
+						continue;
+					const Uint32 p =
+						source[a + b * sourcePitch];
+					if (p != 0)
+						pixels[i + j * pitch] = p;
+				}
+			}
+		}
+}
+
+/* draws the curves of the equations from the tiles that cover the plot,
+ * computing the missing ones until the deadline but at least one position
+ * a frame; the missing tiles of a position are sampled together; returns
+ * false when the plot is too far out for tile coordinates
+ */
+static bool plot_rendertiles(Plot *plot, MathContext *ctx,
+		size_t xAddr, size_t yAddr, Uint32 color, Uint64 deadline)
+{
+	SDL_Surface *const surface = plot->surface;
+	const MathProgram *const program = ctx->program;
+	const MathFunction *equations[program->numFunctions + 1];
+	uint64_t functions[program->numFunctions + 1];
+	const MathFunction *sampled[program->numFunctions + 1];
+	Tile *tiles[program->numFunctions + 1];
+	const size_t size = (size_t) (TILE_SIZE + 2) * (TILE_SIZE + 2);
+	size_t numEquations = 0, numSampled;
+	size_t numComputed = 0;
+	bool computed;
+	/* the top left pixel of the surface in the pixels of the tiles */
+	const number_t origin[2] = {
+		plot->translation.x * plot->zoom,
+		plot->translation.y * plot->zoom,
+	};
+	Sint64 x0, y0, x1, y1;
+	struct contour contour;
+	Tile *tile;
+	Plot view;
+
+	if (!(fabsl(origin[0]) < 1e15 && fabsl(origin[1]) < 1e15))
+		return false;
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		const MathFunction *const f = &program->functions[i];
+		/* only equations are drawn */
+		if (f->name[0] != '\0')
+			continue;
+		equations[numEquations] = f;
+		functions[numEquations] = plot_functionid(plot, ctx,
+				numEquations, f);
+		numEquations++;
+	}
+	if (!plot_reservesamples(plot, TILE_SIZE, TILE_SIZE, numEquations))
+		return false;
+	x0 = floorl(origin[0] / TILE_SIZE);
+	y0 = floorl(origin[1] / TILE_SIZE);
+	x1 = floorl((origin[0] + surface->w - 1) / TILE_SIZE);
+	y1 = floorl((origin[1] + surface->h - 1) / TILE_SIZE);
+	/* the tiles of the view fit at once, otherwise they replace each
+	 * other and are computed again in every frame; such a view is
+	 * drawn directly
+	 */
+	if (tile_reserve(&plot->tiles, (size_t) (x1 - x0 + 1) *
+				(size_t) (y1 - y0 + 1) * numEquations) < 0)
+		return false;
+	for (Sint64 y = y0; y <= y1; y++)
+		for (Sint64 x = x0; x <= x1; x++) {
+			const bool compute = plot->tileTime == 0 ||
+				numComputed == 0 || SDL_GetTicks64() < deadline;
+
+			view = *plot;
+			view.translation.x = (number_t) x * TILE_SIZE /
+				plot->zoom;
+			view.translation.y = (number_t) y * TILE_SIZE /
+				plot->zoom;
+			view.image = (SDL_Rect) { 0, 0, TILE_SIZE, TILE_SIZE };
+			numSampled = 0;
+			computed = false;
+			for (size_t n = 0; n < numEquations; n++) {
+				const MathFunction *const f = equations[n];
+				const bool heat = plot_isheat(plot, n, f);
+
+				tile = tile_find(&plot->tiles, functions[n],
+						plot->zoom, x, y);
+				if (tile == NULL && compute) {
+					tile = tile_insert(&plot->tiles,
+							functions[n],
+							plot->zoom, x, y);
+					if (tile == NULL) {
+						for (size_t m = 0;
+								m < numSampled;
+								m++)
+							tile_discard(
+								&plot->tiles,
+								tiles[m]);
+						return false;
+					}
+					computed = true;
+					view.surface = tile->surface;
+					/* the heat map is sampled alone and
+					 * drawn below the other equations
+					 */
+					if (heat && !plot_renderheat(&view, ctx,
+								f, xAddr, yAddr,
+								color)) {
+						tile_discard(&plot->tiles,
+								tile);
+						return false;
+					}
+					if (!heat && !plot_explicit(&view, ctx,
+								f, xAddr, yAddr,
+								color)) {
+						sampled[numSampled] = f;
+						tiles[numSampled++] = tile;
+						continue;
+					}
+				}
+				if (tile == NULL) {
+					plot_placeholder(plot, functions[n],
+							x, y, origin);
+					plot->pendingTiles++;
+					continue;
+				}
+				plot_drawtile(surface, tile,
+						x * TILE_SIZE -
+						llroundl(origin[0]),
+						y * TILE_SIZE -
+						llroundl(origin[1]));
+			}
+			if (computed)
+				numComputed++;
+			if (numSampled == 0)
+				continue;
+			/* all tiles have the same size */
+			view.surface = tiles[0]->surface;
+			if (!plot_sample(&view, ctx, sampled, numSampled,
+						plot->samples)) {
+				for (size_t n = 0; n < numSampled; n++)
+					tile_discard(&plot->tiles, tiles[n]);
+				return false;
+			}
+			for (size_t n = 0; n < numSampled; n++) {
+				view.surface = tiles[n]->surface;
+				contour = (struct contour) {
+					&view, ctx, sampled[n], xAddr, yAddr,
+					color
+				};
+				plot_contour(&contour, &plot->samples[n * size],
+						TILE_SIZE + 2);
+				plot_drawtile(surface, tiles[n],
+						x * TILE_SIZE -
+						llroundl(origin[0]),
+						y * TILE_SIZE -
+						llroundl(origin[1]));
+			}
+		}
+	return true;
+}
+
+/* renders the plot at a lower resolution into the top left part of its
+ * surface, a pixel of the part is scale x scale pixels of the plot
+ */
+static void plot_renderscaled(Plot *plot, MathContext *ctx)
+{
+	SDL_Surface *const surface = plot->surface;
+	const SDL_Rect image = plot->image;
+	const number_t zoom = plot->zoom;
+	const int scale = plot->scale;
+	SDL_Surface *part;
+
+	/* the part shares the pixels and rows of the surface */
+	part = SDL_CreateRGBSurfaceWithFormatFrom(surface->pixels,
+			surface->w / scale, surface->h / scale, 32,
+			surface->pitch, PLOT_FORMAT);
+	plot->scale = 1;
+	if (part == NULL) {
+		plot_render(plot, ctx);
+		plot->scale = scale;
+		return;
+	}
+	plot->surface = part;
+	plot->zoom = zoom / scale;
+	plot->image = (SDL_Rect) { 0, 0, part->w, part->h };
+	plot_render(plot, ctx);
+	plot->surface = surface;
+	plot->zoom = zoom;
+	plot->image = image;
+	plot->scale = scale;
+	SDL_FreeSurface(part);
+}
+
+void plot_render(Plot *plot, MathContext *ctx)
+{
+	SDL_Color textColor;
+	SDL_Surface *label;
+	SDL_Rect rect;
+	SDL_Surface *surface;
+	Uint32 dark, light;
+	Uint32 *pixels;
+	Sint32 pitch;
+	number_t invZoom;
+	Sint32 tx, ty;
+	Sint32 cellSize;
+	size_t xAddr, yAddr;
+	Uint32 curve;
+	Uint64 deadline;
+	char buf[800];
+
+	if (plot->scale > 1) {
+		plot_renderscaled(plot, ctx);
+		return;
+	}
+	deadline = SDL_GetTicks64() + plot->tileTime;
+	plot->pendingTiles = 0;
+	/* the background, grid and labels are drawn again everywhere */
+	plot->dirty = (SDL_Rect) { 0, 0, plot->surface->w, plot->surface->h };
+	textColor = (SDL_Color) { 205, 140, 0, 255 };
+	surface = plot->surface;
+	SDL_LockSurface(surface);
+	dark = SDL_MapRGB(surface->format, 0, 60, 255);
+	light = SDL_MapRGB(surface->format, 0, 60, 155);
+	pixels = surface->pixels;
+	pitch = surface->pitch / sizeof(*pixels);
+	for (Sint32 j = 0; j < surface->h; j++)
+		for (Sint32 i = 0; i < surface->w; i++)
+			pixels[i + j * pitch] = SDL_MapRGB(surface->format,
+					14, 10, 25);
+	invZoom = 1 / plot->zoom;
+
+	cellSize = 100 * plot->zoom;
+	cellSize %= 200;
+	if (cellSize < 50)
+		cellSize = 200 - cellSize;
+
+	/* where the surface starts in the grid */
+	tx = ((Sint64) (plot->zoom * plot->translation.x) +
+			plot->image.x) % cellSize;
+	ty = ((Sint64) (plot->zoom * plot->translation.y) +
+			plot->image.y) % cellSize;
+	if (tx > 0)
+		tx -= cellSize;
+	if (ty > 0)
+		ty -= cellSize;
+
+	for (Sint32 i = -1; i <= surface->w / cellSize; i++) {
+		const Sint32 x = i * cellSize - tx;
+		for (Sint32 j = 0; j < surface->h; j++) {
+			for (Sint32 n = 0; n < 4; n++) {
+				const Sint32 nx = x + n * cellSize / 4;
+				if (nx < 0 || nx >= surface->w)
+					continue;
+				pixels[nx + j * pitch] = n == 0 ? dark :
+					light;
+			}
+		}
+	}
+
+	for (Sint32 i = -1; i <= surface->h / cellSize; i++) {
+		const Sint32 y = i * cellSize - ty;
+		for (Sint32 j = 0; j < surface->w; j++) {
+			for (Sint32 n = 0; n < 4; n++) {
+				const Sint32 ny = y + n * cellSize / 4;
+				if (ny < 0 || ny >= surface->h)
+					continue;
+				pixels[j + ny * pitch] = n == 0 ? dark :
+					light;
+			}
+		}
+	}
+
+	xAddr = math_pushlocal(ctx, 0);
+	yAddr = math_pushlocal(ctx, 0);
+	curve = SDL_MapRGB(surface->format, 0, 255, 0);
+	if (!plot_rendertiles(plot, ctx, xAddr, yAddr, curve, deadline))
+		plot_rendercurves(plot, ctx, xAddr, yAddr, curve);
+	math_poplocal(ctx);
+	math_poplocal(ctx);
+
+	SDL_UnlockSurface(surface);
+
+	if (plot->font == NULL)
+		return;
+
+	/* numbers on the x axis */
+	for (Sint32 i = -1; i <= surface->w / cellSize; i++) {
+		const Sint32 x = i * cellSize - tx;
+		sprintf(buf, "%.1LF", (x + plot->image.x) * invZoom +
+				plot->translation.x);
+		label = TTF_RenderUTF8_Solid(plot->font, buf, textColor);
+		if (label == NULL)
+			continue;
+		rect = (SDL_Rect) {
+			.x = x - label->w / 2,
+			.y = -plot->translation.y * plot->zoom -
+				plot->image.y,
+			.w = label->w,
+			.h = label->h,
+		};
+		if (rect.y < 0)
+			rect.y = 0;
+		else if (rect.y > surface->h - label->h)
+			rect.y = surface->h - label->h;
+		SDL_BlitSurface(label, NULL, surface, &rect);
+		SDL_FreeSurface(label);
+	}
+
+	/* numbers on the y axis */
+	for (Sint32 i = -1; i <= surface->h / cellSize; i++) {
+		const Sint32 y = i * cellSize - ty;
+		sprintf(buf, "%.1LF", (y + plot->image.y) * invZoom +
+				plot->translation.y);
+		label = TTF_RenderUTF8_Solid(plot->font, buf, textColor);
+		if (label == NULL)
+			continue;
+		rect = (SDL_Rect) {
+			.x = -plot->translation.x * plot->zoom -
+				plot->image.x,
+			.y = y - label->h / 2,
+			.w = label->w,
+			.h = label->h,
+		};
+		if (rect.x < 0)
+			rect.x = 0;
+		else if (rect.x > surface->w - label->w)
+			rect.x = surface->w - label->w;
+		SDL_BlitSurface(label, NULL, surface, &rect);
+		SDL_FreeSurface(label);
+	}
+}
+
+/* drops the tiles of equations that changed or were removed */
+void plot_invalidate(Plot *plot, const MathContext *ctx)
+{
+	const MathProgram *const program = ctx->program;
+	uint64_t functions[program->numFunctions + 1];
+	size_t numFunctions = 0;
+
+	for (size_t i = 0; i < program->numFunctions; i++)
+		if (program->functions[i].name[0] == '\0') {
+			functions[numFunctions] = plot_functionid(plot, ctx,
+					numFunctions, &program->functions[i]);
+			numFunctions++;
+		}
+	tile_retain(&plot->tiles, functions, numFunctions);
+}
+
+/* sets the heat map and quantizes its ramp from dark blue over green to
+ * yellow into the color table
+ */
+void plot_setheat(Plot *plot, PlotHeat heat)
+{
+	static const Uint8 ramp[][3] = {
+		{ 68, 1, 84 }, { 59, 82, 139 }, { 33, 145, 140 },
+		{ 94, 201, 98 }, { 253, 231, 37 },
+	};
+	const int last = ARRLEN(ramp) - 1;
+	SDL_PixelFormat *format;
+	Uint8 c[3];
+
+	plot->heat = heat;
+	format = SDL_AllocFormat(PLOT_FORMAT);
+	if (format == NULL) {
+		fprintf(stderr, "Failed creating heat map colors: %s\n",
+				SDL_GetError());
+		plot->heat.hi = plot->heat.lo;
+		return;
+	}
+	for (int k = 0; k < PLOT_HEAT_COLORS; k++) {
+		const float t = (float) k * last / (PLOT_HEAT_COLORS - 1);
+		const int r = MIN((int) t, last - 1);
+		const bool dark = heat.bands > 0 &&
+			k * heat.bands / PLOT_HEAT_COLORS % 2 == 1;
+
+		for (int n = 0; n < 3; n++) {
+			c[n] = ramp[r][n] + (ramp[r + 1][n] - ramp[r][n]) *
+				(t - r) + 0.5f;
+			if (dark)
+				c[n] = c[n] * 3 / 4;
+		}
+		plot->heatColors[k] = SDL_MapRGB(format, c[0], c[1], c[2]);
+	}
+	plot->heatColors[PLOT_HEAT_COLORS] = 0;
+	SDL_FreeFormat(format);
+}
+
+/* the heat map is fitted to the samples of every that many pixels */
+#define PLOT_FIT_STEP 8
+/* percent of the samples on either end a fitted heat map leaves out */
+#define PLOT_FIT_TAIL 2
+
+static int plot_comparesamples(const void *a, const void *b)
+{
+	const sample_t x = *(const sample_t *) a;
+	const sample_t y = *(const sample_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* fits the range of the heat map to the values of its equation in the
+ * view, sampled every PLOT_FIT_STEP pixels; the outer PLOT_FIT_TAIL
+ * percent on either side are left out so that poles do not take all
+ * colors; false when there is no such equation or no finite value
+ */
+bool plot_fitheat(Plot *plot, MathContext *ctx)
+{
+	const MathProgram *const program = ctx->program;
+	const MathFunction *f = NULL;
+	PlotHeat heat = plot->heat;
+	SDL_Surface *surface = NULL;
+	sample_t *values = NULL;
+	size_t size, count = 0, tail, n = 0;
+	Plot view;
+	bool result = false;
+
+	for (size_t i = 0; i < program->numFunctions && f == NULL; i++)
+		if (program->functions[i].name[0] == '\0' &&
+				n++ == plot->heatEquation)
+			f = &program->functions[i];
+	if (f == NULL || f->group->type == GROUP_CURVE ||
+			f->group->type == GROUP_COMPLEX)
+		return false;
+	view = *plot;
+	surface = SDL_CreateRGBSurfaceWithFormat(0,
+			MAX(plot->surface->w / PLOT_FIT_STEP, 1),
+			MAX(plot->surface->h / PLOT_FIT_STEP, 1), 32,
+			PLOT_FORMAT);
+	if (surface == NULL)
+		return false;
+	view.surface = surface;
+	view.zoom = plot->zoom / PLOT_FIT_STEP;
+	view.image = (SDL_Rect) { 0, 0, surface->w, surface->h };
+	size = (size_t) (surface->w + 2) * (size_t) (surface->h + 2);
+	values = malloc(sizeof(*values) * size);
+	if (values == NULL || !plot_sample(&view, ctx, &f, 1, values))
+		goto end;
+	for (size_t i = 0; i < size; i++)
+		if (isfinite(values[i]))
+			values[count++] = values[i];
+	if (count == 0)
+		goto end;
+	qsort(values, count, sizeof(*values), plot_comparesamples);
+	tail = count * PLOT_FIT_TAIL / 100;
+	heat.lo = values[tail];
+	heat.hi = values[count - 1 - tail];
+	if (!(heat.lo < heat.hi)) {
+		heat.lo -= 1;
+		heat.hi += 1;
+	}
+	plot_setheat(plot, heat);
+	result = true;
+
+end:
+	free(values);
+	SDL_FreeSurface(surface);
+	return result;
+}
+
+/* writes the surface as binary PPM (P6) */
+int plot_writeppm(Plot *plot, FILE *fp)
+{
+	SDL_Surface *const surface = plot->surface;
+	Uint8 *row;
+	Uint8 r, g, b;
+
+	row = malloc((size_t) surface->w * 3);
+	if (row == NULL)
+		return -1;
+	fprintf(fp, "P6\n%d %d\n255\n", surface->w, surface->h);
+	SDL_LockSurface(surface);
+	for (Sint32 j = 0; j < surface->h; j++) {
+		const Uint32 *const pixels = (Uint32 *)
+			((Uint8 *) surface->pixels + j * surface->pitch);
+		for (Sint32 i = 0; i < surface->w; i++) {
+			SDL_GetRGB(pixels[i], surface->format, &r, &g, &b);
+			row[i * 3] = r;
+			row[i * 3 + 1] = g;
+			row[i * 3 + 2] = b;
+		}
+		if (fwrite(row, 3, surface->w, fp) != (size_t) surface->w)
+			break;
+	}
+	SDL_UnlockSurface(surface);
+	free(row);
+	return ferror(fp) ? -1 : 0;
+}
+
+/* an image larger than a plot rendered in bands of tiles */
+struct plot_export {
+	const Plot *plot;
+	enum math_accuracy accuracy;
+	int width, height;
+	/* top row of the band */
+	int y;
+	/* width * PLOT_EXPORT_TILE pixels in rgb */
+	Uint8 *band;
+	bool failed;
+};
+
+/* renders tiles of the band, each as a plot of its own */
+static void plot_exporttiles(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct plot_export *const export = arg;
+	const Plot *const plot = export->plot;
+	const int h = MIN(export->height - export->y, PLOT_EXPORT_TILE);
+	Plot view;
+	Uint8 r, g, b;
+
+	if (plot_init(&view, PLOT_EXPORT_TILE, PLOT_EXPORT_TILE) < 0) {
+		export->failed = true;
+		return;
+	}
+	/* each tile is rendered once */
+	tile_uninit(&view.tiles);
+	ctx->accuracy = export->accuracy;
+	view.zoom = plot->zoom;
+	view.translation = plot->translation;
+	view.heatEquation = plot->heatEquation;
+	plot_setheat(&view, plot->heat);
+	for (size_t t = begin; t < end; t++) {
+		const int x = t * PLOT_EXPORT_TILE;
+		const int w = MIN(export->width - x, PLOT_EXPORT_TILE);
+
+		view.image = (SDL_Rect) {
+			x, export->y, export->width, export->height
+		};
+		plot_render(&view, ctx);
+		for (int j = 0; j < h; j++) {
+			const Uint32 *const pixels = (Uint32 *)
+				((Uint8 *) view.surface->pixels +
+				 j * view.surface->pitch);
+			Uint8 *const row = &export->band[((size_t) j *
+					export->width + x) * 3];
+
+			for (int i = 0; i < w; i++) {
+				SDL_GetRGB(pixels[i], view.surface->format,
+						&r, &g, &b);
+				row[i * 3] = r;
+				row[i * 3 + 1] = g;
+				row[i * 3 + 2] = b;
+			}
+		}
+	}
+	plot_uninit(&view);
+}
+
+/* renders the view of the plot at its zoom into a width x height binary
+ * PPM (P6) without labels; the image is rendered in bands of tiles on
+ * threads and each band is written before the next is rendered, so the
+ * memory only grows with the width; the tiles are sampled and drawn in
+ * the pixels of the whole image, so that they are the same as one plot of
+ * it and the curves continue from one into the next
+ */
+int plot_export(const Plot *plot, MathContext *ctx, int width, int height,
+		FILE *fp)
+{
+	const size_t numTiles = (width + PLOT_EXPORT_TILE - 1) /
+		PLOT_EXPORT_TILE;
+	struct plot_export export;
+	int result = -1;
+
+	memset(&export, 0, sizeof(export));
+	export.plot = plot;
+	export.accuracy = ctx->accuracy;
+	export.width = width;
+	export.height = height;
+	export.band = malloc((size_t) width * PLOT_EXPORT_TILE * 3);
+	if (export.band == NULL)
+		return -1;
+	if (fprintf(fp, "P6\n%d %d\n255\n", width, height) < 0)
+		goto end;
+	for (export.y = 0; export.y < height;
+			export.y += PLOT_EXPORT_TILE) {
+		const size_t h = MIN(height - export.y, PLOT_EXPORT_TILE);
+
+		math_parallel(ctx->program, numTiles, 1, plot_exporttiles,
+				&export, 0);
+		if (export.failed || fwrite(export.band, (size_t) width * 3,
+					h, fp) != h)
+			goto end;
+	}
+	result = 0;
+
+end:
+	free(export.band);
+	return result;
+}
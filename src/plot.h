@@ -0,0 +1,72 @@
+/* width and height of the tiles plot_export() renders */
+#define PLOT_EXPORT_TILE 256
+/* colors a heat map quantizes the values into */
+#define PLOT_HEAT_COLORS 256
+
+/* the values of an equation shown as colors behind the curves */
+typedef struct plot_heat {
+	/* the values from lo to hi go through the colors, there is no heat
+	 * map unless lo < hi
+	 */
+	float lo, hi;
+	/* above 0 the range is cut into that many bands and every other
+	 * one is darker, the edges are contours of the values
+	 */
+	int bands;
+} PlotHeat;
+
+typedef struct plot {
+	SDL_Surface *surface;
+	/* labels are left out when there is no font */
+	TTF_Font *font;
+	/* (surface->w + 2) * (surface->h + 2) function samples,
+	 * reused each frame
+	 */
+	sample_t *samples;
+	size_t numSamples;
+	/* the top left pixel of the image */
+	Vector translation;
+	number_t zoom;
+	/* the surface is the part at (x, y) of an image of w x h pixels,
+	 * see plot_export(); all of the surface otherwise
+	 */
+	SDL_Rect image;
+	/* above 1 only the top left surface->w / scale x surface->h / scale
+	 * pixels are rendered, each stands for scale x scale pixels
+	 */
+	int scale;
+	PlotHeat heat;
+	/* the equation of the heat map by its position among the equations
+	 * of the program, which need not follow the lines of the editor
+	 */
+	size_t heatEquation;
+	/* the colors of the heat map in the format of the surface, the last
+	 * one is 0 for NaN, which keeps the pixel
+	 */
+	Uint32 heatColors[PLOT_HEAT_COLORS + 1];
+	/* computed curves, the whole plot is drawn directly when the
+	 * cache has no room
+	 */
+	TileCache tiles;
+	/* milliseconds a frame may spend computing tiles, 0 for no
+	 * limit; the rest shows tiles of another zoom until computed
+	 */
+	Uint32 tileTime;
+	/* tiles that were not computed in the last frame */
+	size_t pendingTiles;
+	/* part of the surface that changed since it was last shown, the
+	 * whole surface after a render and w is 0 once it was shown
+	 */
+	SDL_Rect dirty;
+} Plot;
+
+int plot_init(Plot *plot, int width, int height);
+int plot_resize(Plot *plot, int width, int height);
+void plot_uninit(Plot *plot);
+void plot_render(Plot *plot, MathContext *ctx);
+void plot_invalidate(Plot *plot, const MathContext *ctx);
+void plot_setheat(Plot *plot, PlotHeat heat);
+bool plot_fitheat(Plot *plot, MathContext *ctx);
+int plot_writeppm(Plot *plot, FILE *fp);
+int plot_export(const Plot *plot, MathContext *ctx, int width, int height,
+		FILE *fp);
@@ -0,0 +1,520 @@
+#include "cake.h"
+
+/* the names every equation is a function of */
+static const char *const equation_parameters[] = { "x", "y" };
+
+static bool program_isparameter(const char *name)
+{
+	for (size_t i = 0; i < ARRLEN(equation_parameters); i++)
+		if (strcmp(equation_parameters[i], name) == 0)
+			return true;
+	return false;
+}
+
+/* `f(a, b) = body` where every argument is a distinct name */
+static bool program_isfunction(const MathGroup *left)
+{
+	if (left->type != GROUP_CALL || left->function != NULL)
+		return false;
+	for (size_t i = 0; i < left->numArguments; i++) {
+		if (left->arguments[i]->type != GROUP_VARIABLE)
+			return false;
+		for (size_t j = 0; j < i; j++)
+			if (strcmp(left->arguments[i]->name,
+					left->arguments[j]->name) == 0)
+				return false;
+	}
+	return true;
+}
+
+static MathFunction *program_addfunction(MathContext *ctx,
+		MathProgram *program, size_t numParameters)
+{
+	MathFunction *newFunctions, *func;
+
+	newFunctions = realloc(program->functions,
+			sizeof(*program->functions) *
+			(program->numFunctions + 1));
+	if (newFunctions == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	program->functions = newFunctions;
+	func = &program->functions[program->numFunctions];
+	memset(func, 0, sizeof(*func));
+	func->parameters = calloc(numParameters, sizeof(*func->parameters));
+	if (func->parameters == NULL && numParameters > 0) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NULL;
+	}
+	func->numParameters = numParameters;
+	program->numFunctions++;
+	return func;
+}
+
+/* what a parsed worksheet line defines */
+static enum math_definition program_classify(const MathGroup *group)
+{
+	if (group->type != GROUP_EQUALS)
+		return DEFINITION_EQUATION;
+	if (group->left->type == GROUP_VARIABLE &&
+			!program_isparameter(group->left->name))
+		return DEFINITION_VARIABLE;
+	if (program_isfunction(group->left))
+		return DEFINITION_FUNCTION;
+	return DEFINITION_EQUATION;
+}
+
+/* the number of parameters of what the parsed line defines */
+static size_t program_countparameters(const MathGroup *group,
+		enum math_definition definition)
+{
+	if (definition == DEFINITION_EQUATION)
+		return ARRLEN(equation_parameters);
+	return group->left->numArguments;
+}
+
+/* moves the parsed line into the cleared variable or function, which
+ * has room for the parameters
+ */
+static void program_fill(MathContext *ctx, MathProgram *program,
+		MathGroup *group, enum math_definition definition,
+		size_t address)
+{
+	MathGroup *const left = group->left;
+	MathVariable *var;
+	MathFunction *func;
+
+	switch (definition) {
+	case DEFINITION_VARIABLE:
+		var = &program->variables[address];
+		strcpy(var->name, left->name);
+		var->group = group->right;
+		math_freegroup(ctx, left);
+		free(group);
+		break;
+	case DEFINITION_FUNCTION:
+		func = &program->functions[address];
+		strcpy(func->name, left->callee);
+		for (size_t i = 0; i < left->numArguments; i++)
+			strcpy(func->parameters[i], left->arguments[i]->name);
+		func->group = group->right;
+		math_freegroup(ctx, left);
+		free(group);
+		break;
+	case DEFINITION_EQUATION:
+		func = &program->functions[address];
+		for (size_t i = 0; i < ARRLEN(equation_parameters); i++)
+			strcpy(func->parameters[i], equation_parameters[i]);
+		func->group = group;
+		break;
+	}
+}
+
+/* parses a worksheet line and appends what it defines to the program:
+ * `a = 1` is a variable, `f(t) = t^2` a function and anything else an
+ * equation in x and y; the program must be bound afterwards
+ */
+bool math_define(MathContext *ctx, MathProgram *program, const char *text,
+		enum math_definition *definition, size_t *address)
+{
+	MathGroup *group;
+	MathVariable *newVariables;
+
+	/* the definitions move, nothing is remembered until bound again */
+	program->generation = 0;
+	group = math_parse(ctx, text);
+	if (group == NULL)
+		return false;
+	*definition = program_classify(group);
+	if (*definition == DEFINITION_VARIABLE) {
+		newVariables = realloc(program->variables,
+				sizeof(*program->variables) *
+				(program->numVariables + 1));
+		if (newVariables == NULL) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			goto err;
+		}
+		program->variables = newVariables;
+		*address = program->numVariables++;
+		memset(&program->variables[*address], 0,
+				sizeof(*program->variables));
+	} else {
+		if (program_addfunction(ctx, program, program_countparameters(
+						group, *definition)) == NULL)
+			goto err;
+		*address = program->numFunctions - 1;
+	}
+	program_fill(ctx, program, group, *definition, *address);
+	return true;
+
+err:
+	math_freegroup(ctx, group);
+	return false;
+}
+
+/* drops the values of a list variable, they are computed again */
+static void program_freelist(MathVariable *var)
+{
+	if (var->list == NULL)
+		return;
+	math_freelist(var->list);
+	free(var->list);
+	var->list = NULL;
+}
+
+/* removes a definition, the definitions after it move down by one */
+void math_undefine(MathContext *ctx, MathProgram *program,
+		enum math_definition definition, size_t address)
+{
+	/* the definitions move, nothing is remembered until bound again */
+	program->generation = 0;
+	if (definition == DEFINITION_VARIABLE) {
+		math_freegroup(ctx, program->variables[address].group);
+		program_freelist(&program->variables[address]);
+		program->numVariables--;
+		memmove(&program->variables[address],
+				&program->variables[address + 1],
+				sizeof(*program->variables) *
+				(program->numVariables - address));
+		return;
+	}
+	math_freegroup(ctx, program->functions[address].group);
+	free(program->functions[address].parameters);
+	program->numFunctions--;
+	memmove(&program->functions[address],
+			&program->functions[address + 1],
+			sizeof(*program->functions) *
+			(program->numFunctions - address));
+}
+
+/* parses a worksheet line again and puts what it defines in place of
+ * the definition at the address, so that no other definition moves:
+ * 1 when it was replaced, 0 when the line defines another kind now and
+ * -1 on an error; the program must be bound after a replacement
+ */
+int math_redefine(MathContext *ctx, MathProgram *program, const char *text,
+		enum math_definition definition, size_t address)
+{
+	MathGroup *group;
+	MathVariable *var;
+	MathFunction *func;
+	char (*parameters)[256];
+	size_t numParameters;
+
+	group = math_parse(ctx, text);
+	if (group == NULL)
+		return -1;
+	if (program_classify(group) != definition) {
+		math_freegroup(ctx, group);
+		return 0;
+	}
+	/* nothing is remembered until bound again */
+	program->generation = 0;
+	if (definition == DEFINITION_VARIABLE) {
+		var = &program->variables[address];
+		math_freegroup(ctx, var->group);
+		program_freelist(var);
+		memset(var, 0, sizeof(*var));
+	} else {
+		numParameters = program_countparameters(group, definition);
+		parameters = calloc(numParameters, sizeof(*parameters));
+		if (parameters == NULL && numParameters > 0) {
+			math_seterror(ctx, MATH_MEMORY, errno);
+			math_freegroup(ctx, group);
+			return -1;
+		}
+		func = &program->functions[address];
+		math_freegroup(ctx, func->group);
+		free(func->parameters);
+		memset(func, 0, sizeof(*func));
+		func->parameters = parameters;
+		func->numParameters = numParameters;
+	}
+	program_fill(ctx, program, group, definition, address);
+	return 1;
+}
+
+/* whether the group depends on nothing but the parameters, computed
+ * variables and pure functions
+ */
+static bool program_ispure(const MathProgram *program, const MathGroup *group)
+{
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+		return true;
+	case GROUP_GLOBAL:
+		return program->variables[group->index].state ==
+			VARIABLE_COMPUTED;
+	case GROUP_NEGATE:
+		return program_ispure(program, group->group);
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (!program_ispure(program, group->arguments[i]))
+				return false;
+		return true;
+	case GROUP_CALL:
+		if (group->function != NULL && group->function->group != NULL &&
+				!group->function->pure)
+			return false;
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (!program_ispure(program, group->arguments[i]))
+				return false;
+		return true;
+	default:
+		return program_ispure(program, group->left) &&
+			program_ispure(program, group->right);
+	}
+}
+
+/* whether the group calls the function, directly or through the user
+ * functions it calls; each of those is only visited once
+ */
+static bool program_reaches(const MathProgram *program,
+		const MathGroup *group, const MathFunction *func, bool *visited)
+{
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+	case GROUP_GLOBAL:
+		return false;
+	case GROUP_NEGATE:
+		return program_reaches(program, group->group, func, visited);
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (program_reaches(program, group->arguments[i], func,
+						visited))
+				return true;
+		return false;
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (program_reaches(program, group->arguments[i], func,
+						visited))
+				return true;
+		if (group->function == func)
+			return true;
+		if (group->function == NULL || group->function->group == NULL ||
+				visited[group->function - program->functions])
+			return false;
+		visited[group->function - program->functions] = true;
+		return program_reaches(program, group->function->group, func,
+				visited);
+	default:
+		return program_reaches(program, group->left, func, visited) ||
+			program_reaches(program, group->right, func, visited);
+	}
+}
+
+/* whether the group reads the variable at the address, directly or
+ * through the variables and user functions it uses; visited has a flag
+ * for every variable and then every function, each is only visited once
+ */
+static bool program_reads(const MathProgram *program,
+		const MathGroup *group, size_t address, bool *visited)
+{
+	size_t index;
+
+	switch (group->type) {
+	case GROUP_NUMBER:
+	case GROUP_VARIABLE:
+	case GROUP_PARAMETER:
+		return false;
+	case GROUP_GLOBAL:
+		if (group->index == address)
+			return true;
+		if (visited[group->index])
+			return false;
+		visited[group->index] = true;
+		return program_reads(program,
+				program->variables[group->index].group,
+				address, visited);
+	case GROUP_NEGATE:
+		return program_reads(program, group->group, address, visited);
+	case GROUP_LIST:
+	case GROUP_SUM:
+	case GROUP_PRODUCT:
+	case GROUP_INTEGRAL:
+	case GROUP_SOLVE:
+	case GROUP_CURVE:
+	case GROUP_COMPLEX:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (program_reads(program, group->arguments[i], address,
+						visited))
+				return true;
+		return false;
+	case GROUP_CALL:
+		for (size_t i = 0; i < group->numArguments; i++)
+			if (program_reads(program, group->arguments[i], address,
+						visited))
+				return true;
+		if (group->function == NULL || group->function->group == NULL)
+			return false;
+		index = program->numVariables +
+			(group->function - program->functions);
+		if (visited[index])
+			return false;
+		visited[index] = true;
+		return program_reads(program, group->function->group, address,
+				visited);
+	default:
+		return program_reads(program, group->left, address, visited) ||
+			program_reads(program, group->right, address, visited);
+	}
+}
+
+/* finds the functions that may remember their results, see memo_slot() */
+static void program_findpure(MathProgram *program)
+{
+	static uint64_t generation;
+	bool visited[program->numFunctions + 1];
+	bool changed;
+
+	/* assume all are pure, then drop those calling one that is not */
+	for (size_t i = 0; i < program->numFunctions; i++)
+		program->functions[i].pure = true;
+	do {
+		changed = false;
+		for (size_t i = 0; i < program->numFunctions; i++) {
+			MathFunction *const func = &program->functions[i];
+			if (func->pure &&
+					!program_ispure(program, func->group)) {
+				func->pure = false;
+				changed = true;
+			}
+		}
+	} while (changed);
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		MathFunction *const func = &program->functions[i];
+		memset(visited, 0, sizeof(visited));
+		func->recursive = program_reaches(program, func->group, func,
+				visited);
+	}
+	/* contexts drop what they remember of earlier bindings */
+	program->generation = __atomic_add_fetch(&generation, 1,
+			__ATOMIC_RELAXED);
+}
+
+/* computes the variables that are not computed, returns false with the
+ * first error
+ */
+static bool program_computevariables(MathContext *ctx, MathProgram *program)
+{
+	enum math_error error = MATH_SUCCESS;
+	int errorNumber = 0;
+
+	for (size_t i = 0; i < program->numVariables; i++) {
+		math_seterror(ctx, MATH_SUCCESS, 0);
+		math_computevariable(ctx, &program->variables[i]);
+		if (ctx->error != MATH_SUCCESS && error == MATH_SUCCESS) {
+			error = ctx->error;
+			errorNumber = ctx->errorNumber;
+		}
+	}
+	math_seterror(ctx, error, errorNumber);
+	return error == MATH_SUCCESS;
+}
+
+/* resolves every name of the program and computes its variables, names
+ * that do not resolve compute as NaN; the context computes the program
+ * from then on; returns false with the first error if anything failed
+ */
+bool math_bindprogram(MathContext *ctx, MathProgram *program)
+{
+	enum math_error error = MATH_SUCCESS;
+	int errorNumber = 0;
+	MathFunction constant;
+
+	ctx->program = program;
+	/* nothing is remembered while the variables are computed */
+	program->generation = 0;
+	for (size_t i = 0; i < program->numFunctions; i++)
+		program->functions[i].pure = false;
+	memset(&constant, 0, sizeof(constant));
+	for (size_t i = 0; i < program->numVariables; i++) {
+		MathVariable *const var = &program->variables[i];
+		var->state = VARIABLE_UNCOMPUTED;
+		program_freelist(var);
+		constant.group = var->group;
+		if (!math_bindfunction(ctx, &constant) &&
+				error == MATH_SUCCESS) {
+			error = ctx->error;
+			errorNumber = ctx->errorNumber;
+		}
+	}
+	for (size_t i = 0; i < program->numFunctions; i++)
+		if (!math_bindfunction(ctx, &program->functions[i]) &&
+				error == MATH_SUCCESS) {
+			error = ctx->error;
+			errorNumber = ctx->errorNumber;
+		}
+	if (!program_computevariables(ctx, program) &&
+			error == MATH_SUCCESS) {
+		error = ctx->error;
+		errorNumber = ctx->errorNumber;
+	}
+	program_findpure(program);
+	math_seterror(ctx, error, errorNumber);
+	return error == MATH_SUCCESS;
+}
+
+/* gives the bound variable at the address the value in place of its
+ * definition and computes the variables that read it again, until the
+ * program is bound again; returns false with the first error of those
+ */
+bool math_setvariable(MathContext *ctx, MathProgram *program,
+		size_t address, number_t value)
+{
+	MathVariable *const var = &program->variables[address];
+	bool visited[program->numVariables + program->numFunctions + 1];
+	bool result;
+
+	ctx->program = program;
+	/* nothing is remembered while the variables are computed */
+	program->generation = 0;
+	for (size_t i = 0; i < program->numVariables; i++) {
+		MathVariable *const other = &program->variables[i];
+
+		memset(visited, 0, sizeof(visited));
+		if (i == address || !program_reads(program, other->group,
+					address, visited))
+			continue;
+		other->state = VARIABLE_UNCOMPUTED;
+		program_freelist(other);
+	}
+	program_freelist(var);
+	var->value = value;
+	var->state = VARIABLE_COMPUTED;
+	result = program_computevariables(ctx, program);
+	program_findpure(program);
+	return result;
+}
+
+void math_freeprogram(MathContext *ctx, MathProgram *program)
+{
+	for (size_t i = 0; i < program->numVariables; i++) {
+		math_freegroup(ctx, program->variables[i].group);
+		program_freelist(&program->variables[i]);
+	}
+	for (size_t i = 0; i < program->numFunctions; i++) {
+		math_freegroup(ctx, program->functions[i].group);
+		free(program->functions[i].parameters);
+	}
+	free(program->variables);
+	free(program->functions);
+	memset(program, 0, sizeof(*program));
+}
@@ -0,0 +1,594 @@
+#include "cake.h"
+
+/* sums and products add up their terms MATH_BLOCK at a time, integrals
+ * are adaptive Gauss-Kronrod quadratures that compute the 15 points of
+ * several intervals together; the body of a series is compiled into a
+ * block, and large series are split across threads
+ */
+
+/* the positive nodes of the 15 point Kronrod rule on [-1, 1], then 0 */
+static const number_t series_nodes[8] = {
+	0.991455371120812639206854697526329L,
+	0.949107912342758524526189684047851L,
+	0.864864423359769072789712788640926L,
+	0.741531185599394439863864773280788L,
+	0.586087235467691130294144845693013L,
+	0.405845151377397166906606412076961L,
+	0.207784955007898467600689403773245L,
+	0.000000000000000000000000000000000L,
+};
+
+/* their weights, the last of 0 */
+static const number_t series_weights[8] = {
+	0.022935322010529224963732008058970L,
+	0.063092092629978553290700663189204L,
+	0.104790010322250183839876322541518L,
+	0.140653259715525918745189590510238L,
+	0.169004726639267902826583426598550L,
+	0.190350578064785409913256402421014L,
+	0.204432940075298892414161999234649L,
+	0.209482141084727828012999174891714L,
+};
+
+/* the 7 point Gauss rule on the odd nodes */
+static const number_t series_gauss[4] = {
+	0.129484966168869693270611432679082L,
+	0.279705391489276667901467771423780L,
+	0.381830050505118944950369775488975L,
+	0.417959183673469387755102040816327L,
+};
+
+/* intervals whose points are computed together */
+#define SERIES_INTERVALS 8
+/* most intervals an integral is split into */
+#define SERIES_MAX_INTERVALS 2048
+/* sums of more terms are split across threads in chunks */
+#define SERIES_PARALLEL_TERMS (1 << 16)
+#define SERIES_CHUNK (1 << 12)
+/* integrals not done with that many intervals refine each on a thread */
+#define SERIES_PARALLEL_INTERVALS 64
+
+struct series_body {
+	void (*compute)(MathContext *ctx, void *arg, number_t *y,
+			const number_t *t, size_t count);
+	void *arg;
+};
+
+struct series_interval {
+	number_t a, b;
+	number_t value, error;
+	/* integral of the absolute value, the error is relative to it */
+	number_t magnitude;
+};
+
+/* the body compiled into a block of the parameters around the series
+ * and its bound name
+ */
+struct series_block {
+	MathBlock *block;
+	const number_t **parameters;
+	size_t index;
+};
+
+/* what the threads of a large series share */
+struct series_work {
+	const MathGroup *group;
+	const number_t *outer;
+	enum math_accuracy accuracy;
+	number_t lo;
+	size_t count;
+	/* the sum or product of each chunk of terms */
+	number_t *partials;
+	/* the intervals of an integral, each refined on its own */
+	struct series_interval *intervals;
+	number_t tolerance;
+	number_t target;
+	number_t width;
+};
+
+/* relative error of integrals, the approximations have less digits */
+static number_t series_tolerance(const MathContext *ctx)
+{
+	switch (ctx->accuracy) {
+	case ACCURACY_EXACT:
+		return 1e-14;
+	case ACCURACY_DOUBLE:
+		return 1e-11;
+	default:
+		return 1e-5;
+	}
+}
+
+/* the terms lo, lo + 1, ... up to hi */
+static bool series_count(number_t lo, number_t hi, size_t *count)
+{
+	if (!isfinite(lo) || !isfinite(hi) ||
+			hi - lo >= (number_t) ((size_t) 1 << 52))
+		return false;
+	*count = hi < lo ? 0 : (size_t) floorl(hi - lo) + 1;
+	return true;
+}
+
+/* the sum or product of count terms from lo + first on */
+static number_t series_terms(MathContext *ctx, const struct series_body *body,
+		enum math_group_type type, number_t lo, size_t first,
+		size_t count)
+{
+	number_t t[MATH_BLOCK], y[MATH_BLOCK];
+	number_t result = type == GROUP_PRODUCT;
+
+	for (size_t i = 0; i < count; i += MATH_BLOCK) {
+		const size_t n = MIN(count - i, (size_t) MATH_BLOCK);
+
+		for (size_t j = 0; j < n; j++)
+			t[j] = lo + (number_t) (first + i + j);
+		body->compute(ctx, body->arg, y, t, n);
+		if (type == GROUP_SUM)
+			for (size_t j = 0; j < n; j++)
+				result += y[j];
+		else
+			for (size_t j = 0; j < n; j++)
+				result *= y[j];
+	}
+	return result;
+}
+
+/* integrates over each interval with both rules, their difference is
+ * the error estimate
+ */
+static void series_kronrod(MathContext *ctx, const struct series_body *body,
+		struct series_interval *intervals, size_t count)
+{
+	number_t t[SERIES_INTERVALS * 15], y[SERIES_INTERVALS * 15];
+
+	for (size_t i = 0; i < count; i++) {
+		const number_t center = (intervals[i].a + intervals[i].b) / 2;
+		const number_t half = (intervals[i].b - intervals[i].a) / 2;
+		number_t *const ti = &t[i * 15];
+
+		ti[0] = center;
+		for (size_t j = 0; j < 7; j++) {
+			ti[1 + 2 * j] = center - half * series_nodes[j];
+			ti[2 + 2 * j] = center + half * series_nodes[j];
+		}
+	}
+	body->compute(ctx, body->arg, y, t, count * 15);
+	for (size_t i = 0; i < count; i++) {
+		struct series_interval *const interval = &intervals[i];
+		const number_t half = (interval->b - interval->a) / 2;
+		const number_t *const yi = &y[i * 15];
+		number_t kronrod, gauss, magnitude;
+
+		kronrod = yi[0] * series_weights[7];
+		gauss = yi[0] * series_gauss[3];
+		magnitude = fabsl(yi[0]) * series_weights[7];
+		for (size_t j = 0; j < 7; j++) {
+			kronrod += series_weights[j] *
+				(yi[1 + 2 * j] + yi[2 + 2 * j]);
+			magnitude += series_weights[j] *
+				(fabsl(yi[1 + 2 * j]) + fabsl(yi[2 + 2 * j]));
+			if (j % 2 == 1)
+				gauss += series_gauss[j / 2] *
+					(yi[1 + 2 * j] + yi[2 + 2 * j]);
+		}
+		interval->value = kronrod * half;
+		interval->error = fabsl((kronrod - gauss) * half);
+		interval->magnitude = magnitude * half;
+	}
+}
+
+/* bisects the intervals of the largest errors until the error is within
+ * the tolerance of the magnitude or the target; false if the intervals
+ * reached max before
+ */
+static bool series_refine(MathContext *ctx, const struct series_body *body,
+		struct series_interval *intervals, size_t *count, size_t max,
+		number_t tolerance, number_t target)
+{
+	struct series_interval halves[SERIES_INTERVALS];
+	size_t worst[SERIES_INTERVALS / 2];
+	number_t value, error, magnitude;
+	size_t n;
+
+	while (1) {
+		value = error = magnitude = 0;
+		for (size_t i = 0; i < *count; i++) {
+			value += intervals[i].value;
+			error += intervals[i].error;
+			magnitude += intervals[i].magnitude;
+		}
+		/* NaN does not get better */
+		if (!isfinite(value) || error <= tolerance * magnitude ||
+				error <= target)
+			return true;
+		n = *count >= max ? 0 : MIN(MIN(max - *count, *count),
+				(size_t) SERIES_INTERVALS / 2);
+		if (n == 0)
+			return false;
+		/* few are picked at a time, so the search is linear; the
+		 * picked ones are marked with a negative error
+		 */
+		for (size_t w = 0; w < n; w++) {
+			worst[w] = 0;
+			for (size_t i = 1; i < *count; i++)
+				if (intervals[i].error >
+						intervals[worst[w]].error)
+					worst[w] = i;
+			intervals[worst[w]].error = -1;
+		}
+		for (size_t w = 0; w < n; w++) {
+			const struct series_interval *const interval =
+				&intervals[worst[w]];
+			const number_t mid = (interval->a + interval->b) / 2;
+
+			halves[2 * w] = (struct series_interval) {
+				.a = interval->a, .b = mid,
+			};
+			halves[2 * w + 1] = (struct series_interval) {
+				.a = mid, .b = interval->b,
+			};
+		}
+		series_kronrod(ctx, body, halves, 2 * n);
+		for (size_t w = 0; w < n; w++) {
+			struct series_interval *const interval =
+				&intervals[worst[w]];
+
+			/* too narrow to split, it stays as it is */
+			if (halves[2 * w].b <= interval->a ||
+					halves[2 * w].b >= interval->b) {
+				interval->error = 0;
+				continue;
+			}
+			*interval = halves[2 * w];
+			intervals[(*count)++] = halves[2 * w + 1];
+		}
+	}
+}
+
+/* splits the bounds at 0 and the powers of 4 on both sides of it, so
+ * that a body that decays away from 0 is seen however wide the bounds
+ * are; at most half of the intervals are used for that
+ */
+static size_t series_split(struct series_interval *intervals, number_t lo,
+		number_t hi)
+{
+	const size_t max = SERIES_MAX_INTERVALS / 2 - 1;
+	size_t count = 0;
+	number_t a = lo, p = 1;
+
+	if (lo < 0) {
+		while (p * 4 < -lo)
+			p *= 4;
+		for (; p >= 1 && -p < hi && count < max; p /= 4)
+			if (-p > a) {
+				intervals[count++] = (struct series_interval) {
+					.a = a, .b = -p,
+				};
+				a = -p;
+			}
+		if (hi > 0 && a < 0) {
+			intervals[count++] = (struct series_interval) {
+				.a = a, .b = 0,
+			};
+			a = 0;
+		}
+	}
+	for (p = 1; p <= a; p *= 4);
+	for (; p < hi && count < max; p *= 4) {
+		intervals[count++] = (struct series_interval) {
+			.a = a, .b = p,
+		};
+		a = p;
+	}
+	intervals[count++] = (struct series_interval) { .a = a, .b = hi };
+	return count;
+}
+
+static number_t series_total(const struct series_interval *intervals,
+		size_t count)
+{
+	number_t value = 0;
+
+	for (size_t i = 0; i < count; i++)
+		value += intervals[i].value;
+	return value;
+}
+
+static void series_worker(MathContext *ctx, void *arg, size_t begin,
+		size_t end);
+
+/* a sum or product, split across threads if there is work for them */
+static number_t series_sum(MathContext *ctx, const struct series_body *body,
+		enum math_group_type type, number_t lo, number_t hi,
+		struct series_work *work)
+{
+	number_t result;
+	size_t count, numChunks;
+
+	if (!series_count(lo, hi, &count))
+		return NAN;
+	if (work == NULL || count < SERIES_PARALLEL_TERMS)
+		return series_terms(ctx, body, type, lo, 0, count);
+	numChunks = (count + SERIES_CHUNK - 1) / SERIES_CHUNK;
+	work->lo = lo;
+	work->count = count;
+	work->partials = malloc(sizeof(*work->partials) * numChunks);
+	if (work->partials == NULL)
+		return series_terms(ctx, body, type, lo, 0, count);
+	math_parallel(ctx->program, numChunks, 1, series_worker, work, 0);
+	/* the chunks are combined in order, so the result does not depend
+	 * on the threads
+	 */
+	result = type == GROUP_PRODUCT;
+	for (size_t c = 0; c < numChunks; c++)
+		result = type == GROUP_SUM ? result + work->partials[c] :
+			result * work->partials[c];
+	free(work->partials);
+	return result;
+}
+
+/* an integral over finite bounds; with work the intervals of an integral
+ * that is not done after SERIES_PARALLEL_INTERVALS are refined on
+ * threads, each within its share of the error; NaN if it is not within
+ * the tolerance after SERIES_MAX_INTERVALS, the sum would look exact
+ */
+static number_t series_integrate(MathContext *ctx,
+		const struct series_body *body, number_t lo, number_t hi,
+		struct series_work *work)
+{
+	struct series_interval *intervals;
+	size_t count, max;
+	number_t value, magnitude = 0;
+	bool converged;
+
+	if (!isfinite(lo) || !isfinite(hi))
+		return NAN;
+	if (hi < lo)
+		return -series_integrate(ctx, body, hi, lo, work);
+	if (lo == hi)
+		return 0;
+	intervals = malloc(sizeof(*intervals) * SERIES_MAX_INTERVALS);
+	if (intervals == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		return NAN;
+	}
+	count = series_split(intervals, lo, hi);
+	for (size_t i = 0; i < count; i += SERIES_INTERVALS)
+		series_kronrod(ctx, body, &intervals[i],
+				MIN(count - i, (size_t) SERIES_INTERVALS));
+	max = work == NULL ? SERIES_MAX_INTERVALS : SERIES_PARALLEL_INTERVALS;
+	converged = series_refine(ctx, body, intervals, &count, max,
+			series_tolerance(ctx), 0);
+	if (converged || work == NULL) {
+		value = converged ? series_total(intervals, count) : NAN;
+		free(intervals);
+		return value;
+	}
+	for (size_t i = 0; i < count; i++)
+		magnitude += intervals[i].magnitude;
+	work->intervals = intervals;
+	work->tolerance = series_tolerance(ctx);
+	work->target = work->tolerance * magnitude;
+	work->width = hi - lo;
+	math_parallel(ctx->program, count, 1, series_worker, work, 0);
+	value = series_total(intervals, count);
+	free(intervals);
+	return value;
+}
+
+/* computes the series with the given body at any number of values of
+ * its bound name; the terms of a sum or product are the integers from
+ * lo on up to hi, empty ones are 0 and 1; bounds that are not finite
+ * compute as NaN
+ */
+number_t math_series(MathContext *ctx, enum math_group_type type,
+		number_t lo, number_t hi,
+		void (*body)(MathContext *ctx, void *arg, number_t *y,
+			const number_t *t, size_t count),
+		void *arg)
+{
+	const struct series_body series = { body, arg };
+
+	if (type == GROUP_INTEGRAL)
+		return series_integrate(ctx, &series, lo, hi, NULL);
+	return series_sum(ctx, &series, type, lo, hi, NULL);
+}
+
+static void series_blockbody(MathContext *ctx, void *arg, number_t *y,
+		const number_t *t, size_t count)
+{
+	struct series_block *const series = arg;
+
+	for (size_t i = 0; i < count; i += MATH_BLOCK) {
+		const size_t n = MIN(count - i, (size_t) MATH_BLOCK);
+
+		series->parameters[series->index] = &t[i];
+		if (!math_computeblock(ctx, series->block, series->parameters,
+					n)) {
+			for (size_t j = 0; j < n; j++)
+				y[i + j] = NAN;
+			continue;
+		}
+		memcpy(&y[i], math_blockresult(series->block, 0),
+				sizeof(*y) * n);
+	}
+}
+
+/* the compiled body of the series, kept by the context as long as the
+ * program stays bound; the slot is NULL if the scratch block was used
+ */
+static MathBlock *series_acquire(MathContext *ctx, const MathGroup *group,
+		MathBlock *scratch, MathSeriesBody **slot)
+{
+	const uint64_t generation = ctx->program == NULL ? 0 :
+		ctx->program->generation;
+	MathFunction func;
+	MathBlock *block = scratch;
+
+	*slot = NULL;
+	memset(scratch, 0, sizeof(*scratch));
+	if (generation != 0 && ctx->series == NULL)
+		ctx->series = calloc(MATH_SERIES_CACHE, sizeof(*ctx->series));
+	for (size_t i = 0; generation != 0 && ctx->series != NULL &&
+			i < MATH_SERIES_CACHE; i++) {
+		MathSeriesBody *const body = &ctx->series[i];
+
+		if (body->busy)
+			continue;
+		if (body->group == group && body->generation == generation) {
+			body->busy = true;
+			*slot = body;
+			return &body->block;
+		}
+		/* an empty or outdated slot is better than any other */
+		if (*slot == NULL || (*slot)->generation == generation)
+			*slot = body;
+	}
+	if (*slot != NULL) {
+		math_freeblock(&(*slot)->block);
+		(*slot)->group = group;
+		(*slot)->generation = generation;
+		(*slot)->busy = true;
+		block = &(*slot)->block;
+	}
+	memset(&func, 0, sizeof(func));
+	func.group = group->arguments[3];
+	func.numParameters = group->arguments[0]->index + 1;
+	if (!math_blockfunction(ctx, block, &func)) {
+		math_freeblock(block);
+		if (*slot != NULL) {
+			(*slot)->generation = 0;
+			(*slot)->busy = false;
+		}
+		return NULL;
+	}
+	return block;
+}
+
+static void series_release(MathSeriesBody *slot, MathBlock *scratch)
+{
+	if (slot != NULL)
+		slot->busy = false;
+	else
+		math_freeblock(scratch);
+}
+
+/* the parameters around the series are the same for every sample */
+static void series_broadcast(number_t (*broadcast)[MATH_BLOCK],
+		const number_t **parameters, const number_t *outer,
+		size_t index)
+{
+	for (size_t p = 0; p < index; p++) {
+		for (size_t i = 0; i < MATH_BLOCK; i++)
+			broadcast[p][i] = outer[p];
+		parameters[p] = broadcast[p];
+	}
+}
+
+/* computes chunks of terms or refines intervals of the integral */
+static void series_worker(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct series_work *const work = arg;
+	const size_t index = work->group->arguments[0]->index;
+	number_t broadcast[index + 1][MATH_BLOCK];
+	const number_t *parameters[index + 1];
+	struct series_interval *intervals = NULL;
+	struct series_block series;
+	struct series_body body;
+	MathBlock scratch;
+	MathSeriesBody *slot;
+	size_t count;
+
+	ctx->accuracy = work->accuracy;
+	series.block = series_acquire(ctx, work->group, &scratch, &slot);
+	series.parameters = parameters;
+	series.index = index;
+	series_broadcast(broadcast, parameters, work->outer, index);
+	body.compute = series_blockbody;
+	body.arg = &series;
+	if (work->intervals == NULL) {
+		for (size_t c = begin; c < end; c++) {
+			const size_t first = c * SERIES_CHUNK;
+
+			work->partials[c] = series.block == NULL ? NAN :
+				series_terms(ctx, &body, work->group->type,
+					work->lo, first,
+					MIN(work->count - first,
+						(size_t) SERIES_CHUNK));
+		}
+	} else {
+		intervals = malloc(sizeof(*intervals) * SERIES_MAX_INTERVALS);
+		for (size_t c = begin; c < end; c++) {
+			struct series_interval *const interval =
+				&work->intervals[c];
+
+			if (series.block == NULL || intervals == NULL) {
+				interval->value = NAN;
+				continue;
+			}
+			/* each within its share of the error */
+			intervals[0] = *interval;
+			count = 1;
+			interval->value = series_refine(ctx, &body,
+					intervals, &count, SERIES_MAX_INTERVALS,
+					work->tolerance, work->target *
+					(interval->b - interval->a) /
+					work->width) ?
+				series_total(intervals, count) : NAN;
+		}
+		free(intervals);
+	}
+	if (series.block != NULL)
+		series_release(slot, &scratch);
+}
+
+/* computes the bound series with the values of the parameters around
+ * it, its body compiled into a block; a series that is not computed by
+ * a worker of math_parallel() may start threads
+ */
+number_t math_computeseries(MathContext *ctx, const MathGroup *group,
+		number_t lo, number_t hi, const number_t *outer)
+{
+	const size_t index = group->arguments[0]->index;
+	number_t broadcast[index + 1][MATH_BLOCK];
+	const number_t *parameters[index + 1];
+	struct series_block series;
+	struct series_body body;
+	struct series_work work, *parallel = NULL;
+	MathBlock scratch;
+	MathSeriesBody *slot;
+	number_t value;
+
+	if (!ctx->nested) {
+		memset(&work, 0, sizeof(work));
+		work.group = group;
+		work.outer = outer;
+		work.accuracy = ctx->accuracy;
+		parallel = &work;
+	}
+	series.block = series_acquire(ctx, group, &scratch, &slot);
+	if (series.block == NULL)
+		return NAN;
+	series.parameters = parameters;
+	series.index = index;
+	series_broadcast(broadcast, parameters, outer, index);
+	body.compute = series_blockbody;
+	body.arg = &series;
+	if (group->type == GROUP_INTEGRAL)
+		value = series_integrate(ctx, &body, lo, hi, parallel);
+	else
+		value = series_sum(ctx, &body, group->type, lo, hi, parallel);
+	series_release(slot, &scratch);
+	return value;
+}
+
+void math_freeseries(MathContext *ctx)
+{
+	if (ctx->series == NULL)
+		return;
+	for (size_t i = 0; i < MATH_SERIES_CACHE; i++)
+		math_freeblock(&ctx->series[i].block);
+	free(ctx->series);
+	ctx->series = NULL;
+}
@@ -0,0 +1,303 @@
+#include "cake.h"
+
+/* roots are bracketed by sampling the function in blocks of MATH_BLOCK
+ * points, where the sign changes Brent's method refines them in long
+ * double with the exact system functions; the range is split into
+ * chunks that are sampled and refined on threads
+ */
+
+/* intervals the range is sampled in */
+#define SOLVE_SAMPLES (1 << 14)
+/* intervals of a chunk, a chunk has at most one root in each */
+#define SOLVE_CHUNK 256
+/* Brent's method halves the bracket at least every few steps */
+#define SOLVE_ITERATIONS 200
+
+/* what the threads share */
+struct solve_work {
+	const MathFunction *func;
+	size_t parameter;
+	const number_t *arguments;
+	enum math_accuracy accuracy;
+	number_t lo, hi;
+	/* SOLVE_CHUNK + 1 roots for each chunk */
+	number_t *roots;
+	size_t *counts;
+	/* set by a chunk that could not be computed */
+	enum math_error error;
+	int errorNumber;
+};
+
+/* the sample i of the range, the last is hi itself */
+static number_t solve_point(const struct solve_work *work, size_t i)
+{
+	if (i == SOLVE_SAMPLES)
+		return work->hi;
+	return work->lo + (work->hi - work->lo) * (number_t) i / SOLVE_SAMPLES;
+}
+
+/* the function with the parameter at x and the others at the arguments */
+static number_t solve_at(MathContext *ctx, const struct solve_work *work,
+		number_t x)
+{
+	const MathFunction *const func = work->func;
+	const size_t numLocals = ctx->numLocals;
+	number_t value = NAN;
+
+	for (size_t p = 0; p < func->numParameters; p++)
+		if (math_pushlocal(ctx, p == work->parameter ? x :
+					work->arguments[p]) == (size_t) -1)
+			goto end;
+	value = math_computefunction(ctx, func);
+
+end:
+	ctx->numLocals = numLocals;
+	return value;
+}
+
+/* the root in [a, b] where fa and fb have opposite signs */
+static number_t solve_brent(MathContext *ctx, const struct solve_work *work,
+		number_t a, number_t b, number_t fa, number_t fb)
+{
+	number_t c = a, fc = fa, d = b - a, e = d;
+	number_t tolerance, m, p, q, r, s;
+
+	for (int i = 0; i < SOLVE_ITERATIONS; i++) {
+		if ((fb > 0) == (fc > 0)) {
+			c = a;
+			fc = fa;
+			d = e = b - a;
+		}
+		/* b is the best guess */
+		if (fabsl(fc) < fabsl(fb)) {
+			a = b;
+			b = c;
+			c = a;
+			fa = fb;
+			fb = fc;
+			fc = fa;
+		}
+		tolerance = 2 * LDBL_EPSILON * fabsl(b) + LDBL_MIN;
+		m = (c - b) / 2;
+		if (fabsl(m) <= tolerance || fb == 0)
+			return b;
+		if (fabsl(e) < tolerance || fabsl(fa) <= fabsl(fb)) {
+			d = e = m;
+		} else {
+			/* secant or inverse quadratic interpolation */
+			s = fb / fa;
+			if (a == c) {
+				p = 2 * m * s;
+				q = 1 - s;
+			} else {
+				q = fa / fc;
+				r = fb / fc;
+				p = s * (2 * m * q * (q - r) -
+						(b - a) * (r - 1));
+				q = (q - 1) * (r - 1) * (s - 1);
+			}
+			if (p > 0)
+				q = -q;
+			else
+				p = -p;
+			/* bisects when the step leaves the bracket or does
+			 * not shrink fast enough
+			 */
+			if (2 * p < MIN(3 * m * q - fabsl(tolerance * q),
+						fabsl(e * q))) {
+				e = d;
+				d = p / q;
+			} else {
+				d = e = m;
+			}
+		}
+		a = b;
+		fa = fb;
+		b += fabsl(d) > tolerance ? d : m > 0 ? tolerance : -tolerance;
+		fb = solve_at(ctx, work, b);
+		if (isnan(fb))
+			return NAN;
+	}
+	return b;
+}
+
+/* samples chunks of the range and refines the roots of each */
+static void solve_worker(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct solve_work *const work = arg;
+	const MathFunction *const func = work->func;
+	const enum math_accuracy accuracy = ctx->accuracy;
+	number_t broadcast[func->numParameters + 1][MATH_BLOCK];
+	const number_t *parameters[func->numParameters + 1];
+	number_t x[SOLVE_CHUNK + 1], y[SOLVE_CHUNK + 1];
+	number_t root, fa, fb, fr;
+	MathBlock block;
+	size_t n;
+
+	memset(&block, 0, sizeof(block));
+	ctx->accuracy = work->accuracy;
+	if (!math_blockfunction(ctx, &block, func)) {
+		work->errorNumber = ctx->errorNumber;
+		__atomic_store_n(&work->error, ctx->error, __ATOMIC_RELAXED);
+		goto end;
+	}
+	for (size_t p = 0; p < func->numParameters; p++) {
+		for (size_t i = 0; i < MATH_BLOCK; i++)
+			broadcast[p][i] = work->arguments[p];
+		parameters[p] = broadcast[p];
+	}
+	for (size_t c = begin; c < end; c++) {
+		number_t *const roots = &work->roots[c * (SOLVE_CHUNK + 1)];
+		size_t count = 0;
+
+		for (size_t i = 0; i <= SOLVE_CHUNK; i++)
+			x[i] = solve_point(work, c * SOLVE_CHUNK + i);
+		ctx->accuracy = work->accuracy;
+		for (size_t i = 0; i <= SOLVE_CHUNK; i += MATH_BLOCK) {
+			n = MIN(SOLVE_CHUNK + 1 - i, (size_t) MATH_BLOCK);
+			parameters[work->parameter] = &x[i];
+			math_computeblock(ctx, &block, parameters, n);
+			memcpy(&y[i], math_blockresult(&block, 0),
+					sizeof(*y) * n);
+		}
+		/* the roots are answers, not pixels */
+		ctx->accuracy = ACCURACY_EXACT;
+		for (size_t i = 0; i < SOLVE_CHUNK; i++) {
+			if (y[i] == 0) {
+				roots[count++] = x[i];
+				continue;
+			}
+			if (isnan(y[i]) || isnan(y[i + 1]) || y[i + 1] == 0 ||
+					(y[i] > 0) == (y[i + 1] > 0))
+				continue;
+			/* the samples may be approximations */
+			fa = solve_at(ctx, work, x[i]);
+			fb = solve_at(ctx, work, x[i + 1]);
+			if (fa == 0 || fb == 0) {
+				roots[count++] = fa == 0 ? x[i] : x[i + 1];
+				continue;
+			}
+			if (isnan(fa) || isnan(fb) || (fa > 0) == (fb > 0))
+				continue;
+			root = solve_brent(ctx, work, x[i], x[i + 1], fa, fb);
+			fr = solve_at(ctx, work, root);
+			/* a pole also changes the sign */
+			if (!(fabsl(fr) <= MIN(fabsl(fa), fabsl(fb))))
+				continue;
+			roots[count++] = root;
+		}
+		if (c * SOLVE_CHUNK + SOLVE_CHUNK == SOLVE_SAMPLES &&
+				y[SOLVE_CHUNK] == 0)
+			roots[count++] = x[SOLVE_CHUNK];
+		work->counts[c] = count;
+	}
+
+end:
+	ctx->accuracy = accuracy;
+	math_freeblock(&block);
+}
+
+/* the roots of the bound function in one parameter between lo and hi,
+ * the arguments are the values of all parameters, the one solved for is
+ * ignored; roots are where the sign changes or a sample is zero, sorted
+ * and those a few ulps apart are one; the context needs the program, a
+ * context that is not a worker of math_parallel() may start threads
+ */
+bool math_solve(MathContext *ctx, const MathFunction *func, size_t parameter,
+		const number_t *arguments, number_t lo, number_t hi,
+		MathList *roots)
+{
+	const size_t numChunks = SOLVE_SAMPLES / SOLVE_CHUNK;
+	struct solve_work work;
+	MathBlock block;
+	size_t count = 0;
+	number_t root, previous = 0;
+	bool result = false;
+
+	memset(roots, 0, sizeof(*roots));
+	if (!isfinite(lo) || !isfinite(hi) ||
+			parameter >= func->numParameters) {
+		math_seterror(ctx, MATH_INVALID_RANGE, 0);
+		return false;
+	}
+	if (hi < lo)
+		return true;
+	/* compiling computes the variables the threads read */
+	memset(&block, 0, sizeof(block));
+	result = math_blockfunction(ctx, &block, func);
+	math_freeblock(&block);
+	if (!result)
+		return false;
+	result = false;
+	memset(&work, 0, sizeof(work));
+	work.func = func;
+	work.parameter = parameter;
+	work.arguments = arguments;
+	work.accuracy = ctx->accuracy;
+	work.lo = lo;
+	work.hi = hi;
+	work.roots = malloc(sizeof(*work.roots) * numChunks *
+			(SOLVE_CHUNK + 1));
+	work.counts = calloc(numChunks, sizeof(*work.counts));
+	if (work.roots == NULL || work.counts == NULL) {
+		math_seterror(ctx, MATH_MEMORY, errno);
+		goto end;
+	}
+	if (ctx->nested)
+		solve_worker(ctx, &work, 0, numChunks);
+	else
+		math_parallel(ctx->program, numChunks, 1, solve_worker, &work,
+				0);
+	if (work.error != MATH_SUCCESS) {
+		math_seterror(ctx, work.error, work.errorNumber);
+		goto end;
+	}
+
+	/* the chunks are in order */
+	roots->values = work.roots;
+	for (size_t c = 0; c < numChunks; c++)
+		for (size_t i = 0; i < work.counts[c]; i++) {
+			root = work.roots[c * (SOLVE_CHUNK + 1) + i];
+			if (count > 0 && fabsl(root - previous) <= 4 *
+					LDBL_EPSILON * MAX(fabsl(root),
+						fabsl(previous)))
+				continue;
+			roots->values[count++] = root;
+			previous = root;
+		}
+	roots->count = count;
+	work.roots = NULL;
+	result = true;
+
+end:
+	free(work.roots);
+	free(work.counts);
+	return result;
+}
+
+/* the roots of a bound `solve(t, a, b, body)` that uses no parameters
+ * around it, see math_isconstant()
+ */
+bool math_solvegroup(MathContext *ctx, const MathGroup *group,
+		MathList *roots)
+{
+	const MathGroup *const name = group->arguments[0];
+	const size_t index = name->type == GROUP_PARAMETER ? name->index : 0;
+	number_t arguments[index + 1];
+	MathFunction func;
+
+	memset(roots, 0, sizeof(*roots));
+	if (name->type != GROUP_PARAMETER) {
+		math_seterror(ctx, MATH_INVALID_CALL, 0);
+		return false;
+	}
+	for (size_t i = 0; i <= index; i++)
+		arguments[i] = NAN;
+	memset(&func, 0, sizeof(func));
+	func.group = group->arguments[3];
+	func.numParameters = index + 1;
+	return math_solve(ctx, &func, index, arguments,
+			math_computegroup(ctx, group->arguments[1]),
+			math_computegroup(ctx, group->arguments[2]), roots);
+}
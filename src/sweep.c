@@ -0,0 +1,373 @@
+#include "cake.h"
+
+/* a sweep computes functions on every point of a grid, its rows are
+ * split into chunks that are computed in blocks and written into a
+ * buffer each; a window of chunks is computed on threads and then
+ * written in order with one large write per chunk
+ */
+
+/* rows of a chunk */
+#define SWEEP_CHUNK (1 << 13)
+/* chunks of a window for every thread */
+#define SWEEP_WINDOW 4
+/* longest csv text of a double and its separator */
+#define SWEEP_NUMBER 25
+
+/* what the threads share */
+struct sweep_work {
+	const MathFunction *const *functions;
+	/* or the indices of the functions of a mapped image */
+	const MathImage *image;
+	const size_t *imageFunctions;
+	size_t numFunctions;
+	const MathAxis *axes;
+	size_t numAxes;
+	enum math_sweep_format format;
+	enum math_accuracy accuracy;
+	size_t numRows;
+	/* first chunk of the window */
+	size_t first;
+	/* the only column of a binary pass */
+	size_t column;
+	/* the output of each chunk of the window */
+	char **buffers;
+	size_t *sizes;
+	size_t bufferSize;
+	/* set by a chunk whose functions could not be compiled */
+	enum math_error error;
+	int errorNumber;
+};
+
+/* the value i of the axis, the last is hi itself */
+static number_t sweep_value(const MathAxis *axis, size_t i)
+{
+	if (axis->count == 1)
+		return axis->lo;
+	if (i == axis->count - 1)
+		return axis->hi;
+	return axis->lo + (axis->hi - axis->lo) * (number_t) i /
+		(number_t) (axis->count - 1);
+}
+
+/* the parameters of count rows from row on, the last axis changes
+ * fastest
+ */
+static void sweep_grid(const struct sweep_work *work, size_t row,
+		size_t count, number_t (*values)[MATH_BLOCK])
+{
+	size_t indices[work->numAxes + 1];
+
+	for (size_t a = work->numAxes; a-- > 0; ) {
+		indices[a] = row % work->axes[a].count;
+		row /= work->axes[a].count;
+	}
+	for (size_t i = 0; i < count; i++) {
+		for (size_t a = 0; a < work->numAxes; a++)
+			values[a][i] = sweep_value(&work->axes[a], indices[a]);
+		for (size_t a = work->numAxes; a-- > 0; ) {
+			if (++indices[a] < work->axes[a].count)
+				break;
+			indices[a] = 0;
+		}
+	}
+}
+
+/* the error of the context ends the sweep */
+static void sweep_fail(struct sweep_work *work, const MathContext *ctx)
+{
+	work->errorNumber = ctx->errorNumber;
+	__atomic_store_n(&work->error, ctx->error, __ATOMIC_RELAXED);
+}
+
+/* computes the functions of the image one row at a time, an image is
+ * used as it is mapped and not compiled
+ */
+static bool sweep_image(MathContext *ctx, const struct sweep_work *work,
+		number_t (*values)[MATH_BLOCK], const size_t *computed,
+		size_t numResults, number_t (*results)[MATH_BLOCK], size_t n)
+{
+	const size_t numLocals = ctx->numLocals;
+
+	for (size_t j = 0; j < n; j++) {
+		for (size_t a = 0; a < work->numAxes; a++)
+			if (math_pushlocal(ctx, values[a][j]) == (size_t) -1)
+				return false;
+		for (size_t r = 0; r < numResults; r++)
+			results[r][j] = math_computeimage(ctx, work->image,
+					work->imageFunctions[computed[r]]);
+		ctx->numLocals = numLocals;
+		if (ctx->error == MATH_INVALID_IMAGE)
+			return false;
+	}
+	return true;
+}
+
+/* computes chunks of the window into their buffers */
+static void sweep_worker(MathContext *ctx, void *arg, size_t begin,
+		size_t end)
+{
+	struct sweep_work *const work = arg;
+	const size_t numAxes = work->numAxes;
+	const size_t numColumns = numAxes + work->numFunctions;
+	number_t values[numAxes + 1][MATH_BLOCK];
+	number_t results[work->image != NULL ? work->numFunctions : 1]
+		[MATH_BLOCK];
+	const number_t *parameters[numAxes + 1];
+	const number_t *columns[numColumns];
+	size_t computed[work->numFunctions];
+	MathBlock block;
+	size_t first, count, size, n, numResults = 0;
+	double d;
+
+	memset(&block, 0, sizeof(block));
+	ctx->accuracy = work->accuracy;
+	/* a binary pass only computes its column */
+	for (size_t f = 0; f < work->numFunctions; f++) {
+		if (work->format == SWEEP_BINARY &&
+				work->column != numAxes + f)
+			continue;
+		if (work->image != NULL) {
+			computed[numResults++] = f;
+		} else if (!math_blockfunction(ctx, &block,
+					work->functions[f])) {
+			sweep_fail(work, ctx);
+			goto end;
+		}
+	}
+	if (work->image == NULL)
+		numResults = block.numResults;
+	for (size_t a = 0; a < numAxes; a++) {
+		parameters[a] = values[a];
+		columns[a] = values[a];
+	}
+	for (size_t c = begin; c < end; c++) {
+		char *const buffer = work->buffers[c];
+
+		first = (work->first + c) * SWEEP_CHUNK;
+		count = MIN(work->numRows - first, (size_t) SWEEP_CHUNK);
+		size = 0;
+		for (size_t i = 0; i < count; i += MATH_BLOCK) {
+			n = MIN(count - i, (size_t) MATH_BLOCK);
+			sweep_grid(work, first + i, n, values);
+			if (work->image != NULL ? !sweep_image(ctx, work,
+						values, computed, numResults,
+						results, n) :
+					numResults > 0 && !math_computeblock(
+						ctx, &block, parameters, n)) {
+				sweep_fail(work, ctx);
+				goto end;
+			}
+			for (size_t r = 0; r < numResults; r++)
+				columns[numAxes + r] = work->image != NULL ?
+					results[r] :
+					math_blockresult(&block, r);
+			if (work->format == SWEEP_BINARY) {
+				/* the results of the block are the column */
+				const number_t *const column =
+					columns[MIN(work->column, numAxes)];
+
+				for (size_t j = 0; j < n; j++) {
+					d = column[j];
+					memcpy(&buffer[size], &d, sizeof(d));
+					size += sizeof(d);
+				}
+				continue;
+			}
+			for (size_t j = 0; j < n; j++)
+				for (size_t k = 0; k < numColumns; k++)
+					size += snprintf(&buffer[size],
+						work->bufferSize - size,
+						"%.*g%c", DBL_DECIMAL_DIG,
+						(double) columns[k][j],
+						k + 1 == numColumns ?
+						'\n' : ',');
+		}
+		work->sizes[c] = size;
+	}
+
+end:
+	math_freeblock(&block);
+}
+
+/* the csv header of the parameter and function names */
+static bool sweep_header(const struct sweep_work *work, FILE *fp)
+{
+	const char *name;
+
+	for (size_t a = 0; a < work->numAxes; a++) {
+		name = work->image != NULL ? math_imageparameter(work->image,
+				work->imageFunctions[0], a) :
+			work->functions[0]->parameters[a];
+		if (fprintf(fp, "%s,", name) < 0)
+			return false;
+	}
+	for (size_t f = 0; f < work->numFunctions; f++) {
+		name = work->image != NULL ? math_imagename(work->image,
+				work->imageFunctions[f]) :
+			work->functions[f]->name;
+		if (fprintf(fp, "%s%c", name[0] == '\0' ? "equation" : name,
+					f + 1 == work->numFunctions ?
+					'\n' : ',') < 0)
+			return false;
+	}
+	return true;
+}
+
+/* the number of rows of the grid, 0 when an axis is not valid */
+static size_t sweep_rows(MathContext *ctx, const MathAxis *axes,
+		size_t numAxes)
+{
+	size_t numRows = 1;
+
+	for (size_t a = 0; a < numAxes; a++) {
+		if (!isfinite(axes[a].lo) || !isfinite(axes[a].hi) ||
+				axes[a].count == 0 ||
+				numRows > SIZE_MAX / axes[a].count) {
+			math_seterror(ctx, MATH_INVALID_RANGE, 0);
+			return 0;
+		}
+		numRows *= axes[a].count;
+	}
+	return numRows;
+}
+
+/* computes the window of chunks on threads and writes them in order */
+static bool sweep_run(MathContext *ctx, struct sweep_work *work, FILE *fp,
+		unsigned numThreads)
+{
+	const size_t numColumns = work->numAxes + work->numFunctions;
+	size_t numChunks, window, numPasses;
+	bool result = false;
+
+	if (numThreads == 0)
+		numThreads = math_threadcount();
+	numChunks = (work->numRows + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+	window = MIN((size_t) numThreads * SWEEP_WINDOW, numChunks);
+	work->accuracy = ctx->accuracy;
+	work->bufferSize = SWEEP_CHUNK * (work->format == SWEEP_BINARY ?
+			sizeof(double) : numColumns * SWEEP_NUMBER + 1);
+	work->buffers = calloc(window, sizeof(*work->buffers));
+	work->sizes = calloc(window, sizeof(*work->sizes));
+	if (work->buffers == NULL || work->sizes == NULL)
+		goto err_memory;
+	for (size_t c = 0; c < window; c++) {
+		work->buffers[c] = malloc(work->bufferSize);
+		if (work->buffers[c] == NULL)
+			goto err_memory;
+	}
+
+	if (work->format == SWEEP_CSV && !sweep_header(work, fp))
+		goto err_write;
+	numPasses = work->format == SWEEP_BINARY ? numColumns : 1;
+	for (size_t pass = 0; pass < numPasses; pass++) {
+		work->column = pass;
+		for (work->first = 0; work->first < numChunks;
+				work->first += window) {
+			const size_t count = MIN(window,
+					numChunks - work->first);
+
+			math_parallel(ctx->program, count, 1, sweep_worker,
+					work, numThreads);
+			if (work->error != MATH_SUCCESS) {
+				math_seterror(ctx, work->error,
+						work->errorNumber);
+				goto end;
+			}
+			for (size_t c = 0; c < count; c++)
+				if (fwrite(work->buffers[c], 1, work->sizes[c],
+							fp) != work->sizes[c])
+					goto err_write;
+		}
+	}
+	result = true;
+	goto end;
+
+err_memory:
+	math_seterror(ctx, MATH_MEMORY, errno);
+	goto end;
+err_write:
+	math_seterror(ctx, MATH_WRITE, errno);
+end:
+	for (size_t c = 0; work->buffers != NULL && c < window; c++)
+		free(work->buffers[c]);
+	free(work->buffers);
+	free(work->sizes);
+	return result;
+}
+
+/* writes the bound functions on every point of the grid of the axes,
+ * one axis for every parameter of the functions, as csv rows or
+ * columns of doubles; the context needs the program, a thread count of
+ * 0 uses all cores
+ */
+bool math_sweep(MathContext *ctx, const MathFunction *const *functions,
+		size_t numFunctions, const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, FILE *fp, unsigned numThreads)
+{
+	struct sweep_work work;
+	MathBlock block;
+
+	if (numFunctions == 0) {
+		math_seterror(ctx, MATH_INVALID_CALL, 0);
+		return false;
+	}
+	for (size_t f = 0; f < numFunctions; f++)
+		if (functions[f]->numParameters != numAxes) {
+			math_seterror(ctx, MATH_INVALID_CALL, 0);
+			return false;
+		}
+	memset(&work, 0, sizeof(work));
+	work.numRows = sweep_rows(ctx, axes, numAxes);
+	if (work.numRows == 0)
+		return false;
+	/* compiling computes the variables the threads read */
+	memset(&block, 0, sizeof(block));
+	for (size_t f = 0; f < numFunctions; f++)
+		if (!math_blockfunction(ctx, &block, functions[f])) {
+			math_freeblock(&block);
+			return false;
+		}
+	math_freeblock(&block);
+
+	work.functions = functions;
+	work.numFunctions = numFunctions;
+	work.axes = axes;
+	work.numAxes = numAxes;
+	work.format = format;
+	return sweep_run(ctx, &work, fp, numThreads);
+}
+
+/* like math_sweep() for the functions of a mapped image by their
+ * indices, computed straight from the image with the values its
+ * variables were written with; no program is needed
+ */
+bool math_sweepimage(MathContext *ctx, const MathImage *image,
+		const size_t *functions, size_t numFunctions,
+		const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, FILE *fp, unsigned numThreads)
+{
+	struct sweep_work work;
+
+	if (numFunctions == 0) {
+		math_seterror(ctx, MATH_INVALID_CALL, 0);
+		return false;
+	}
+	for (size_t f = 0; f < numFunctions; f++)
+		if (functions[f] >= image->header->numFunctions ||
+				image->functions[functions[f]].numParameters !=
+				numAxes) {
+			math_seterror(ctx, MATH_INVALID_CALL, 0);
+			return false;
+		}
+	memset(&work, 0, sizeof(work));
+	work.numRows = sweep_rows(ctx, axes, numAxes);
+	if (work.numRows == 0)
+		return false;
+	work.image = image;
+	work.imageFunctions = functions;
+	work.numFunctions = numFunctions;
+	work.axes = axes;
+	work.numAxes = numAxes;
+	work.format = format;
+	return sweep_run(ctx, &work, fp, numThreads);
+}
@@ -0,0 +1,177 @@
+#include "cake.h"
+
+#define SYSTEM_UNARY(name, expr) \
+static number_t system_##name(MathContext *ctx, number_t x) \
+{ \
+	(void) ctx; \
+	return (expr); \
+}
+
+/* libm or one of the approximations by the accuracy of the context */
+#define SYSTEM_APPROX(name, approx, expr) \
+static number_t system_##name(MathContext *ctx, number_t x) \
+{ \
+	switch (ctx->accuracy) { \
+	case ACCURACY_DOUBLE: \
+		return math_##approx(x); \
+	case ACCURACY_FAST: \
+		return math_##approx##f(x); \
+	default: \
+		return (expr); \
+	} \
+}
+
+SYSTEM_UNARY(floor, floorl(x))
+SYSTEM_UNARY(ceil, ceill(x))
+SYSTEM_APPROX(exp, exp, expl(x))
+SYSTEM_APPROX(erfc, erfc, erfcl(x))
+SYSTEM_APPROX(sqrt, sqrt, sqrtl(x))
+SYSTEM_UNARY(cbrt, cbrtl(x))
+SYSTEM_UNARY(log10, log10l(x))
+SYSTEM_APPROX(ln, log, logl(x))
+SYSTEM_APPROX(sin, sin, sinl(x))
+SYSTEM_APPROX(cos, cos, cosl(x))
+SYSTEM_UNARY(tan, tanl(x))
+SYSTEM_UNARY(cot, 1 / tanl(x))
+SYSTEM_UNARY(sec, 1 / cosl(x))
+SYSTEM_UNARY(csc, 1 / sinl(x))
+SYSTEM_UNARY(sinh, sinhl(x))
+SYSTEM_UNARY(cosh, coshl(x))
+SYSTEM_UNARY(tanh, tanhl(x))
+SYSTEM_UNARY(asinh, asinhl(x))
+SYSTEM_UNARY(acosh, acoshl(x))
+SYSTEM_UNARY(atanh, atanhl(x))
+SYSTEM_APPROX(gamma, gamma, tgammal(x))
+
+static number_t system_digamma(MathContext *ctx, number_t x)
+{
+	number_t result = 0, inv, inv2;
+
+	if (x <= 0 && floorl(x) == x)
+		return NAN;
+	if (x < 0)
+		return system_digamma(ctx, 1 - x) - M_PI / tanl(M_PI * x);
+	for (; x < 6; x++)
+		result -= 1 / x;
+	inv = 1 / x;
+	inv2 = inv * inv;
+	return result + logl(x) - inv / 2 -
+		inv2 * (1.0L / 12 - inv2 * (1.0L / 120 - inv2 / 252));
+}
+
+static number_t system_pow(MathContext *ctx, number_t a, number_t b)
+{
+	(void) ctx;
+	return powl(a, b);
+}
+
+/* the real root, so odd roots of negative numbers are defined */
+static number_t system_root(MathContext *ctx, number_t n, number_t x)
+{
+	(void) ctx;
+	if (x < 0 && fmodl(n, 2) != 0 && floorl(n) == n)
+		return -powl(-x, 1 / n);
+	return powl(x, 1 / n);
+}
+
+static number_t system_log(MathContext *ctx, number_t b, number_t x)
+{
+	(void) ctx;
+	return logl(x) / logl(b);
+}
+
+SYSTEM_UNARY(dfloor, x * 0)
+SYSTEM_UNARY(dexp, expl(x))
+SYSTEM_UNARY(derfc, -2 / sqrtl(M_PI) * expl(-x * x))
+SYSTEM_UNARY(dsqrt, 1 / (2 * sqrtl(x)))
+SYSTEM_UNARY(dcbrt, 1 / (3 * cbrtl(x) * cbrtl(x)))
+SYSTEM_UNARY(dlog10, 1 / (x * logl(10)))
+SYSTEM_UNARY(dln, 1 / x)
+SYSTEM_UNARY(dsin, cosl(x))
+SYSTEM_UNARY(dcos, -sinl(x))
+SYSTEM_UNARY(dtan, 1 / (cosl(x) * cosl(x)))
+SYSTEM_UNARY(dcot, -1 / (sinl(x) * sinl(x)))
+SYSTEM_UNARY(dsec, tanl(x) / cosl(x))
+SYSTEM_UNARY(dcsc, -1 / (tanl(x) * sinl(x)))
+SYSTEM_UNARY(dsinh, coshl(x))
+SYSTEM_UNARY(dcosh, sinhl(x))
+SYSTEM_UNARY(dtanh, 1 / (coshl(x) * coshl(x)))
+SYSTEM_UNARY(dasinh, 1 / sqrtl(x * x + 1))
+SYSTEM_UNARY(dacosh, 1 / sqrtl(x * x - 1))
+SYSTEM_UNARY(datanh, 1 / (1 - x * x))
+SYSTEM_UNARY(dgamma, tgammal(x) * system_digamma(ctx, x))
+
+/* trigamma by the same recurrence and asymptotic series as digamma */
+static number_t system_ddigamma(MathContext *ctx, number_t x)
+{
+	number_t result = 0, inv, inv2;
+
+	if (x <= 0 && floorl(x) == x)
+		return NAN;
+	if (x < 0) {
+		const number_t s = sinl(M_PI * x);
+		return -system_ddigamma(ctx, 1 - x) + M_PI * M_PI / (s * s);
+	}
+	for (; x < 6; x++)
+		result += 1 / (x * x);
+	inv = 1 / x;
+	inv2 = inv * inv;
+	return result + inv + inv2 / 2 +
+		inv2 * inv * (1.0L / 6 - inv2 * (1.0L / 30 - inv2 / 42));
+}
+
+static MathFunction system_functions[] = {
+#define SYSTEM(id, n, f, d) \
+	[SYSTEM_##id] = { \
+		.name = #f, .numParameters = (n), \
+		.system = system_##f, .derivative = (d) \
+	}
+	SYSTEM(FLOOR, 1, floor, system_dfloor),
+	SYSTEM(CEIL, 1, ceil, system_dfloor),
+	SYSTEM(EXP, 1, exp, system_dexp),
+	SYSTEM(POW, 2, pow, NULL),
+	SYSTEM(ERFC, 1, erfc, system_derfc),
+	SYSTEM(SQRT, 1, sqrt, system_dsqrt),
+	SYSTEM(CBRT, 1, cbrt, system_dcbrt),
+	SYSTEM(ROOT, 2, root, NULL),
+	SYSTEM(LOG10, 1, log10, system_dlog10),
+	SYSTEM(LOG, 2, log, NULL),
+	SYSTEM(LN, 1, ln, system_dln),
+	SYSTEM(SIN, 1, sin, system_dsin),
+	SYSTEM(COS, 1, cos, system_dcos),
+	SYSTEM(TAN, 1, tan, system_dtan),
+	SYSTEM(COT, 1, cot, system_dcot),
+	SYSTEM(SEC, 1, sec, system_dsec),
+	SYSTEM(CSC, 1, csc, system_dcsc),
+	SYSTEM(SINH, 1, sinh, system_dsinh),
+	SYSTEM(COSH, 1, cosh, system_dcosh),
+	SYSTEM(TANH, 1, tanh, system_dtanh),
+	SYSTEM(ASINH, 1, asinh, system_dasinh),
+	SYSTEM(ACOSH, 1, acosh, system_dacosh),
+	SYSTEM(ATANH, 1, atanh, system_datanh),
+	SYSTEM(GAMMA, 1, gamma, system_dgamma),
+	SYSTEM(DIGAMMA, 1, digamma, system_ddigamma),
+#undef SYSTEM
+};
+
+MathFunction *math_systemfunction(enum math_system system)
+{
+	if (system >= SYSTEM_MAX)
+		return NULL;
+	return &system_functions[system];
+}
+
+enum math_system math_systemof(const MathFunction *func)
+{
+	if (func < system_functions ||
+			func >= &system_functions[ARRLEN(system_functions)])
+		return SYSTEM_NONE;
+	return func - system_functions;
+}
+
+enum math_system math_systemtoken(enum math_token_type type)
+{
+	if (type < TOKEN_FLOOR || type > TOKEN_GAMMA)
+		return SYSTEM_NONE;
+	return SYSTEM_FLOOR + (type - TOKEN_FLOOR);
+}
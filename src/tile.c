@@ -0,0 +1,182 @@
+#include "cake.h"
+
+int tile_init(TileCache *cache, size_t memory)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->maxTiles = memory / (TILE_SIZE * TILE_SIZE * sizeof(Uint32));
+	if (cache->maxTiles == 0)
+		return 0;
+	/* a power of two, at most one tile per bucket on average */
+	cache->numBuckets = 1;
+	while (cache->numBuckets < cache->maxTiles)
+		cache->numBuckets *= 2;
+	cache->buckets = calloc(cache->numBuckets, sizeof(*cache->buckets));
+	if (cache->buckets == NULL) {
+		fprintf(stderr, "Failed allocating the tile cache: %s\n",
+				strerror(errno));
+		cache->maxTiles = 0;
+		return -1;
+	}
+	return 0;
+}
+
+void tile_uninit(TileCache *cache)
+{
+	Tile *tile, *older;
+
+	for (tile = cache->newest; tile != NULL; tile = older) {
+		older = tile->older;
+		SDL_FreeSurface(tile->surface);
+		free(tile);
+	}
+	free(cache->buckets);
+	memset(cache, 0, sizeof(*cache));
+}
+
+static Tile **tile_bucket(TileCache *cache, uint64_t function, number_t zoom,
+		Sint64 x, Sint64 y)
+{
+	const double z = zoom;
+	uint64_t hash, bits;
+
+	memcpy(&bits, &z, sizeof(bits));
+	hash = function;
+	hash = (hash ^ bits) * 0x100000001b3;
+	hash = (hash ^ (uint64_t) x) * 0x100000001b3;
+	hash = (hash ^ (uint64_t) y) * 0x100000001b3;
+	return &cache->buckets[(hash ^ hash >> 32) &
+		(cache->numBuckets - 1)];
+}
+
+static void tile_unlink(TileCache *cache, Tile *tile)
+{
+	if (tile->newer != NULL)
+		tile->newer->older = tile->older;
+	else
+		cache->newest = tile->older;
+	if (tile->older != NULL)
+		tile->older->newer = tile->newer;
+	else
+		cache->oldest = tile->newer;
+}
+
+static void tile_pushnewest(TileCache *cache, Tile *tile)
+{
+	tile->newer = NULL;
+	tile->older = cache->newest;
+	if (cache->newest != NULL)
+		cache->newest->newer = tile;
+	else
+		cache->oldest = tile;
+	cache->newest = tile;
+}
+
+/* whether count tiles fit into the memory of the cache at once, so that
+ * the tiles of a view do not replace each other; the cache never grows
+ * past its memory
+ */
+int tile_reserve(TileCache *cache, size_t count)
+{
+	return count <= cache->maxTiles ? 0 : -1;
+}
+
+/* removes the tile from its bucket and the order of use */
+static void tile_remove(TileCache *cache, Tile *tile)
+{
+	Tile **link;
+
+	link = tile_bucket(cache, tile->function, tile->zoom, tile->x,
+			tile->y);
+	while (*link != tile)
+		link = &(*link)->next;
+	*link = tile->next;
+	tile_unlink(cache, tile);
+}
+
+/* the tile is used again, so it is the last to be replaced */
+Tile *tile_find(TileCache *cache, uint64_t function, number_t zoom,
+		Sint64 x, Sint64 y)
+{
+	Tile *tile;
+
+	if (cache->maxTiles == 0)
+		return NULL;
+	for (tile = *tile_bucket(cache, function, zoom, x, y); tile != NULL;
+			tile = tile->next)
+		if (tile->function == function && tile->zoom == zoom &&
+				tile->x == x && tile->y == y) {
+			tile_unlink(cache, tile);
+			tile_pushnewest(cache, tile);
+			cache->hits++;
+			return tile;
+		}
+	cache->misses++;
+	return NULL;
+}
+
+/* adds a cleared tile for the caller to draw into, replacing the least
+ * recently used one when the cache is full
+ */
+Tile *tile_insert(TileCache *cache, uint64_t function, number_t zoom,
+		Sint64 x, Sint64 y)
+{
+	Tile **bucket;
+	Tile *tile;
+
+	if (cache->maxTiles == 0)
+		return NULL;
+	if (cache->numTiles == cache->maxTiles) {
+		tile = cache->oldest;
+		tile_remove(cache, tile);
+	} else {
+		tile = malloc(sizeof(*tile));
+		if (tile == NULL)
+			return NULL;
+		tile->surface = SDL_CreateRGBSurfaceWithFormat(0, TILE_SIZE,
+				TILE_SIZE, 32, PLOT_FORMAT);
+		if (tile->surface == NULL) {
+			free(tile);
+			return NULL;
+		}
+		cache->numTiles++;
+	}
+	SDL_FillRect(tile->surface, NULL, 0);
+	tile->function = function;
+	tile->zoom = zoom;
+	tile->x = x;
+	tile->y = y;
+	bucket = tile_bucket(cache, function, zoom, x, y);
+	tile->next = *bucket;
+	*bucket = tile;
+	tile_pushnewest(cache, tile);
+	return tile;
+}
+
+/* frees the tiles of all functions that are not given, they were
+ * changed or removed
+ */
+void tile_retain(TileCache *cache, const uint64_t *functions,
+		size_t numFunctions)
+{
+	Tile *tile, *older;
+	size_t i;
+
+	for (tile = cache->newest; tile != NULL; tile = older) {
+		older = tile->older;
+		for (i = 0; i < numFunctions; i++)
+			if (functions[i] == tile->function)
+				break;
+		if (i != numFunctions)
+			continue;
+		tile_discard(cache, tile);
+	}
+}
+
+/* frees a tile that could not be drawn */
+void tile_discard(TileCache *cache, Tile *tile)
+{
+	tile_remove(cache, tile);
+	SDL_FreeSurface(tile->surface);
+	free(tile);
+	cache->numTiles--;
+}
@@ -0,0 +1,46 @@
+/* format of the plot and its tiles */
+#define PLOT_FORMAT SDL_PIXELFORMAT_ARGB8888
+
+/* width and height of a tile in pixels */
+#define TILE_SIZE 128
+/* pixel memory of all tiles of a plot, a view that needs more tiles is
+ * drawn without them, see tile_reserve()
+ */
+#define TILE_MEMORY (64 << 20)
+
+/* the curves of one equation, or its heat map, in a square of the plot
+ * at one zoom, the pixels are 0 where nothing is drawn
+ */
+typedef struct tile {
+	uint64_t function;
+	number_t zoom;
+	/* position in the plot in tiles, (x * TILE_SIZE, y * TILE_SIZE)
+	 * is the top left pixel at the zoom
+	 */
+	Sint64 x, y;
+	SDL_Surface *surface;
+	/* in the order of use */
+	struct tile *newer, *older;
+	/* next in the same bucket */
+	struct tile *next;
+} Tile;
+
+typedef struct tile_cache {
+	Tile **buckets;
+	size_t numBuckets;
+	/* the oldest is replaced when there are maxTiles */
+	Tile *newest, *oldest;
+	size_t numTiles, maxTiles;
+	size_t hits, misses;
+} TileCache;
+
+int tile_init(TileCache *cache, size_t memory);
+void tile_uninit(TileCache *cache);
+int tile_reserve(TileCache *cache, size_t count);
+Tile *tile_find(TileCache *cache, uint64_t function, number_t zoom,
+		Sint64 x, Sint64 y);
+Tile *tile_insert(TileCache *cache, uint64_t function, number_t zoom,
+		Sint64 x, Sint64 y);
+void tile_retain(TileCache *cache, const uint64_t *functions,
+		size_t numFunctions);
+void tile_discard(TileCache *cache, Tile *tile);
@@ -11,11 +11,15 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 		{ "erfc", TOKEN_ERFC },
 		{ "sqrt", TOKEN_SQRT }, { "cbrt", TOKEN_CBRT }, { "root", TOKEN_ROOT },
 		{ "log10", TOKEN_LOG10 }, { "log", TOKEN_LOG }, { "ln", TOKEN_LN },
+		/* before their prefixes sin, cos and tan */
+		{ "sinh", TOKEN_SINH }, { "cosh", TOKEN_COSH }, { "tanh", TOKEN_TANH },
 		{ "sin", TOKEN_SIN }, { "cos", TOKEN_COS }, { "tan", TOKEN_TAN },
 		{ "cot", TOKEN_COT }, { "sec", TOKEN_SEC }, { "csc", TOKEN_CSC },
-		{ "sinh", TOKEN_SINH }, { "cosh", TOKEN_COSH }, { "tanh", TOKEN_TANH },
 		{ "asinh", TOKEN_ASINH }, { "acosh", TOKEN_ACOSH }, { "atanh", TOKEN_ATANH },
 		{ "gamma", TOKEN_GAMMA },
+		{ "sum", TOKEN_SUM }, { "prod", TOKEN_PROD },
+		{ "integral", TOKEN_INTEGRAL }, { "solve", TOKEN_SOLVE },
+		{ "curve", TOKEN_CURVE },
 
 		{ "and", TOKEN_AND }, { "or", TOKEN_OR }, { "xor", TOKEN_XOR }, { "mod", TOKEN_MOD }
 	};
@@ -23,8 +27,11 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 		['+'] = TOKEN_PLUS, ['-'] = TOKEN_MINUS,
 		['/'] = TOKEN_DIVIDE, ['*'] = TOKEN_MULTIPLY,
 		['%'] = TOKEN_PERCENT,
+		['='] = TOKEN_EQUALS,
 		['!'] = TOKEN_BANG,
 		['^'] = TOKEN_RAISE, ['_'] = TOKEN_LOWER,
+		[','] = TOKEN_COMMA,
+		['.'] = TOKEN_RANGE,
 
 		['('] = TOKEN_OPEN_ROUND, [')'] = TOKEN_CLOSED_ROUND,
 		['{'] = TOKEN_OPEN_CURLY, ['}'] = TOKEN_CLOSED_CURLY,
@@ -78,6 +85,16 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 					strtold(&text[tokenizer->position],
 							&end);
 				len = end - &text[tokenizer->position];
+				/* the `1.` of `1..5` is not the number */
+				if (end[-1] == '.' && end[0] == '.')
+					len--;
+			} else if (token.type == TOKEN_RANGE) {
+				if (text[tokenizer->position + 1] != '.') {
+					ctx->error = MATH_INVALID_TOKEN;
+					ctx->errorNumber = 0;
+					return false;
+				}
+				len = 2;
 			} else {
 				len = 1;
 			}
@@ -88,8 +105,7 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 		for (size_t i = 0; i < ARRLEN(keywords); i++) {
 			len = strlen(keywords[i].word);
 			if (strncmp(keywords[i].word, &text[tokenizer->position],
-					MIN(lenText - tokenizer->position, len))
-					== 0) {
+					len) == 0) {
 				token.type = keywords[i].type;
 				goto end;
 			}
@@ -105,6 +121,15 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 			return false;
 		}
 
+		/* check for special symbols, before the names as ℂ and the
+		 * like are letters
+		 */
+		for (size_t i = 0; i < ARRLEN(specialSymbols); i++)
+			if (specialSymbols[i].symbol == wch) {
+				token.type = specialSymbols[i].type;
+				goto end;
+			}
+
 		if (iswalpha(wch)) {
 			token.type = TOKEN_VARIABLE;
 			memcpy(token.word, &text[tokenizer->position], len);
@@ -112,29 +137,26 @@ bool math_tokenize(MathContext *ctx, MathTokenizer *tokenizer, const char *text)
 			goto end;
 		}
 
-		/* check for special symbols */
-		for (size_t i = 0; i < ARRLEN(specialSymbols); i++)
-			if (specialSymbols[i].symbol == wch) {
-				token.type = specialSymbols[i].type;
-				goto end;
-			}
-
 		/* invalid token */
 		ctx->error = MATH_INVALID_TOKEN;
 		ctx->errorNumber = 0;
 		return false;
 
 	end:
-		newTokens = realloc(tokenizer->tokens,
-				sizeof(*tokenizer->tokens) *
-				(tokenizer->numTokens + 1));
-		if (newTokens == NULL) {
-			/* memory error */
-			ctx->error = MATH_MEMORY;
-			ctx->errorNumber = errno;
-			return false;
+		if (tokenizer->numTokens == tokenizer->maxTokens) {
+			const size_t newMax = tokenizer->maxTokens * 2 + 16;
+
+			newTokens = realloc(tokenizer->tokens,
+					sizeof(*tokenizer->tokens) * newMax);
+			if (newTokens == NULL) {
+				/* memory error */
+				ctx->error = MATH_MEMORY;
+				ctx->errorNumber = errno;
+				return false;
+			}
+			tokenizer->tokens = newTokens;
+			tokenizer->maxTokens = newMax;
 		}
-		tokenizer->tokens = newTokens;
 		tokenizer->tokens[tokenizer->numTokens++] = token;
 		tokenizer->position += len;
 
@@ -1,5 +1,24 @@
 #include "cake.h"
 
+/* pixels a plot is rendered with while dragging or zooming, larger ones
+ * are rendered at a lower resolution and scaled up
+ */
+#define WINDOW_PREVIEW_PIXELS (320 * 240)
+/* milliseconds without dragging or zooming until the plot is rendered
+ * at full resolution again
+ */
+#define WINDOW_SETTLE 150
+/* the variable that is animated */
+#define WINDOW_TIME "t"
+/* milliseconds of a frame at 60 frames a second */
+#define WINDOW_FRAME 16
+/* milliseconds between showing the roots of an animation */
+#define WINDOW_RESULTS 250
+/* coarsest scale of an animated plot */
+#define WINDOW_MAX_SCALE 8
+/* bands of the heat map when they are shown */
+#define WINDOW_HEAT_BANDS 10
+
 static const struct symbols {
 	const char *word;
 	const char *out;
@@ -35,7 +54,7 @@ int window_init(Window *window)
 	window->sdl = SDL_CreateWindow("My SDL2 Window",
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 		640, 480,
-		SDL_WINDOW_SHOWN);
+		SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 	if(window->sdl == NULL) {
 		fprintf(stderr, "Window could not be created: %s\n",
 				SDL_GetError());
@@ -63,7 +82,7 @@ int window_init(Window *window)
 				strerror(errno));
 		goto err;
 	}
-	data[0] = '\0';
+	data[7] = '\0';
 	window->text.lines = malloc(8 * sizeof(*window->text.lines));
 	if (window->text.lines == NULL) {
 		fprintf(stderr, "Failed allocating lines: %s\n",
@@ -72,48 +91,396 @@ int window_init(Window *window)
 	}
 	memset(&window->text.lines[0], 0, sizeof(*window->text.lines));
 	window->text.lines[0].data = data;
+	window->text.lines[0].capacity = 7;
+	window->text.lines[0].address = (size_t) -1;
 	window->text.count = 1;
+	window->text.capacity = 8;
 
-	window->plot = SDL_CreateRGBSurface(0, 640, 480, 32, 0, 0, 0, 0);
-	if (window->plot == NULL) {
-		fprintf(stderr, "Failed creating plot surface: %s\n",
+	if (plot_init(&window->plot, 640, 480) < 0)
+		goto err;
+	window->plot.font = window->font;
+	window->plotTexture = SDL_CreateTexture(window->renderer, PLOT_FORMAT,
+			SDL_TEXTUREACCESS_STREAMING, window->plot.surface->w,
+			window->plot.surface->h);
+	if (window->plotTexture == NULL) {
+		fprintf(stderr, "Plot texture could not be created: %s\n",
 				SDL_GetError());
 		goto err;
 	}
-	window->zoom = 10;
-	window->translation = (Vector) {
-		-32, -24
-	};
+	window->plotChanged = true;
+	window->animation.address = (size_t) -1;
+	window->animation.scale = 1;
+	window->math.program = &window->program;
+	/* the plot can not show the difference to long double */
+	window->math.accuracy = ACCURACY_DOUBLE;
 	return 0;
 err:
 	SDL_DestroyRenderer(window->renderer);
 	SDL_DestroyWindow(window->sdl);
-	SDL_FreeSurface(window->plot);
+	plot_uninit(&window->plot);
 	free(data);
 	free(window->text.lines);
 	return -1;
 }
 
-static void window_updateline(Window *window)
+/* variables and functions are stored apart, equations are functions */
+static bool window_samestore(enum math_definition a, enum math_definition b)
 {
-	struct text *text;
-	struct line *line;
-	MathTokenizer tokenizer;
+	return (a == DEFINITION_VARIABLE) == (b == DEFINITION_VARIABLE);
+}
 
-	text = &window->text;
-	line = &text->lines[text->y];
-	line->data[line->count] = '\0';
-	memset(&tokenizer, 0, sizeof(tokenizer));
-	if (!math_tokenize(&window->math, &tokenizer, line->data)) {
-		printf("tokenizer failed: %s\n", math_error(&window->math));
+static void window_undefine(Window *window, struct line *line)
+{
+	const size_t addr = line->address;
+
+	if (addr == (size_t) -1)
+		return;
+	math_undefine(&window->math, &window->program, line->definition,
+			addr);
+	for (size_t i = 0; i < window->text.count; i++) {
+		struct line *const l = &window->text.lines[i];
+		if (l->address != (size_t) -1 && l->address > addr &&
+				window_samestore(l->definition,
+					line->definition))
+			l->address--;
+	}
+	line->address = (size_t) -1;
+}
+
+static void line_movegap(struct line *line, size_t pos)
+{
+	char *const data = line->data;
+	const size_t gapLength = line->capacity - line->count;
+
+	if (pos < line->gap)
+		memmove(&data[pos + gapLength], &data[pos], line->gap - pos);
+	else
+		memmove(&data[line->gap], &data[line->gap + gapLength],
+				pos - line->gap);
+	line->gap = pos;
+}
+
+static bool line_insert(struct line *line, size_t pos, const char *str,
+		size_t len)
+{
+	char *newData;
+	size_t newCapacity;
+
+	if (line->capacity - line->count < len) {
+		newCapacity = MAX(line->capacity * 2, line->count + len);
+		line_movegap(line, line->count);
+		newData = realloc(line->data, newCapacity + 1);
+		if (newData == NULL)
+			return false;
+		newData[newCapacity] = '\0';
+		line->data = newData;
+		line->capacity = newCapacity;
+	}
+	line_movegap(line, pos);
+	memcpy(&line->data[line->gap], str, len);
+	line->gap += len;
+	line->count += len;
+	SDL_DestroyTexture(line->texture);
+	line->texture = NULL;
+	line->h = 0;
+	return true;
+}
+
+static void line_erase(struct line *line, size_t pos, size_t len)
+{
+	line_movegap(line, pos);
+	line->count -= len;
+	SDL_DestroyTexture(line->texture);
+	line->texture = NULL;
+	line->h = 0;
+}
+
+static char line_at(const struct line *line, size_t pos)
+{
+	if (pos >= line->gap)
+		pos += line->capacity - line->count;
+	return line->data[pos];
+}
+
+/* copies the line without the gap into the scratch buffer */
+static const char *window_linetext(Window *window, const struct line *line)
+{
+	const size_t gapLength = line->capacity - line->count;
+	char *newScratch;
+
+	if (window->scratchSize <= line->count) {
+		newScratch = realloc(window->scratch, line->count + 1);
+		if (newScratch == NULL)
+			return "";
+		window->scratch = newScratch;
+		window->scratchSize = line->count + 1;
+	}
+	memcpy(window->scratch, line->data, line->gap);
+	memcpy(&window->scratch[line->gap],
+			&line->data[line->gap + gapLength],
+			line->count - line->gap);
+	window->scratch[line->count] = '\0';
+	return window->scratch;
+}
+
+/* makes room for n empty lines at index y */
+static bool window_insertlines(Window *window, size_t y, size_t n)
+{
+	struct text *const text = &window->text;
+	struct line *newLines;
+	size_t newCapacity;
+
+	if (text->capacity - text->count < n) {
+		newCapacity = MAX(text->capacity * 2, text->count + n);
+		newLines = realloc(text->lines, sizeof(*text->lines) *
+				newCapacity);
+		if (newLines == NULL)
+			return false;
+		text->lines = newLines;
+		text->capacity = newCapacity;
+	}
+	memmove(&text->lines[y + n], &text->lines[y],
+			sizeof(*text->lines) * (text->count - y));
+	for (size_t i = y; i < y + n; i++) {
+		struct line *const line = &text->lines[i];
+		memset(line, 0, sizeof(*line));
+		line->address = (size_t) -1;
+		line->data = malloc(8);
+		if (line->data == NULL) {
+			for (size_t j = y; j < i; j++)
+				free(text->lines[j].data);
+			memmove(&text->lines[y], &text->lines[y + n],
+					sizeof(*text->lines) *
+					(text->count - y));
+			return false;
+		}
+		line->data[7] = '\0';
+		line->capacity = 7;
+	}
+	text->count += n;
+	return true;
+}
+
+/* removes n lines at index y and what they define, the program must be
+ * bound afterwards
+ */
+static void window_removelines(Window *window, size_t y, size_t n)
+{
+	struct text *const text = &window->text;
+
+	for (size_t i = y; i < y + n; i++) {
+		struct line *const line = &text->lines[i];
+
+		window_undefine(window, line);
+		SDL_DestroyTexture(line->texture);
+		SDL_DestroyTexture(line->result);
+		free(line->data);
+	}
+	text->count -= n;
+	memmove(&text->lines[y], &text->lines[y + n],
+			sizeof(*text->lines) * (text->count - y));
+}
+
+/* the heat map shows the equation of the first line that defines one,
+ * wherever it is in the program
+ */
+static size_t window_heatequation(const Window *window)
+{
+	const MathProgram *const program = &window->program;
+	size_t n = 0;
+
+	for (size_t i = 0; i < window->text.count; i++) {
+		const struct line *const line = &window->text.lines[i];
+
+		if (line->address == (size_t) -1 ||
+				line->definition != DEFINITION_EQUATION)
+			continue;
+		for (size_t j = 0; j < line->address; j++)
+			n += program->functions[j].name[0] == '\0';
+		return n;
+	}
+	return 0;
+}
+
+/* binds the whole program again and finds the variable that is
+ * animated and the equation of the heat map
+ */
+static void window_bind(Window *window)
+{
+	MathContext *const ctx = &window->math;
+	const MathProgram *const program = &window->program;
+	struct animation *const animation = &window->animation;
+
+	if (!math_bindprogram(ctx, &window->program))
+		printf("binding failed: %s\n", math_error(ctx));
+	animation->address = (size_t) -1;
+	for (size_t i = 0; i < program->numVariables; i++)
+		if (strcmp(program->variables[i].name, WINDOW_TIME) == 0) {
+			animation->address = i;
+			animation->start = program->variables[i].value;
+		}
+	window->plot.heatEquation = window_heatequation(window);
+	plot_invalidate(&window->plot, ctx);
+	window->programChanged = false;
+	window->plotChanged = true;
+	window->resultsChanged = true;
+}
+
+/* binds the program if a line changed it, nothing may be computed
+ * before that
+ */
+static void window_bindchanged(Window *window)
+{
+	if (window->programChanged)
+		window_bind(window);
+}
+
+/* defines the line again, in place while it defines the same kind so
+ * that the definitions keep the order of the lines; the program must
+ * be bound afterwards
+ */
+static void window_defineline(Window *window, struct line *line)
+{
+	MathContext *const ctx = &window->math;
+	const char *text;
+	int redefined;
+
+	if (line->count == 0) {
+		window_undefine(window, line);
+		return;
+	}
+	text = window_linetext(window, line);
+	if (line->address != (size_t) -1) {
+		redefined = math_redefine(ctx, &window->program, text,
+				line->definition, line->address);
+		if (redefined > 0)
+			return;
+		window_undefine(window, line);
+		if (redefined < 0)
+			goto err;
+	}
+	if (math_define(ctx, &window->program, text, &line->definition,
+				&line->address))
+		return;
+err:
+	printf("parsing failed: %s\n", math_error(ctx));
+	line->address = (size_t) -1;
+}
+
+/* defines the line again, the whole program is bound once in the next
+ * frame since other lines may refer to what it defines
+ */
+static void window_updateline(Window *window, struct line *line)
+{
+	window_defineline(window, line);
+	window->programChanged = true;
+}
+
+/* inserts the clipboard at the caret, every further line of it
+ * becomes a new line after the current one and the text after the
+ * caret ends the last one; the program is bound once for all lines
+ * in the next frame
+ */
+static void window_paste(Window *window)
+{
+	struct text *const text = &window->text;
+	struct line *line = &text->lines[text->y];
+	char *clipboard, *start, *end, *next;
+	char *tail = NULL;
+	size_t tailLength = 0;
+	size_t numLines = 0;
+	size_t y, pos;
+
+	clipboard = SDL_GetClipboardText();
+	if (clipboard == NULL)
 		return;
+	for (end = clipboard; *end != '\0'; end++)
+		numLines += *end == '\n';
+	if (numLines > 0 && text->x < line->count) {
+		tailLength = line->count - text->x;
+		tail = malloc(tailLength);
+		if (tail == NULL) {
+			printf("pasting failed: %s\n", strerror(errno));
+			SDL_free(clipboard);
+			return;
+		}
+		for (size_t i = 0; i < tailLength; i++)
+			tail[i] = line_at(line, text->x + i);
 	}
-	if (!math_parsegroup(&window->math, &tokenizer)) {
-		math_freetokenizer(&window->math, &tokenizer);
-		printf("parser failed: %s\n", math_error(&window->math));
+	if (numLines > 0 && !window_insertlines(window, text->y + 1,
+				numLines)) {
+		printf("pasting failed: %s\n", strerror(errno));
+		free(tail);
+		SDL_free(clipboard);
 		return;
 	}
-	math_freetokenizer(&window->math, &tokenizer);
+	if (tail != NULL)
+		line_erase(&text->lines[text->y], text->x, tailLength);
+	start = clipboard;
+	y = text->y;
+	pos = text->x;
+	while (1) {
+		line = &text->lines[y];
+		next = strchr(start, '\n');
+		end = next != NULL ? next : start + strlen(start);
+		if (end > start && end[-1] == '\r')
+			end--;
+		if (!line_insert(line, pos, start, end - start)) {
+			printf("pasting failed: %s\n", strerror(errno));
+			/* the text after the caret stays where it was and
+			 * the lines that were not reached are removed
+			 */
+			window_removelines(window, y + 1,
+					text->y + numLines - y);
+			line = &text->lines[y];
+			next = NULL;
+		} else {
+			pos += end - start;
+		}
+		if (next == NULL) {
+			if (tail != NULL && !line_insert(line, pos, tail,
+						tailLength))
+				printf("pasting failed: %s\n",
+						strerror(errno));
+			window_defineline(window, line);
+			break;
+		}
+		window_defineline(window, line);
+		start = next + 1;
+		pos = 0;
+		y++;
+	}
+	text->y = y;
+	text->x = pos;
+	window->programChanged = true;
+	free(tail);
+	SDL_free(clipboard);
+}
+
+/* shows the heat map of the first equation line fitted to the view, or
+ * hides it
+ */
+static void window_toggleheat(Window *window)
+{
+	Plot *const plot = &window->plot;
+
+	window_bindchanged(window);
+	if (plot->heat.lo < plot->heat.hi)
+		plot_setheat(plot, (PlotHeat) { 0, 0, plot->heat.bands });
+	else if (!plot_fitheat(plot, &window->math))
+		return;
+	window->plotChanged = true;
+}
+
+/* shows or hides the bands of the heat map */
+static void window_togglebands(Window *window)
+{
+	Plot *const plot = &window->plot;
+	PlotHeat heat = plot->heat;
+
+	heat.bands = heat.bands > 0 ? 0 : WINDOW_HEAT_BANDS;
+	plot_setheat(plot, heat);
+	window->plotChanged = true;
 }
 
 static void window_handlekeyboard(Window *window, SDL_KeyboardEvent *key)
@@ -125,63 +492,53 @@ static void window_handlekeyboard(Window *window, SDL_KeyboardEvent *key)
 	line = &text->lines[text->y];
 	switch (key->keysym.sym) {
 	case SDLK_TAB: {
-		char *start, *end;
-		size_t len;
+		size_t start, end, len;
 		char ch;
 		/* get the word we are on */
-		start = &line->data[text->x];
+		start = text->x;
 		end = start;
-		if (text->x > 0) {
-			for (; (ch = *(--start)) == '_' || isalpha(ch); );
-			start++;
-		}
-		for (; (ch = *end) == '_' || isalpha(ch); end++);
+		for (; start > 0 && ((ch = line_at(line, start - 1)) == '_' ||
+					isalpha(ch)); start--);
+		for (; end < line->count && ((ch = line_at(line, end)) == '_' ||
+					isalpha(ch)); end++);
 		len = end - start;
 		if (len == 0)
 			break;
+		const char *const word = &window_linetext(window, line)[start];
 		for (size_t i = 0; i < ARRLEN(math_symbols); i++) {
-			const char *const word = math_symbols[i].word;
-			if (strncmp(word, start, end - start) == 0 &&
-					word[len] == '\0') {
+			const char *const symbol = math_symbols[i].word;
+			if (strncmp(symbol, word, len) == 0 &&
+					symbol[len] == '\0') {
 				const char *const out = math_symbols[i].out;
 				const size_t outLen = strlen(out);
-				const size_t s = start - line->data;
-				const size_t e = end - line->data;
-				memmove(start + outLen, end, line->count - e);
-				memmove(start, out, outLen);
-				line->count -= len - outLen;
-				text->x = s + outLen;
-				window_updateline(window);
+				line_erase(line, start, len);
+				line_insert(line, start, out, outLen);
+				text->x = start + outLen;
+				window_updateline(window, line);
 				break;
 			}
 		}
 		break;
 	}
 
-	case SDLK_RETURN: {
-		char *data;
-
-		data = malloc(8);
-		if (data == NULL)
-			break;
-		data[0] = '\0';
-		line = realloc(text->lines, sizeof(*text->lines) *
-				(text->count + 1));
-		if (line == NULL) {
-			free(data);
+	case SDLK_RETURN:
+		if (!window_insertlines(window, text->y + 1, 1))
 			break;
-		}
-		text->lines = line;
 		text->x = 0;
 		text->y++;
-		line += text->y;
-		memmove(&line[1], &line[0], sizeof(*line) *
-				(text->count - text->y));
-		line->data = data;
-		line->count = 0;
-		text->count++;
 		break;
-	}
+
+	case SDLK_v:
+		if (key->keysym.mod & KMOD_CTRL)
+			window_paste(window);
+		break;
+
+	case SDLK_F2:
+		window_toggleheat(window);
+		break;
+	case SDLK_F3:
+		window_togglebands(window);
+		break;
 
 	case SDLK_HOME:
 		text->x = 0;
@@ -214,18 +571,16 @@ static void window_handlekeyboard(Window *window, SDL_KeyboardEvent *key)
 		if (text->x == 0) {
 			if (line->count > 0 || text->count == 1)
 				break;
-			text->count--;
-			memmove(&line[0], &line[1], sizeof(*line) *
-					(text->count - text->y));
+			window_removelines(window, text->y, 1);
+			window->programChanged = true;
+			if (text->y == text->count)
+				text->y--;
 			text->x = text->lines[text->y].count;
 			break;
 		}
-		line->count--;
 		text->x--;
-		memmove(&line->data[text->x],
-			&line->data[text->x + 1],
-			line->count - text->x);
-		window_updateline(window);
+		line_erase(line, text->x, 1);
+		window_updateline(window, line);
 		break;
 	}
 }
@@ -235,235 +590,292 @@ static void window_inputtext(Window *window, const char *utf8)
 	struct text *const text = &window->text;
 	struct line *const line = &text->lines[text->y];
 	const size_t len = strlen(utf8);
-	char *const newData = realloc(line->data, line->count + len + 1);
-	if (newData == NULL)
+
+	if (!line_insert(line, text->x, utf8, len))
 		return;
-	line->data = newData;
-	memmove(&line->data[text->x + len],
-		&line->data[text->x],
-		line->count - text->x);
-	memcpy(&line->data[text->x], utf8, len);
 	text->x += len;
-	line->count += len;
-	window_updateline(window);
+	window_updateline(window, line);
+}
+
+/* the roots of a `a = solve(...)` line are written after it like a
+ * list literal, at most a few of them
+ */
+static void window_renderresult(Window *window, struct line *line)
+{
+	const MathVariable *var;
+	SDL_Surface *surface;
+	char text[512];
+	size_t length, i;
+
+	SDL_DestroyTexture(line->result);
+	line->result = NULL;
+	if (line->definition != DEFINITION_VARIABLE ||
+			line->address == (size_t) -1)
+		return;
+	var = &window->program.variables[line->address];
+	if (var->group->type != GROUP_SOLVE || var->list == NULL)
+		return;
+	length = snprintf(text, sizeof(text), "  = [");
+	for (i = 0; i < var->list->count && i < 8; i++)
+		length += snprintf(&text[length], sizeof(text) - length,
+				"%s%.*Lg", i == 0 ? "" : ", ", LDBL_DIG,
+				math_listelement(var->list, i));
+	snprintf(&text[length], sizeof(text) - length, "%s]",
+			i < var->list->count ? ", ..." : "");
+	surface = TTF_RenderUTF8_Solid(window->font, text,
+			(SDL_Color) { 150, 150, 150, 255 });
+	if (surface == NULL)
+		return;
+	line->result = SDL_CreateTextureFromSurface(window->renderer, surface);
+	line->resultW = surface->w;
+	line->resultH = surface->h;
+	SDL_FreeSurface(surface);
 }
 
+/* only lines that changed are rendered again */
 static void window_renderlines(Window *window)
 {
 	SDL_Renderer *renderer;
 	struct text *text;
 	SDL_Surface *surface;
-	SDL_Texture *texture;
 	SDL_Color textColor;
 	SDL_Rect rect;
+	int w, h;
 
 	renderer = window->renderer;
 	text = &window->text;
 	textColor = (SDL_Color) { 205, 140, 0, 255 };
+	/* an animation changes them every frame, they are shown again
+	 * after a while only
+	 */
+	if (window->resultsChanged &&
+			(window->animation.address == (size_t) -1 ||
+			 SDL_GetTicks64() - window->animation.resultTicks >=
+			 WINDOW_RESULTS)) {
+		for (size_t i = 0; i < text->count; i++)
+			window_renderresult(window, &text->lines[i]);
+		window->resultsChanged = false;
+		window->animation.resultTicks = SDL_GetTicks64();
+	}
 	rect.x = 0;
 	rect.y = 0;
-	for (size_t i = 0; i < text->count; i++) {
+	for (size_t i = 0; i < text->count &&
+			rect.y < window->plot.surface->h; i++) {
 		struct line *const line = &text->lines[i];
-		int w, h;
-
-		TTF_SizeUTF8(window->font, &line->data[text->x], &w, &h);
-		surface = TTF_RenderUTF8_Solid(window->font, line->data,
-				textColor);
-		if (surface != NULL) {
-			texture = SDL_CreateTextureFromSurface(renderer, surface);
-			rect.w = surface->w;
-			rect.h = surface->h;
-			SDL_RenderCopy(renderer, texture, NULL, &rect);
-			rect.y += surface->h;
-			SDL_FreeSurface(surface);
-			SDL_DestroyTexture(texture);
-		} else {
-			rect.y += h;
-			rect.w = w;
-			rect.h = h;
+
+		if (line->h == 0) {
+			const char *const data = window_linetext(window, line);
+			TTF_SizeUTF8(window->font, data, &line->w, &line->h);
+			surface = TTF_RenderUTF8_Solid(window->font, data,
+					textColor);
+			if (surface != NULL) {
+				line->texture = SDL_CreateTextureFromSurface(
+						renderer, surface);
+				line->w = surface->w;
+				line->h = surface->h;
+				SDL_FreeSurface(surface);
+			}
+		}
+		rect.w = line->w;
+		rect.h = line->h;
+		if (line->texture != NULL)
+			SDL_RenderCopy(renderer, line->texture, NULL, &rect);
+		if (line->result != NULL) {
+			const SDL_Rect result = {
+				rect.x + rect.w, rect.y,
+				line->resultW, line->resultH
+			};
+			SDL_RenderCopy(renderer, line->result, NULL, &result);
 		}
 		if (i == text->y) {
+			/* the text after the caret is right behind the gap */
+			line_movegap(line, text->x);
+			TTF_SizeUTF8(window->font, &line->data[line->gap +
+					line->capacity - line->count], &w, &h);
 			const SDL_Rect caret = {
-				rect.x + rect.w - w, rect.y - h,
+				rect.x + rect.w - w, rect.y,
 				2, rect.h
 			};
 			SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
 			SDL_RenderFillRect(renderer, &caret);
 		}
+		rect.y += line->h;
 	}
 }
 
-static void window_renderplot(Window *window)
+/* gives the plot and its texture the size of the window */
+static void window_resize(Window *window, int width, int height)
 {
-	SDL_Renderer *renderer;
-	SDL_Color textColor;
-	SDL_Surface *surface;
 	SDL_Texture *texture;
-	SDL_Rect rect;
-	SDL_Surface *plot;
-	Uint32 dark, light;
-	Uint32 *pixels;
-	number_t invZoom;
-	Sint32 tx, ty;
-	Sint32 cellSize;
-	MathContext *ctx;
-	size_t xAddr, yAddr;
-	char buf[800];
 
-	renderer = window->renderer;
-	textColor = (SDL_Color) { 205, 140, 0, 255 };
-	plot = window->plot;
-	SDL_LockSurface(plot);
-	dark = SDL_MapRGB(plot->format, 0, 60, 255);
-	light = SDL_MapRGB(plot->format, 0, 60, 155);
-	pixels = plot->pixels;
-	for (size_t i = 0; i < (size_t) plot->w * (size_t) plot->h; i++)
-		pixels[i] = SDL_MapRGB(plot->format, 14, 10, 25);
-	invZoom = 1 / window->zoom;
-
-	cellSize = 100 * window->zoom;
-	cellSize %= 200;
-	if (cellSize < 50)
-		cellSize = 200 - cellSize;
-
-	tx = (Sint32) (window->zoom * window->translation.x) % cellSize;
-	ty = (Sint32) (window->zoom * window->translation.y) % cellSize;
-	if (window->translation.x > 0)
-		tx -= cellSize;
-	if (window->translation.y > 0)
-		ty -= cellSize;
-
-	for (Sint32 i = -1; i <= plot->w / cellSize; i++) {
-		const Sint32 x = i * cellSize - tx;
-		for (Sint32 j = 0; j < plot->h; j++) {
-			for (Sint32 n = 0; n < 4; n++) {
-				const Sint32 nx = x + n * cellSize / 4;
-				if (nx < 0 || nx >= plot->w)
-					continue;
-				pixels[nx + j * plot->w] = n == 0 ? dark :
-					light;
-			}
-		}
-	}
+	if (width <= 0 || height <= 0 ||
+			plot_resize(&window->plot, width, height) < 0)
+		return;
+	texture = SDL_CreateTexture(window->renderer, PLOT_FORMAT,
+			SDL_TEXTUREACCESS_STREAMING, width, height);
+	if (texture == NULL)
+		fprintf(stderr, "Plot texture could not be created: %s\n",
+				SDL_GetError());
+	SDL_DestroyTexture(window->plotTexture);
+	window->plotTexture = texture;
+	window->plotChanged = true;
+}
 
-	for (Sint32 i = -1; i <= plot->h / cellSize; i++) {
-		const Sint32 y = i * cellSize - ty;
-		for (Sint32 j = 0; j < plot->w; j++) {
-			for (Sint32 n = 0; n < 4; n++) {
-				const Sint32 ny = y + n * cellSize / 4;
-				if (ny < 0 || ny >= plot->h)
-					continue;
-				pixels[j + ny * plot->w] = n == 0 ? dark :
-					light;
-			}
-		}
+/* renders the plot at the scale of the animation, and large plots at a
+ * lower resolution until dragging and zooming settle
+ */
+static void window_updatescale(Window *window)
+{
+	Plot *const plot = &window->plot;
+	SDL_Surface *const surface = plot->surface;
+	int scale = window->animation.scale;
+
+	if (SDL_GetTicks64() - window->interaction < WINDOW_SETTLE)
+		while ((surface->w / scale) * (surface->h / scale) >
+				WINDOW_PREVIEW_PIXELS)
+			scale++;
+	if (scale != plot->scale) {
+		plot->scale = scale;
+		window->plotChanged = true;
 	}
+}
 
-	ctx = &window->math;
-	xAddr = math_pushlocal(ctx, 0);
-	yAddr = math_pushlocal(ctx, 0);
-	for (MathFunction *f = ctx->functions,
-			*e = &ctx->functions[ctx->numFunctions];
-			f != e; f++) {
-		number_t values[(plot->w + 2) * (plot->h + 2)];
-		for (Sint32 i = -1; i <= plot->w; i++) {
-			for (Sint32 j = -1; j <= plot->h; j++) {
-				number_t x, y, v;
-
-				x = i * invZoom + window->translation.x;
-				y = -(j * invZoom + window->translation.y);
-				math_setlocal(ctx, xAddr, x);
-				math_setlocal(ctx, yAddr, y);
-				v = math_computefunction(ctx, f);
-				values[i + 1 + (j + 1) * plot->w] = v;
-			}
-		}
-		for (Sint32 i = 0; i < plot->w; i++) {
-			for (Sint32 j = 0; j < plot->h; j++) {
-				Sint32 config = 0;
-
-				const Sint32 ind = i + 1 + (j + 1) * plot->w;
-				config |= (values[ind] > 0) << 0;
-				config |= (values[ind + 1] > 0) << 1;
-				config |= (values[ind + 1 - plot->w] > 0) << 2;
-				config |= (values[ind - plot->w] > 0) << 3;
-				if (config == 0 || config == 15)
-					continue;
-				pixels[i + j * plot->w] =
-					SDL_MapRGB(plot->format, 0, 255, 0);
-			}
-		}
-	}
-	math_poplocal(ctx);
-	math_poplocal(ctx);
-
-	SDL_UnlockSurface(plot);
-
-	/* numbers on the x axis */
-	for (Sint32 i = -1; i <= plot->w / cellSize; i++) {
-		const Sint32 x = i * cellSize - tx;
-		sprintf(buf, "%.1LF", x * invZoom + window->translation.x);
-		surface = TTF_RenderUTF8_Solid(window->font, buf, textColor);
-		rect = (SDL_Rect) {
-			.x = x - surface->w / 2,
-			.y = -window->translation.y * window->zoom,
-			.w = surface->w,
-			.h = surface->h,
-		};
-		if (rect.y < 0)
-			rect.y = 0;
-		else if (rect.y > plot->h - surface->h)
-			rect.y = plot->h - surface->h;
-		SDL_BlitSurface(surface, NULL, window->plot, &rect);
-		SDL_FreeSurface(surface);
-	}
+/* an animated plot that did not fit into its frame is rendered at a
+ * lower resolution, one that would fit at a higher resolution too at a
+ * higher one; the time grows with the pixels
+ */
+static void window_adaptscale(Window *window, Uint64 ticks)
+{
+	struct animation *const animation = &window->animation;
+	const Uint64 scale = animation->scale;
+
+	if (animation->address == (size_t) -1)
+		animation->scale = 1;
+	else if (window->plot.pendingTiles > 0 ||
+			ticks > WINDOW_FRAME * 3 / 4)
+		animation->scale = MIN(animation->scale + 1, WINDOW_MAX_SCALE);
+	else if (scale > 1 && ticks * scale * scale <
+			WINDOW_FRAME / 2 * (scale - 1) * (scale - 1))
+		animation->scale--;
+}
 
-	/* numbers on the y axis */
-	for (Sint32 i = -1; i <= plot->h / cellSize; i++) {
-		const Sint32 y = i * cellSize - ty;
-		sprintf(buf, "%.1LF", y * invZoom + window->translation.y);
-		surface = TTF_RenderUTF8_Solid(window->font, buf, textColor);
-		rect = (SDL_Rect) {
-			.x = -window->translation.x * window->zoom,
-			.y = y - surface->h / 2,
-			.w = surface->w,
-			.h = surface->h,
-		};
-		if (rect.x < 0)
-			rect.x = 0;
-		else if (rect.x > plot->w - surface->w)
-			rect.x = plot->w - surface->w;
-		SDL_BlitSurface(surface, NULL, window->plot, &rect);
-		SDL_FreeSurface(surface);
-	}
+/* sets the animated variable to the time of the frame, the tiles of
+ * the equations that read it are dropped
+ */
+static void window_animate(Window *window, Uint64 now)
+{
+	struct animation *const animation = &window->animation;
+	MathContext *const ctx = &window->math;
+
+	if (animation->address == (size_t) -1)
+		return;
+	/* the errors were shown when binding */
+	math_setvariable(ctx, &window->program, animation->address,
+			animation->start +
+			(now - animation->startTicks) / 1000.0L);
+	plot_invalidate(&window->plot, ctx);
+	window->plotChanged = true;
+	window->resultsChanged = true;
+}
+
+/* counts the frames that missed their time, the vertical sync then
+ * waits for the next one; an animation reports them every second
+ */
+static void window_countframe(Window *window, Uint64 ticks, Uint64 now)
+{
+	struct animation *const animation = &window->animation;
+
+	animation->frames++;
+	if (ticks > WINDOW_FRAME + WINDOW_FRAME / 2)
+		animation->dropped += (ticks + WINDOW_FRAME / 2) /
+			WINDOW_FRAME - 1;
+	if (now - animation->reportTicks < 1000)
+		return;
+	if (animation->address != (size_t) -1 && animation->dropped > 0)
+		printf("%zu frames shown, %zu dropped\n", animation->frames,
+				animation->dropped);
+	animation->frames = 0;
+	animation->dropped = 0;
+	animation->reportTicks = now;
+}
+
+/* the plot is only rendered again when it changed or tiles are missing
+ * and the texture is only written after a render, with the part of the
+ * surface that is shown; missing tiles are computed until the deadline
+ * and over the next frames
+ */
+static void window_renderplot(Window *window, Uint64 deadline)
+{
+	Plot *const plot = &window->plot;
+	SDL_Surface *const surface = plot->surface;
+	const int scale = plot->scale;
+	/* the rest is covered by the text */
+	const SDL_Rect shown = { 160, 0, surface->w - 160, surface->h };
+	/* and the rendered part of the surface that is scaled to it */
+	const SDL_Rect visible = {
+		160 / scale, 0,
+		surface->w / scale - 160 / scale, surface->h / scale
+	};
+	SDL_Rect rect;
+	Uint8 *pixels;
+	int pitch;
 
-	texture = SDL_CreateTextureFromSurface(renderer, plot);
-	rect = (SDL_Rect) { 160, 0, plot->w - 160, plot->h };
-	SDL_RenderCopy(renderer, texture, &rect, &rect);
-	SDL_DestroyTexture(texture);
+	if (window->plotChanged || plot->pendingTiles > 0) {
+		const Uint64 start = SDL_GetTicks64();
+
+		plot->tileTime = deadline > start ? deadline - start : 1;
+		plot_render(plot, &window->math);
+		window->plotChanged = false;
+		window_adaptscale(window, SDL_GetTicks64() - start);
+	}
+	if (SDL_IntersectRect(&plot->dirty, &visible, &rect) &&
+			SDL_LockTexture(window->plotTexture, &rect,
+				(void **) &pixels, &pitch) == 0) {
+		const Uint8 *source = (Uint8 *) surface->pixels +
+			rect.y * surface->pitch +
+			rect.x * surface->format->BytesPerPixel;
+		for (int j = 0; j < rect.h; j++) {
+			memcpy(pixels, source, (size_t) rect.w *
+					surface->format->BytesPerPixel);
+			pixels += pitch;
+			source += surface->pitch;
+		}
+		SDL_UnlockTexture(window->plotTexture);
+		plot->dirty.w = 0;
+	}
+	SDL_RenderCopy(window->renderer, window->plotTexture, &visible,
+			&shown);
 }
 
-static void window_render(Window *window)
+/* the plot comes first in the time of the frame, the roots of an
+ * animation are deferred
+ */
+static void window_render(Window *window, Uint64 deadline)
 {
 	window_renderlines(window);
-	window_renderplot(window);
+	window_renderplot(window, deadline);
 }
 
 int window_show(Window *window)
 {
+	Plot *const plot = &window->plot;
 	Uint64 start, end, ticks;
 	SDL_Event event;
 	const number_t zoomFactor = 1.1;
+	const number_t baseZoom = plot->zoom;
+	int zoomLevel = 0;
 
 	SDL_StartTextInput();
 	start = SDL_GetTicks64();
+	window->animation.startTicks = start;
+	window->animation.reportTicks = start;
 	while (1) {
 		SDL_SetRenderDrawColor(window->renderer, 0, 0, 0, 0);
 		SDL_RenderClear(window->renderer);
 		end = SDL_GetTicks64();
 		ticks = end - start;
 		start = end;
-		(void) ticks; /* TODO: */
+		window_countframe(window, ticks, start);
 		while (SDL_PollEvent(&event)) {
 			switch (event.type) {
 			case SDL_QUIT:
@@ -475,33 +887,58 @@ int window_show(Window *window)
 			case SDL_MOUSEMOTION:
 				if (!(event.motion.state & SDL_BUTTON_LMASK))
 					break;
-				window->translation.x -= event.motion.xrel / window->zoom;
-				window->translation.y -= event.motion.yrel / window->zoom;
+				plot->translation.x -= event.motion.xrel / plot->zoom;
+				plot->translation.y -= event.motion.yrel / plot->zoom;
+				window->interaction = SDL_GetTicks64();
+				window->plotChanged = true;
 				break;
 			case SDL_MOUSEWHEEL: {
 				number_t oldZoom;
 				int mx, my;
 				number_t x, y;
 
-				oldZoom = window->zoom;
-				window->zoom *= event.wheel.y > 0 ?
-					zoomFactor : 1 / zoomFactor;
-				if (window->zoom < 1e-6)
-					window->zoom = 1e-6;
+				/* a level always gives the same zoom, so its
+				 * tiles are found again
+				 */
+				oldZoom = plot->zoom;
+				zoomLevel += event.wheel.y > 0 ? 1 : -1;
+				plot->zoom = baseZoom * powl(zoomFactor,
+						zoomLevel);
+				if (plot->zoom < 1e-6) {
+					zoomLevel++;
+					plot->zoom = oldZoom;
+				}
 
 				SDL_GetMouseState(&mx, &my);
-				x = mx / oldZoom + window->translation.x;
-				y = my / oldZoom + window->translation.y;
-				window->translation.x = x - mx / window->zoom;
-				window->translation.y = y - my / window->zoom;
+				x = mx / oldZoom + plot->translation.x;
+				y = my / oldZoom + plot->translation.y;
+				/* whole pixels keep the tiles on the pixels */
+				plot->translation.x = roundl((x - mx /
+						plot->zoom) * plot->zoom) /
+					plot->zoom;
+				plot->translation.y = roundl((y - my /
+						plot->zoom) * plot->zoom) /
+					plot->zoom;
+				window->interaction = SDL_GetTicks64();
+				window->plotChanged = true;
 				break;
 			}
+			case SDL_WINDOWEVENT:
+				if (event.window.event ==
+						SDL_WINDOWEVENT_SIZE_CHANGED)
+					window_resize(window,
+							event.window.data1,
+							event.window.data2);
+				break;
 			case SDL_TEXTINPUT:
 				window_inputtext(window, event.text.text);
 				break;
 			}
 		}
-		window_render(window);
+		window_bindchanged(window);
+		window_animate(window, start);
+		window_updatescale(window);
+		window_render(window, start + WINDOW_FRAME);
 		SDL_RenderPresent(window->renderer);
 	}
 }
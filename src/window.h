@@ -1,22 +1,74 @@
 typedef struct window {
 	SDL_Window *sdl;
 	SDL_Renderer *renderer;
-	SDL_Surface *plot;
+	Plot plot;
 	const Uint8 *keys;
 	TTF_Font *font;
 	struct text {
 		struct line {
+			/* gap buffer holding data[0, gap) and
+			 * data[gap + capacity - count, capacity),
+			 * data[capacity] is always '\0'
+			 */
 			char *data;
 			size_t count;
-			/* either variable or function */
+			size_t gap;
+			size_t capacity;
+			/* either variable or function, -1 if the line
+			 * defines nothing
+			 */
+			enum math_definition definition;
 			size_t address;
+			/* rendered text, h is 0 after the line changed */
+			SDL_Texture *texture;
+			int w, h;
+			/* the roots shown after a `a = solve(...)` line */
+			SDL_Texture *result;
+			int resultW, resultH;
 		} *lines;
 		size_t count;
+		size_t capacity;
 		size_t x, y;
 	} text;
-	Vector translation;
-	number_t zoom;
+	/* contiguous copy of a line for the tokenizer and renderer */
+	char *scratch;
+	size_t scratchSize;
+	MathProgram program;
 	MathContext math;
+	/* streaming copy of the plot surface */
+	SDL_Texture *plotTexture;
+	/* a line was defined again, the program is bound before the next
+	 * frame
+	 */
+	bool programChanged;
+	/* the plot must be rendered again */
+	bool plotChanged;
+	/* the program was bound again, the roots may have changed */
+	bool resultsChanged;
+	/* ticks of the last drag or zoom, the plot is rendered at a lower
+	 * resolution until the input settles
+	 */
+	Uint64 interaction;
+	/* a variable t counts the seconds the window is shown, from the
+	 * value of its line on
+	 */
+	struct animation {
+		/* the variable t, -1 if there is none */
+		size_t address;
+		number_t start;
+		Uint64 startTicks;
+		/* the plot is rendered at a lower resolution while it takes
+		 * longer than its share of the frame
+		 */
+		int scale;
+		/* ticks when the roots were last shown */
+		Uint64 resultTicks;
+		/* frames and those that missed their time since the last
+		 * report
+		 */
+		size_t frames, dropped;
+		Uint64 reportTicks;
+	} animation;
 } Window;
 
 int window_init(Window *window);
@@ -0,0 +1,102 @@
+#include "../src/cake.h"
+
+#define COUNT 100000
+
+struct approx {
+	const char *name;
+	long double (*exact)(long double);
+	double (*approx)(double);
+	float (*approxf)(float);
+	void (*approxv)(double *restrict, const double *restrict, size_t);
+	void (*approxvf)(float *restrict, const float *restrict, size_t);
+	double lo, hi;
+	/* largest relative errors of double and float */
+	double limit, limitf;
+};
+
+static long double exact_gamma(long double x)
+{
+	return tgammal(x);
+}
+
+#define APPROX(name, exact, lo, hi, limit, limitf) { \
+	#name, exact, math_##name, math_##name##f, \
+	math_##name##v, math_##name##vf, lo, hi, limit, limitf \
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct approx approxes[] = {
+		APPROX(sin, sinl, -1000, 1000, 1e-15, 3e-7),
+		APPROX(cos, cosl, -1000, 1000, 1e-15, 3e-7),
+		/* large arguments, partly left to libm */
+		APPROX(sin, sinl, 1e5, 1e300, 1e-15, 3e-7),
+		APPROX(cos, cosl, 1e5, 1e300, 1e-15, 3e-7),
+		APPROX(exp, expl, -700, 700, 1e-15, 3e-7),
+		APPROX(log, logl, 1e-300, 1e300, 1e-15, 3e-7),
+		APPROX(sqrt, sqrtl, 1e-300, 1e300, 1e-15, 3e-7),
+		APPROX(erfc, erfcl, -5, 26, 1e-13, 3e-7),
+		APPROX(gamma, exact_gamma, -30.5, 170, 1e-12, 3e-7),
+	};
+	static double xs[COUNT], ys[COUNT];
+	static float xfs[COUNT], yfs[COUNT];
+	double error, errorf, x, e;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	for (size_t a = 0; a < ARRLEN(approxes); a++) {
+		const struct approx *const ap = &approxes[a];
+		const bool logarithmic = ap->lo > 0 && ap->hi / ap->lo > 1e6;
+
+		for (size_t i = 0; i < COUNT; i++) {
+			const double t = (double) i / (COUNT - 1);
+			x = logarithmic ? exp(log(ap->lo) +
+					t * (log(ap->hi) - log(ap->lo))) :
+				ap->lo + t * (ap->hi - ap->lo);
+			xs[i] = x;
+			/* float inputs stay in the range of float */
+			xfs[i] = logarithmic ? exp(-80 + t * 160) : x;
+		}
+		ap->approxv(ys, xs, COUNT);
+		ap->approxvf(yfs, xfs, COUNT);
+		error = 0;
+		errorf = 0;
+		for (size_t i = 0; i < COUNT; i++) {
+			e = ap->exact(xs[i]);
+			if (ys[i] != ap->approx(xs[i]))
+				error = INFINITY;
+			if (e != 0 && isfinite(e))
+				error = MAX(error, fabs((ys[i] - e) / e));
+			e = ap->exact(xfs[i]);
+			if (yfs[i] != ap->approxf(xfs[i]))
+				errorf = INFINITY;
+			/* the float result itself is rounded to 6e-8 */
+			if (fabsl(e) < FLT_MAX && fabsl(e) > FLT_MIN)
+				errorf = MAX(errorf, fabs((yfs[i] - e) / e));
+		}
+		printf("%-6s %-7g %-7g double %.3g, float %.3g\n", ap->name,
+				ap->lo, ap->hi, error, errorf);
+		if (!(error <= ap->limit) || !(errorf <= ap->limitf))
+			result = -1;
+	}
+
+	/* special values */
+	if (!isnan(math_log(-1)) || math_log(0) != -INFINITY ||
+			math_exp(-INFINITY) != 0 || math_exp(1000) != INFINITY ||
+			math_sqrt(0) != 0 || !isnan(math_sqrt(-1)) ||
+			!isnan(math_sin(NAN)) ||
+			math_logf(INFINITY) != INFINITY ||
+			math_sin(1e9) != (double) sinl(1e9) ||
+			math_cos(1e16) != (double) cosl(1e16) ||
+			!isnan(math_sin(INFINITY)) || !isnan(math_gamma(-1)) ||
+			!isnan(math_gamma(-1e300)) ||
+			!isnan(math_gamma(-INFINITY)) ||
+			!isnan(math_gammaf(-3)) || math_gamma(0) != INFINITY ||
+			math_gamma(-0.0) != -INFINITY) {
+		printf("special values are wrong\n");
+		result = -1;
+	}
+	return result;
+}
@@ -0,0 +1,75 @@
+#include "../src/cake.h"
+
+#define COUNT 20000
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+	static char buffers[COUNT][128];
+	static const char *texts[COUNT];
+	static MathResult serial[COUNT], parallel[COUNT];
+	MathProgram program;
+	MathContext ctx;
+	enum math_definition definition;
+	size_t address;
+	double start, serialTime, parallelTime;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	if (!math_define(&ctx, &program, "f(t) = sin(t) * t + sqrt(t)",
+				&definition, &address) ||
+			!math_bindprogram(&ctx, &program)) {
+		printf("defining failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	for (size_t i = 0; i < COUNT; i++) {
+		if (i % 1000 == 999)
+			strcpy(buffers[i], i % 2000 == 999 ? "1 +" : "q * 2");
+		else
+			sprintf(buffers[i], "f(%zu) + gamma(%zu / 1000 + 1) - "
+					"exp(cos(%zu))", i, i % 5000, i);
+		texts[i] = buffers[i];
+	}
+
+	start = seconds();
+	math_evaluatebatch(&program, texts, COUNT, serial, 1);
+	serialTime = seconds() - start;
+	start = seconds();
+	math_evaluatebatch(&program, texts, COUNT, parallel, 0);
+	parallelTime = seconds() - start;
+	printf("%d expressions: %.1f ms on 1 thread, %.1f ms on %u threads\n",
+			COUNT, serialTime * 1e3, parallelTime * 1e3,
+			math_threadcount());
+
+	for (size_t i = 0; i < COUNT; i++) {
+		const bool failing = i % 1000 == 999;
+		if (memcmp(&serial[i], &parallel[i], sizeof(serial[i])) != 0 ||
+				failing != (parallel[i].error != MATH_SUCCESS)) {
+			printf("result %zu differs\n", i);
+			result = -1;
+		}
+	}
+	for (size_t i = 999; i < 2000; i += 1000) {
+		math_seterror(&ctx, parallel[i].error, parallel[i].errorNumber);
+		printf("'%s' = %Lf: %s\n", texts[i], parallel[i].value,
+				math_error(&ctx));
+	}
+	if (parallel[2].value != sinl(2) * 2 + sqrtl(2) +
+			tgammal(2 / 1000.0L + 1) - expl(cosl(2)))
+		result = -1;
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,119 @@
+#include "../src/cake.h"
+
+/* computes the equations of the program as one block and compares each
+ * sample with math_computefunction()
+ */
+static int compare(MathContext *ctx, const MathProgram *program,
+		number_t tolerance)
+{
+	static const number_t xs[] = { 0, 1.5, -3.25, 7, 0.001 };
+	static const number_t ys[] = { 0, -2, 0.125, 11, 100 };
+	const number_t *const parameters[] = { xs, ys };
+	MathBlock block;
+	const number_t *values;
+	number_t expected, error;
+	int result = 0;
+
+	memset(&block, 0, sizeof(block));
+	for (size_t i = 0; i < program->numFunctions; i++)
+		if (program->functions[i].name[0] == '\0' &&
+				!math_blockfunction(ctx, &block,
+					&program->functions[i])) {
+			printf("compiling failed: %s\n", math_error(ctx));
+			return -1;
+		}
+	if (!math_computeblock(ctx, &block, parameters, ARRLEN(xs))) {
+		printf("computing failed: %s\n", math_error(ctx));
+		return -1;
+	}
+	printf("%zu operations for %zu equations\n", block.numOperations,
+			block.numResults);
+	for (size_t i = 0, n = 0; i < program->numFunctions; i++) {
+		if (program->functions[i].name[0] != '\0')
+			continue;
+		values = math_blockresult(&block, n++);
+		for (size_t s = 0; s < ARRLEN(xs); s++) {
+			math_pushlocal(ctx, xs[s]);
+			math_pushlocal(ctx, ys[s]);
+			expected = math_computefunction(ctx,
+					&program->functions[i]);
+			ctx->numLocals = 0;
+			error = fabsl(values[s] - expected) /
+				MAX(fabsl(expected), 1);
+			if (!(values[s] == expected || error <= tolerance ||
+					(isnan(values[s]) && isnan(expected)))) {
+				printf("equation %zu at (%Lg, %Lg): %Lg, "
+						"block %Lg\n", i, xs[s], ys[s],
+						expected, values[s]);
+				result = -1;
+			}
+		}
+	}
+	math_freeblock(&block);
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = 2",
+		"f(t) = t * a + sin(a * 3)",
+		"g(t, u) = f(t) / u - gamma(u)",
+		"h(t) = h(t) + 1",
+		"y = g(x, 1 + a) + exp(-x) * cos(y)",
+		"x * x + y * y = f(x) * f(y) + sqrt(y)",
+		"y = h(x)",
+		"x = y mod 3 + ln(x) - erfc(y)",
+		"x * x + y * y = 4",
+		"x * x + y * y = 9",
+	};
+	static const enum math_accuracy accuracies[] = {
+		ACCURACY_EXACT, ACCURACY_DOUBLE, ACCURACY_FAST,
+	};
+	static const number_t tolerances[] = { 0, 1e-12, 1e-5 };
+	MathProgram program;
+	MathContext ctx;
+	MathBlock block;
+	enum math_definition definition;
+	size_t address, single;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	/* h is expected to fail */
+	math_bindprogram(&ctx, &program);
+
+	for (size_t i = 0; i < ARRLEN(accuracies); i++) {
+		ctx.accuracy = accuracies[i];
+		if (compare(&ctx, &program, tolerances[i]) < 0)
+			result = -1;
+	}
+
+	/* the last two equations share all but their constant */
+	memset(&block, 0, sizeof(block));
+	math_blockfunction(&ctx, &block,
+			&program.functions[program.numFunctions - 1]);
+	single = block.numOperations;
+	math_blockfunction(&ctx, &block,
+			&program.functions[program.numFunctions - 2]);
+	printf("%zu operations alone, %zu together\n", single,
+			block.numOperations);
+	if (block.numOperations != single + 2)
+		result = -1;
+	math_freeblock(&block);
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,104 @@
+#include "../src/cake.h"
+
+/* generates the source of the lines, NULL and the function that could
+ * not be generated if generating failed
+ */
+static char *generate(MathContext *ctx, MathProgram *program,
+		const char *const *lines, size_t numLines, size_t *failed)
+{
+	enum math_definition definition;
+	size_t address, size;
+	char *source;
+	FILE *fp;
+
+	memset(program, 0, sizeof(*program));
+	ctx->program = program;
+	for (size_t i = 0; i < numLines; i++)
+		if (!math_define(ctx, program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(ctx));
+			return NULL;
+		}
+	math_bindprogram(ctx, program);
+	fp = open_memstream(&source, &size);
+	if (fp == NULL)
+		return NULL;
+	if (!math_writesource(ctx, program, fp, failed)) {
+		fclose(fp);
+		free(source);
+		return NULL;
+	}
+	fclose(fp);
+	return source;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = 2",
+		"f(t) = t * a + sin(a * 3)",
+		"y = f(x) + f(x)",
+		"y = 4",
+		"g(t) = t^2 + t^3 + t^-4 + t^0.5",
+	};
+	static const char *expected[] = {
+		"CAKE_API double cake_a(void)\n{\n\treturn 2.0;\n}\n",
+		"CAKE_API double cake_f(double p_t)\n",
+		/* the variables and constant parts are folded */
+		" = v0 * 2.0;\n",
+		" + (-0.27941549819892586);\n",
+		"CAKE_API void cake_f_batch(double *restrict result,\n"
+			"\t\tconst double *restrict p_t, size_t count)\n",
+		/* f is inlined and computed once */
+		"\tconst double v8 = v7 + v7;\n",
+		"CAKE_API double cake_equation1(double p_x, double p_y)\n{\n"
+			"\t(void) p_x;\n",
+		"\tconst double v3 = v1 - 4.0;\n\treturn v3;\n",
+		/* constant integer powers are products */
+		" = v0 * v0;\n",
+		" = v0 * v0 * v0;\n",
+		" = 1 / ((v0 * v0) * (v0 * v0));\n",
+		" = pow(v0, 0.5);\n",
+	};
+	static const char *recursive[] = {
+		"f(t) = f(t - 1) + 1",
+		"y = f(x)",
+	};
+	MathProgram program;
+	MathContext ctx;
+	char *source;
+	size_t failed;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.accuracy = ACCURACY_EXACT;
+	source = generate(&ctx, &program, lines, ARRLEN(lines), &failed);
+	if (source == NULL) {
+		printf("generating failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	for (size_t i = 0; i < ARRLEN(expected); i++)
+		if (strstr(source, expected[i]) == NULL) {
+			printf("missing '%s' in:\n%s\n", expected[i], source);
+			result = -1;
+		}
+	free(source);
+	math_freeprogram(&ctx, &program);
+
+	/* a recursion has no end in C */
+	failed = (size_t) -1;
+	source = generate(&ctx, &program, recursive, ARRLEN(recursive),
+			&failed);
+	printf("recursive: %s\n", math_error(&ctx));
+	if (source != NULL || ctx.error != MATH_RECURSIVE || failed != 0)
+		result = -1;
+	free(source);
+	math_freeprogram(&ctx, &program);
+
+	math_freecontext(&ctx);
+	return result;
+}
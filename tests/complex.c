@@ -0,0 +1,260 @@
+#include "../src/cake.h"
+#include <complex.h>
+
+typedef long double complex complex_t;
+
+/* the value of line n of main() by <complex.h> */
+static complex_t reference(size_t n, complex_t z)
+{
+	switch (n) {
+	case 0: return cexpl(z);
+	case 1: return clogl(z);
+	case 2: return csqrtl(z);
+	case 3: return csinl(z);
+	case 4: return ccosl(z);
+	case 5: return ctanl(z);
+	case 6: return 1 / ctanl(z);
+	case 7: return 1 / ccosl(z);
+	case 8: return 1 / csinl(z);
+	case 9: return csinhl(z);
+	case 10: return ccoshl(z);
+	case 11: return ctanhl(z);
+	case 12: return z * z * z - 1;
+	case 13: return 1 / (z * z);
+	case 14: return cpowl(z, 2.5L);
+	case 15: return cpowl(2, z);
+	case 16: return clogl(z) / clogl(2);
+	case 17: return clogl(z) / logl(10);
+	case 18: return cpowl(z, 1 / 3.0L);
+	case 19: return (z + 1) / (z - 2) * I;
+	default: return NAN;
+	}
+}
+
+/* the pixel at (x, y) of the surface */
+static Uint32 pixel(const Plot *plot, int x, int y)
+{
+	return ((const Uint32 *) ((const Uint8 *) plot->surface->pixels +
+				y * plot->surface->pitch))[x];
+}
+
+/* checks every line in complex blocks of the points against <complex.h>,
+ * the number of wrong values
+ */
+static int compare(MathContext *ctx, MathProgram *program,
+		const complex_t *points, size_t count, long double tolerance)
+{
+	number_t re[MATH_BLOCK], im[MATH_BLOCK];
+	const number_t *const rs[] = { re }, *const is[] = { im };
+	MathBlock block;
+	int wrong = 0;
+
+	memset(&block, 0, sizeof(block));
+	for (size_t n = 0; n < program->numFunctions; n++)
+		if (!math_blockfunction(ctx, &block,
+					&program->functions[n])) {
+			printf("compiling failed: %s\n", math_error(ctx));
+			math_freeblock(&block);
+			return 1;
+		}
+	for (size_t i = 0; i < count; i++) {
+		re[i] = creall(points[i]);
+		im[i] = cimagl(points[i]);
+	}
+	if (!math_computecomplexblock(ctx, &block, rs, is, count)) {
+		printf("computing failed: %s\n", math_error(ctx));
+		math_freeblock(&block);
+		return 1;
+	}
+	for (size_t n = 0; n < program->numFunctions; n++)
+		for (size_t i = 0; i < count; i++) {
+			const complex_t expected = reference(n, points[i]);
+			const complex_t value =
+				math_blockresult(&block, n)[i] +
+				math_blockimaginary(&block, n)[i] * I;
+
+			if (cabsl(value - expected) <=
+					tolerance * (1 + cabsl(expected)))
+				continue;
+			printf("%s at %Lg%+Lgi is %Lg%+Lgi, expected "
+					"%Lg%+Lgi\n",
+					program->functions[n].name,
+					creall(points[i]), cimagl(points[i]),
+					creall(value), cimagl(value),
+					creall(expected), cimagl(expected));
+			wrong++;
+		}
+	math_freeblock(&block);
+	return wrong;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"A(z) = exp(z)",
+		"B(z) = ln(z)",
+		"C(z) = sqrt(z)",
+		"D(z) = sin(z)",
+		"E(z) = cos(z)",
+		"F(z) = tan(z)",
+		"G(z) = cot(z)",
+		"H(z) = sec(z)",
+		"I(z) = csc(z)",
+		"J(z) = sinh(z)",
+		"K(z) = cosh(z)",
+		"L(z) = tanh(z)",
+		"M(z) = z^3 - 1",
+		"N(z) = z^-2",
+		"O(z) = z^2.5",
+		"P(z) = 2^z",
+		"Q(z) = log(2, z)",
+		"R(z) = log10(z)",
+		"S(z) = root(3, z)",
+		"T(z) = (z + 1) / (z - 2) * sqrt(-1)",
+	};
+	static const char *invalid[] = {
+		"ℂ(z)",
+		"ℂ(z, z, z)",
+	};
+	const int width = 200, height = 150;
+	complex_t points[MATH_BLOCK];
+	size_t count = 0;
+	MathProgram program;
+	MathContext ctx;
+	Plot plot, tiled;
+	enum math_definition definition;
+	size_t address;
+	Uint32 background;
+	Uint8 r, g, b;
+	int wrong, differences = 0;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	/* ℂ is no ASCII */
+	setlocale(LC_CTYPE, "C.UTF-8");
+
+	/* a grid around the origin and the negative real axis, which is
+	 * the cut of ln and the roots
+	 */
+	for (int i = -3; i <= 3; i++)
+		for (int j = -3; j <= 3; j++)
+			points[count++] = 0.7L * i + 0.45L * j * I + 0.1L;
+	points[count++] = -2;
+	points[count++] = -0.5L;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+
+	/* exact with long double libm, then with the approximations */
+	wrong = compare(&ctx, &program, points, count, 1e-15L);
+	ctx.accuracy = ACCURACY_DOUBLE;
+	wrong += compare(&ctx, &program, points, count, 1e-12L);
+	ctx.accuracy = ACCURACY_FAST;
+	wrong += compare(&ctx, &program, points, count, 1e-5L);
+	printf("%d of %zu values are wrong\n", wrong,
+			3 * count * ARRLEN(lines));
+	if (wrong > 0)
+		result = -1;
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+
+	/* the domain coloring of z^3 - 1 is drawn the same in tiles */
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	if (!math_define(&ctx, &program, "ℂ(z, z^3 - 1)", &definition,
+				&address) ||
+			!math_bindprogram(&ctx, &program)) {
+		printf("defining the plot failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (plot_init(&plot, width, height) < 0 ||
+			plot_init(&tiled, width, height) < 0)
+		return -1;
+	tile_uninit(&plot.tiles);
+	plot.zoom = 40;
+	plot.translation = (Vector) { -2.5, -1.875 };
+	tiled.zoom = plot.zoom;
+	tiled.translation = plot.translation;
+	plot_render(&plot, &ctx);
+	plot_render(&tiled, &ctx);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			differences += pixel(&plot, x, y) !=
+				pixel(&tiled, x, y);
+	printf("%d of %d pixels differ from the tiles\n", differences,
+			width * height);
+	if (differences > 0)
+		result = -1;
+
+	/* at z = 2 the value is positive and red, at z = 0 negative and
+	 * cyan
+	 */
+	SDL_GetRGB(pixel(&plot, 180, 75), plot.surface->format, &r, &g, &b);
+	if (r <= g || r <= b) {
+		printf("7 has the color %d %d %d\n", r, g, b);
+		result = -1;
+	}
+	SDL_GetRGB(pixel(&plot, 100, 75), plot.surface->format, &r, &g, &b);
+	if (r >= g || r >= b) {
+		printf("-1 has the color %d %d %d\n", r, g, b);
+		result = -1;
+	}
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+
+	/* a function that is not complex is NaN off the real axis and
+	 * keeps the background
+	 */
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	if (!math_define(&ctx, &program, "ℂ(z, floor(z))", &definition,
+				&address) ||
+			!math_bindprogram(&ctx, &program)) {
+		printf("defining the plot failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	plot_render(&plot, &ctx);
+	background = SDL_MapRGB(plot.surface->format, 14, 10, 25);
+	if (pixel(&plot, 10, 10) != background ||
+			pixel(&plot, 180, 75) == background) {
+		printf("floor is colored off the real axis\n");
+		result = -1;
+	}
+	plot_uninit(&tiled);
+	plot_uninit(&plot);
+
+	/* ℂ binds a name for one body and is no number */
+	for (size_t i = 0; i < ARRLEN(invalid); i++)
+		if (math_define(&ctx, &program, invalid[i], &definition,
+					&address) ||
+				ctx.error != MATH_INVALID_CALL) {
+			printf("'%s' was accepted\n", invalid[i]);
+			result = -1;
+		}
+	if (!math_define(&ctx, &program, "a = ℂ(z, z)", &definition,
+				&address) ||
+			!math_bindprogram(&ctx, &program) ||
+			!isnan(program.variables[address].value)) {
+		printf("ℂ is a number: %s\n", math_error(&ctx));
+		result = -1;
+	}
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,180 @@
+#include "../src/cake.h"
+
+/* plots the line alone, NULL if it could not be defined */
+static Uint32 *render(Plot *plot, const char *line)
+{
+	MathProgram program;
+	MathContext ctx;
+	enum math_definition definition;
+	size_t address;
+	Uint32 *pixels = NULL;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	if (!math_define(&ctx, &program, line, &definition, &address) ||
+			!math_bindprogram(&ctx, &program)) {
+		printf("defining '%s' failed: %s\n", line, math_error(&ctx));
+		goto end;
+	}
+	plot_render(plot, &ctx);
+	pixels = malloc(sizeof(*pixels) * plot->surface->w * plot->surface->h);
+	if (pixels == NULL)
+		goto end;
+	for (int j = 0; j < plot->surface->h; j++)
+		memcpy(&pixels[j * plot->surface->w],
+				(Uint8 *) plot->surface->pixels +
+				j * plot->surface->pitch,
+				sizeof(*pixels) * plot->surface->w);
+
+end:
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return pixels;
+}
+
+/* the pixels of the curve in a that are no pixel away from one in b */
+static int distant(const Uint32 *a, const Uint32 *b, int width, int height,
+		Uint32 curve, int *count)
+{
+	int numDistant = 0;
+	bool near;
+
+	*count = 0;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			if (a[x + y * width] != curve)
+				continue;
+			(*count)++;
+			near = false;
+			for (int v = MAX(y - 1, 0); v <= MIN(y + 1, height - 1);
+					v++)
+				for (int u = MAX(x - 1, 0);
+						u <= MIN(x + 1, width - 1); u++)
+					near |= b[u + v * width] == curve;
+			numDistant += !near;
+		}
+	return numDistant;
+}
+
+/* the number of pixels that differ between a and b */
+static int differ(const Uint32 *a, const Uint32 *b, int width, int height)
+{
+	int differences = 0;
+
+	for (int i = 0; i < width * height; i++)
+		differences += a[i] != b[i];
+	return differences;
+}
+
+int main(int argc, char *argv[])
+{
+	/* curves drawn along their parameter or axis and the same zero
+	 * sets written so that they are sampled on the grid by marching
+	 * squares
+	 */
+	static const struct {
+		const char *drawn, *sampled;
+	} curves[] = {
+		{
+			"curve(s, 0, 6.283185307179586, 4 * cos(s), "
+				"4 * sin(s))",
+			"x * x + y * y = 16"
+		},
+		{ "y = sin(x)", "y - sin(x) = 0" },
+		{ "x = 2 * sin(3 * y)", "x - 2 * sin(3 * y) = 0" },
+	};
+	static const char *invalid[] = {
+		"curve(s, 0, 1, s)",
+		"curve(s, 0, 1, s, s, s)",
+	};
+	const int width = 400, height = 300;
+	MathProgram program;
+	MathContext ctx;
+	Plot plot, tiled;
+	enum math_definition definition;
+	size_t address;
+	Uint32 *drawn, *sampled, *tiles, green;
+	int count, otherCount, far, missed, differences;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	if (plot_init(&plot, width, height) < 0 ||
+			plot_init(&tiled, width, height) < 0)
+		return -1;
+	tile_uninit(&plot.tiles);
+	green = SDL_MapRGB(plot.surface->format, 0, 255, 0);
+
+	for (size_t i = 0; i < ARRLEN(curves); i++) {
+		/* the drawn curve is the sampled one within a pixel */
+		plot.zoom = 31.3;
+		plot.translation = (Vector) { -6.17, -4.58 };
+		drawn = render(&plot, curves[i].drawn);
+		sampled = render(&plot, curves[i].sampled);
+		if (drawn == NULL || sampled == NULL) {
+			result = -1;
+		} else {
+			far = distant(drawn, sampled, width, height, green,
+					&count);
+			missed = distant(sampled, drawn, width, height, green,
+					&otherCount);
+			printf("'%s': %d drawn and %d sampled pixels, "
+					"%d far, %d missed\n", curves[i].drawn,
+					count, otherCount, far, missed);
+			if (count == 0 || far > 0 || missed > 0)
+				result = -1;
+		}
+		free(drawn);
+		free(sampled);
+
+		/* the curve is drawn the same in tiles, each of which
+		 * samples it in its own offset image; they start at whole
+		 * pixels of the view
+		 */
+		plot.zoom = 32;
+		plot.translation = (Vector) { -6.25, -4.6875 };
+		tiled.zoom = plot.zoom;
+		tiled.translation = plot.translation;
+		drawn = render(&plot, curves[i].drawn);
+		tiles = render(&tiled, curves[i].drawn);
+		if (drawn == NULL || tiles == NULL) {
+			result = -1;
+		} else {
+			differences = differ(drawn, tiles, width, height);
+			printf("'%s': %d of %d pixels differ from %zu "
+					"tiles\n", curves[i].drawn,
+					differences, width * height,
+					tiled.tiles.numTiles);
+			if (differences > 0 || tiled.tiles.numTiles == 0)
+				result = -1;
+		}
+		free(drawn);
+		free(tiles);
+	}
+	plot_uninit(&tiled);
+	plot_uninit(&plot);
+
+	/* a curve has two bodies and is no number */
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(invalid); i++)
+		if (math_define(&ctx, &program, invalid[i], &definition,
+					&address) ||
+				ctx.error != MATH_INVALID_CALL) {
+			printf("'%s' was accepted\n", invalid[i]);
+			result = -1;
+		}
+	if (!math_define(&ctx, &program, "a = curve(s, 0, 1, s, s)",
+				&definition, &address) ||
+			!math_bindprogram(&ctx, &program) ||
+			!isnan(program.variables[address].value)) {
+		printf("the curve is a number: %s\n", math_error(&ctx));
+		result = -1;
+	}
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
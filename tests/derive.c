@@ -0,0 +1,160 @@
+#include "../src/cake.h"
+
+static char parameters[][256] = { "x", "y" };
+
+/* the text as a function of x and y */
+static bool parse(MathContext *ctx, const char *text, MathFunction *func)
+{
+	MathTokenizer tokenizer;
+
+	memset(&tokenizer, 0, sizeof(tokenizer));
+	memset(func, 0, sizeof(*func));
+	if (!math_tokenize(ctx, &tokenizer, text)) {
+		printf("tokenizing failed: %s\n", math_error(ctx));
+		return false;
+	}
+	func->group = math_parsegroup(ctx, &tokenizer);
+	math_freetokenizer(ctx, &tokenizer);
+	if (func->group == NULL) {
+		printf("parsing failed: %s\n", math_error(ctx));
+		return false;
+	}
+	func->parameters = parameters;
+	func->numParameters = ARRLEN(parameters);
+	if (!math_bindfunction(ctx, func)) {
+		printf("binding failed: %s\n", math_error(ctx));
+		return false;
+	}
+	return true;
+}
+
+/* the dual and symbolic derivative of the function by each parameter at
+ * the top locals agree, and are finite
+ */
+static int compare(MathContext *ctx, const MathFunction *func,
+		const char *text)
+{
+	MathFunction derived;
+	MathDual dual;
+	number_t symbolic;
+	int wrong = 0;
+
+	for (size_t p = 0; p < func->numParameters; p++) {
+		derived = *func;
+		derived.group = math_derivegroup(ctx, func->group, p);
+		if (derived.group == NULL) {
+			printf("deriving failed: %s\n", math_error(ctx));
+			return 1;
+		}
+		dual = math_computedual(ctx, func, p);
+		symbolic = math_computefunction(ctx, &derived);
+		printf("d/d%s %s = %Lf (symbolic %Lf)\n",
+				func->parameters[p], text, dual.derivative,
+				symbolic);
+		if (!isfinite(dual.derivative) ||
+				!(fabsl(dual.derivative - symbolic) <= 1e-9))
+			wrong++;
+		math_freegroup(ctx, derived.group);
+	}
+	return wrong;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *texts[] = {
+		"x * x * y - 3 / x",
+		"sin(x) * cos(y)",
+		"exp(x / y) - ln(x)",
+		"pow(x, y) + root(3, x)",
+		"log(y, x) * tanh(x)",
+		"sqrt(x * x + y * y)",
+		"gamma(x) + erfc(y)",
+		"y = atanh(x / 2) * cbrt(x)",
+	};
+	/* nested calls of user functions of several parameters */
+	static const char *lines[] = {
+		"g(a, b) = a * sin(b) + b / a",
+		"h(t, u) = g(t, t * u) * g(u, 1) + root(3, t - 2)",
+		"f(x, y) = h(g(x, y), x) - h(y, x * y)",
+	};
+	MathProgram program;
+	enum math_definition definition;
+	size_t address;
+	MathContext ctx;
+	MathFunction func, derived;
+	MathDual dual;
+	number_t symbolic, numeric, h;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&ctx, 0, sizeof(ctx));
+	math_pushlocal(&ctx, 0.7);
+	math_pushlocal(&ctx, 1.3);
+	for (size_t i = 0; i < ARRLEN(texts); i++) {
+		if (!parse(&ctx, texts[i], &func))
+			return -1;
+		for (size_t p = 0; p < func.numParameters; p++) {
+			derived = func;
+			derived.group = math_derivegroup(&ctx, func.group, p);
+			if (derived.group == NULL) {
+				printf("deriving failed: %s\n",
+						math_error(&ctx));
+				return -1;
+			}
+			dual = math_computedual(&ctx, &func, p);
+			symbolic = math_computefunction(&ctx, &derived);
+
+			h = 1e-6;
+			ctx.locals[p] += h;
+			numeric = math_computefunction(&ctx, &func);
+			ctx.locals[p] -= 2 * h;
+			numeric -= math_computefunction(&ctx, &func);
+			ctx.locals[p] += h;
+			numeric /= 2 * h;
+
+			printf("d/d%s %s = %Lf (symbolic %Lf, numeric %Lf)\n",
+					parameters[p], texts[i],
+					dual.derivative, symbolic, numeric);
+			if (fabsl(dual.derivative - symbolic) > 1e-9 ||
+					fabsl(dual.derivative - numeric) > 1e-5)
+				result = -1;
+			math_freegroup(&ctx, derived.group);
+		}
+		math_freegroup(&ctx, func.group);
+	}
+
+	/* an odd root of a negative number has derivatives, the root is
+	 * only real for odd integers so there is no numeric one
+	 */
+	ctx.locals[0] = -1.3;
+	ctx.locals[1] = 3;
+	if (!parse(&ctx, "root(y, x) * y", &func))
+		return -1;
+	if (compare(&ctx, &func, "root(y, x) * y") > 0)
+		result = -1;
+	math_freegroup(&ctx, func.group);
+
+	/* a call is computed once for all of its parameters */
+	memset(&program, 0, sizeof(program));
+	ctx.program = &program;
+	ctx.locals[0] = 0.7;
+	ctx.locals[1] = 1.3;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (compare(&ctx, &program.functions[2], lines[2]) > 0)
+		result = -1;
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,120 @@
+#include "../src/cake.h"
+
+/* writes into memory, NULL if writing failed */
+static char *export(Plot *plot, MathContext *ctx, int width, int height,
+		bool tiled, size_t *size)
+{
+	char *data;
+	FILE *fp;
+	int result;
+
+	fp = open_memstream(&data, size);
+	if (fp == NULL)
+		return NULL;
+	if (tiled) {
+		result = plot_export(plot, ctx, width, height, fp);
+	} else {
+		plot_render(plot, ctx);
+		result = plot_writeppm(plot, fp);
+	}
+	fclose(fp);
+	if (result < 0) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"y = tan(x)",
+		"x = sin(y) * 3",
+		"x * x + y * y = 16",
+		"sin(x * y) = 0.3",
+	};
+	/* wider and higher than a tile without being a multiple of it */
+	const int width = PLOT_EXPORT_TILE * 2 + 37;
+	const int height = PLOT_EXPORT_TILE + 91;
+	MathProgram program;
+	MathContext ctx;
+	Plot plot, half;
+	enum math_definition definition;
+	size_t address, fullSize, tiledSize;
+	char *full, *tiled;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (plot_init(&plot, width, height) < 0)
+		return -1;
+	/* drawn directly like the tiles of plot_export() */
+	tile_uninit(&plot.tiles);
+	plot.zoom = 23.7;
+	plot.translation = (Vector) { -9.13, -7.71 };
+
+	/* the tiles are one plot of the image */
+	full = export(&plot, &ctx, width, height, false, &fullSize);
+	tiled = export(&plot, &ctx, width, height, true, &tiledSize);
+	if (full == NULL || tiled == NULL || fullSize != tiledSize) {
+		printf("exporting failed\n");
+		result = -1;
+	} else {
+		size_t differences = 0;
+
+		for (size_t i = 0; i < fullSize; i++)
+			differences += full[i] != tiled[i];
+		printf("%zu of %zu bytes differ\n", differences, fullSize);
+		if (differences > 0)
+			result = -1;
+	}
+	free(full);
+	free(tiled);
+
+	/* a scaled plot renders a plot of the smaller size into its
+	 * top left part
+	 */
+	if (plot_init(&half, width / 2, height / 2) < 0)
+		return -1;
+	tile_uninit(&half.tiles);
+	half.zoom = plot.zoom / 2;
+	half.translation = plot.translation;
+	plot.scale = 2;
+	plot_render(&plot, &ctx);
+	plot_render(&half, &ctx);
+	for (int j = 0; j < half.surface->h; j++)
+		if (memcmp((Uint8 *) plot.surface->pixels +
+					j * plot.surface->pitch,
+					(Uint8 *) half.surface->pixels +
+					j * half.surface->pitch,
+					half.surface->w * sizeof(Uint32)) != 0) {
+			printf("row %d of the scaled plot differs\n", j);
+			result = -1;
+			break;
+		}
+	if (plot.zoom != 23.7 || plot.surface->w != width) {
+		printf("the scaled plot was not restored\n");
+		result = -1;
+	}
+	plot_uninit(&half);
+
+	plot_uninit(&plot);
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
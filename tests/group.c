@@ -31,51 +31,80 @@ static void print_group(MathContext *ctx, MathGroup *group)
 
 static void print_token(MathToken *token)
 {
-	static char *tokenNames[] = {
-		"null",
-
-		"plus", "minus",
-		"divide", "multiply",
-		
-		"and", "or", "xor",
-		"mod",
-
-		"floor", "ceil",
-		"exp", "pow", "erfc",
-		"sqrt", "cbrt", "root",
-		"log10", "log", "ln",
-		"sin", "cos",
-		"tan", "cot",
-		"sec", "csc",
-		"sinh", "cosh", "tanh",
-		"asinh", "acosh", "atanh",
-		"gamma",
-
-		"percent",
-		"bang",
-		"degrees",
-
-		"element_of",
-		"intersection",
-		"union",
-		"real_numbers",
-		"complex_numbers",
-		"integers",
-		"natural_numbers",
-		"maps_to",
-		"subset_of",
-		"implies",
-
-		"open_corner", "closed_corner",
-		"open_curly", "closed_curly",
-		"open_round", "closed_round",
-		"raise", "lower",
-
-		"keyword",
-		"number",
-		"variable",
+	/* by enum math_token_type, a token without a name is printed by
+	 * its number
+	 */
+	static const char *const tokenNames[] = {
+		[TOKEN_NULL] = "null",
+		[TOKEN_PLUS] = "plus",
+		[TOKEN_MINUS] = "minus",
+		[TOKEN_DIVIDE] = "divide",
+		[TOKEN_MULTIPLY] = "multiply",
+		[TOKEN_AND] = "and",
+		[TOKEN_OR] = "or",
+		[TOKEN_XOR] = "xor",
+		[TOKEN_MOD] = "mod",
+		[TOKEN_EQUALS] = "equals",
+		[TOKEN_FLOOR] = "floor",
+		[TOKEN_CEIL] = "ceil",
+		[TOKEN_EXP] = "exp",
+		[TOKEN_POW] = "pow",
+		[TOKEN_ERFC] = "erfc",
+		[TOKEN_SQRT] = "sqrt",
+		[TOKEN_CBRT] = "cbrt",
+		[TOKEN_ROOT] = "root",
+		[TOKEN_LOG10] = "log10",
+		[TOKEN_LOG] = "log",
+		[TOKEN_LN] = "ln",
+		[TOKEN_SIN] = "sin",
+		[TOKEN_COS] = "cos",
+		[TOKEN_TAN] = "tan",
+		[TOKEN_COT] = "cot",
+		[TOKEN_SEC] = "sec",
+		[TOKEN_CSC] = "csc",
+		[TOKEN_SINH] = "sinh",
+		[TOKEN_COSH] = "cosh",
+		[TOKEN_TANH] = "tanh",
+		[TOKEN_ASINH] = "asinh",
+		[TOKEN_ACOSH] = "acosh",
+		[TOKEN_ATANH] = "atanh",
+		[TOKEN_GAMMA] = "gamma",
+		[TOKEN_SUM] = "sum",
+		[TOKEN_PROD] = "prod",
+		[TOKEN_INTEGRAL] = "integral",
+		[TOKEN_SOLVE] = "solve",
+		[TOKEN_CURVE] = "curve",
+		[TOKEN_COMPLEX_NUMBERS] = "complex_numbers",
+		[TOKEN_PERCENT] = "percent",
+		[TOKEN_BANG] = "bang",
+		[TOKEN_DEGREES] = "degrees",
+		[TOKEN_ELEMENT_OF] = "element_of",
+		[TOKEN_INTERSECTION] = "intersection",
+		[TOKEN_UNION] = "union",
+		[TOKEN_REAL_NUMBERS] = "real_numbers",
+		[TOKEN_INTEGERS] = "integers",
+		[TOKEN_NATURAL_NUMBERS] = "natural_numbers",
+		[TOKEN_MAPS_TO] = "maps_to",
+		[TOKEN_SUBSET_OF] = "subset_of",
+		[TOKEN_IMPLIES] = "implies",
+		[TOKEN_OPEN_CORNER] = "open_corner",
+		[TOKEN_CLOSED_CORNER] = "closed_corner",
+		[TOKEN_OPEN_CURLY] = "open_curly",
+		[TOKEN_CLOSED_CURLY] = "closed_curly",
+		[TOKEN_OPEN_ROUND] = "open_round",
+		[TOKEN_CLOSED_ROUND] = "closed_round",
+		[TOKEN_RAISE] = "raise",
+		[TOKEN_LOWER] = "lower",
+		[TOKEN_COMMA] = "comma",
+		[TOKEN_RANGE] = "range",
+		[TOKEN_NUMBER] = "number",
+		[TOKEN_VARIABLE] = "variable",
 	};
-	printf("%s", tokenNames[token->type]);
+	if (token->type < ARRLEN(tokenNames) &&
+			tokenNames[token->type] != NULL)
+		printf("%s", tokenNames[token->type]);
+	else
+		printf("token%d", (int) token->type);
 }
 
 int main(int argc, char *argv[])
@@ -0,0 +1,142 @@
+#include "../src/cake.h"
+
+/* the pixel at (x, y) of the surface */
+static Uint32 pixel(const Plot *plot, int x, int y)
+{
+	return ((const Uint32 *) ((const Uint8 *) plot->surface->pixels +
+				y * plot->surface->pitch))[x];
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"sqrt(x) * 3 - y = 1",
+		"y = x / 2",
+	};
+	const int width = 300, height = 200;
+	const PlotHeat heat = { -8, 8, 4 };
+	MathProgram program;
+	MathContext ctx;
+	Plot plot, tiled;
+	enum math_definition definition;
+	size_t address;
+	Uint32 background;
+	Uint8 r, g[2], b;
+	int differences = 0;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (plot_init(&plot, width, height) < 0 ||
+			plot_init(&tiled, width, height) < 0)
+		return -1;
+	tile_uninit(&plot.tiles);
+	/* the tiles start on pixels of the plot */
+	plot.zoom = 16;
+	plot.translation = (Vector) { -4, -7 };
+	tiled.zoom = plot.zoom;
+	tiled.translation = plot.translation;
+	plot_setheat(&plot, heat);
+	plot_setheat(&tiled, heat);
+	plot_render(&plot, &ctx);
+	plot_render(&tiled, &ctx);
+
+	/* the tiles of the heat map are the plot */
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			differences += pixel(&plot, x, y) !=
+				pixel(&tiled, x, y);
+	printf("%d of %d pixels differ from the tiles\n", differences,
+			width * height);
+	if (differences > 0)
+		result = -1;
+
+	/* left of the y axis the values are NaN and the plot is not
+	 * colored, right of it each value has the color of its range
+	 */
+	background = SDL_MapRGB(plot.surface->format, 14, 10, 25);
+	if (pixel(&plot, 10, 10) != background) {
+		printf("NaN is colored\n");
+		result = -1;
+	}
+	for (int x = 70; x < width; x += 23) {
+		const number_t px = x / plot.zoom + plot.translation.x;
+		const number_t py = -(150 / plot.zoom + plot.translation.y);
+		const number_t value = sqrtl(px) * 3 - py - 1;
+		const int k = (value - heat.lo) / (heat.hi - heat.lo) *
+			PLOT_HEAT_COLORS;
+		const Uint32 expected = plot.heatColors[MIN(MAX(k, 0),
+				PLOT_HEAT_COLORS - 1)];
+
+		if (pixel(&plot, x, 150) != expected) {
+			printf("%Lg at (%Lg, %Lg) has color %x, expected %x\n",
+					value, px, py, pixel(&plot, x, 150),
+					expected);
+			result = -1;
+		}
+	}
+
+	/* the second equation is chosen, its tiles are computed again */
+	plot.heatEquation = 1;
+	tiled.heatEquation = 1;
+	plot_invalidate(&tiled, &ctx);
+	plot_render(&plot, &ctx);
+	plot_render(&tiled, &ctx);
+	differences = 0;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			differences += pixel(&plot, x, y) !=
+				pixel(&tiled, x, y);
+	if (differences > 0) {
+		printf("%d pixels of the second heat map differ from the "
+				"tiles\n", differences);
+		result = -1;
+	}
+	for (int x = 10; x < width; x += 23) {
+		const number_t px = x / plot.zoom + plot.translation.x;
+		const number_t py = -(50 / plot.zoom + plot.translation.y);
+		const number_t value = py - px / 2;
+		const int k = (value - heat.lo) / (heat.hi - heat.lo) *
+			PLOT_HEAT_COLORS;
+		const Uint32 expected = plot.heatColors[MIN(MAX(k, 0),
+				PLOT_HEAT_COLORS - 1)];
+
+		if (pixel(&plot, x, 50) != expected) {
+			printf("%Lg at (%Lg, %Lg) has color %x, expected %x\n",
+					value, px, py, pixel(&plot, x, 50),
+					expected);
+			result = -1;
+		}
+	}
+
+	/* every other band is darker, the ramp gets greener */
+	SDL_GetRGB(plot.heatColors[PLOT_HEAT_COLORS / 4 - 1],
+			plot.surface->format, &r, &g[0], &b);
+	SDL_GetRGB(plot.heatColors[PLOT_HEAT_COLORS / 4 + 1],
+			plot.surface->format, &r, &g[1], &b);
+	if (g[1] >= g[0]) {
+		printf("the second band is not darker\n");
+		result = -1;
+	}
+
+	plot_uninit(&tiled);
+	plot_uninit(&plot);
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,211 @@
+#include "../src/cake.h"
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = 2",
+		"f(t) = t * a + sin(a * 3)",
+		"g(t, u) = f(t) / u - gamma(u)",
+		"y = g(x, 1 + a) + exp(-x) * q",
+		"y = f(x) * f(y) - 2 ^ 3",
+		"h(t) = sum(k, 1, 4, t * k) * integral(u, 0, t, u * a)",
+	};
+	static const number_t points[][2] = {
+		{ 0, 0 }, { 1.5, -2 }, { -3.25, 0.125 }, { 7, 11 },
+	};
+	static const MathAxis axes[] = { { -1, 2, 4 }, { 1, 3, 3 } };
+	char path[] = "/tmp/cake-imageXXXXXX";
+	MathProgram program, loaded;
+	MathContext ctx;
+	MathImage image;
+	enum math_definition definition;
+	const MathFunction *swept;
+	size_t address, f, sizes[2] = { 0, 0 };
+	char *data[2] = { NULL, NULL };
+	number_t expected, value;
+	uint32_t n, a;
+	off_t offset;
+	FILE *fp;
+	int fd;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	/* the undefined name is expected to fail */
+	math_bindprogram(&ctx, &program);
+	ctx.error = MATH_SUCCESS;
+
+	fd = mkstemp(path);
+	if (fd < 0 || (fp = fdopen(fd, "wb")) == NULL) {
+		printf("'%s' could not be opened\n", path);
+		return -1;
+	}
+	if (!math_writeimage(&ctx, &program, fp) || fclose(fp) != 0) {
+		printf("writing failed: %s\n", math_error(&ctx));
+		unlink(path);
+		return -1;
+	}
+	if (!math_mapimage(&ctx, &image, path)) {
+		printf("mapping failed: %s\n", math_error(&ctx));
+		unlink(path);
+		return -1;
+	}
+	printf("%u nodes, %u constants, %zu bytes\n", image.header->numNodes,
+			image.header->numConstants, image.size);
+
+	for (size_t i = 0; i < program.numFunctions; i++)
+		for (size_t p = 0; p < ARRLEN(points); p++) {
+			for (size_t a = 0; a < program.functions[i].numParameters;
+					a++)
+				math_pushlocal(&ctx, points[p][a]);
+			expected = math_computefunction(&ctx,
+					&program.functions[i]);
+			value = math_computeimage(&ctx, &image, i);
+			ctx.numLocals = 0;
+			printf("function %zu at (%Lg, %Lg): %Lg, image %Lg\n",
+					i, points[p][0], points[p][1], expected,
+					value);
+			if (!(value == expected ||
+						(isnan(value) && isnan(expected))))
+				result = -1;
+		}
+
+	f = math_imagefunction(&image, "g");
+	if (f != 1 || math_imagevariable(&image, "a") != 0 ||
+			math_imagevariable(&image, "f") != (size_t) -1) {
+		printf("symbols were not found\n");
+		result = -1;
+	}
+	/* g depends on f only, f on a */
+	if (f != (size_t) -1 && (image.functions[f].numDependencies != 1 ||
+			image.dependencies[image.functions[f].dependencies] !=
+			image.header->numVariables)) {
+		printf("the dependencies of g are wrong\n");
+		result = -1;
+	}
+
+	/* the image is swept as it is mapped like the bound program */
+	if (f != (size_t) -1) {
+		swept = &program.functions[f];
+		fp = open_memstream(&data[0], &sizes[0]);
+		if (fp != NULL) {
+			if (!math_sweep(&ctx, &swept, 1, axes, ARRLEN(axes),
+						SWEEP_CSV, fp, 2))
+				result = -1;
+			fclose(fp);
+		}
+		fp = open_memstream(&data[1], &sizes[1]);
+		if (fp != NULL) {
+			if (!math_sweepimage(&ctx, &image, &f, 1, axes,
+						ARRLEN(axes), SWEEP_CSV, fp, 2))
+				result = -1;
+			fclose(fp);
+		}
+		if (sizes[0] != sizes[1] ||
+				memcmp(data[0], data[1], sizes[0]) != 0) {
+			printf("the image sweeps\n%.*s\ninstead of\n%.*s\n",
+					(int) sizes[1], data[1],
+					(int) sizes[0], data[0]);
+			result = -1;
+		}
+		free(data[0]);
+		free(data[1]);
+	}
+
+	/* a loaded program computes like the parsed one */
+	memset(&loaded, 0, sizeof(loaded));
+	if (!math_loadimage(&ctx, &loaded, &image)) {
+		printf("loading failed: %s\n", math_error(&ctx));
+		result = -1;
+	}
+	math_bindprogram(&ctx, &loaded);
+	ctx.error = MATH_SUCCESS;
+	if (loaded.numFunctions != program.numFunctions ||
+			loaded.numVariables != program.numVariables) {
+		printf("%zu functions and %zu variables were loaded\n",
+				loaded.numFunctions, loaded.numVariables);
+		result = -1;
+	}
+	for (size_t i = 0; i < MIN(loaded.numFunctions, program.numFunctions);
+			i++)
+		for (size_t p = 0; p < ARRLEN(points); p++) {
+			const size_t n = program.functions[i].numParameters;
+
+			for (size_t a = 0; a < n; a++)
+				math_pushlocal(&ctx, points[p][a]);
+			ctx.program = &program;
+			expected = math_computefunction(&ctx,
+					&program.functions[i]);
+			ctx.program = &loaded;
+			value = math_computefunction(&ctx,
+					&loaded.functions[i]);
+			ctx.numLocals = 0;
+			if (value == expected ||
+					(isnan(value) && isnan(expected)))
+				continue;
+			printf("loaded function %zu at (%Lg, %Lg): %Lg, "
+					"expected %Lg\n", i, points[p][0],
+					points[p][1], value, expected);
+			result = -1;
+		}
+	ctx.program = &program;
+	math_freeprogram(&ctx, &loaded);
+
+	/* a node that is its own operand is refused */
+	for (n = 0; n < image.header->numNodes; n++)
+		if (image.nodes[n].type == GROUP_NEGATE)
+			break;
+	offset = image.header->nodes + n * sizeof(MathNode) +
+		offsetof(MathNode, a);
+	math_unmapimage(&image);
+	fd = open(path, O_RDWR);
+	if (fd < 0 || pread(fd, &a, sizeof(a), offset) != sizeof(a) ||
+			pwrite(fd, &n, sizeof(n), offset) != sizeof(n)) {
+		printf("'%s' could not be changed\n", path);
+		result = -1;
+	}
+	if (math_mapimage(&ctx, &image, path)) {
+		printf("the cycle was accepted\n");
+		math_unmapimage(&image);
+		result = -1;
+	} else {
+		printf("cycle: %s\n", math_error(&ctx));
+	}
+	if (fd >= 0) {
+		if (pwrite(fd, &a, sizeof(a), offset) != sizeof(a))
+			result = -1;
+		close(fd);
+	}
+
+	/* a damaged file is refused */
+	fd = open(path, O_WRONLY);
+	if (fd < 0 || write(fd, "CAKF", 4) != 4) {
+		printf("'%s' could not be changed\n", path);
+		result = -1;
+	}
+	if (fd >= 0)
+		close(fd);
+	if (math_mapimage(&ctx, &image, path)) {
+		printf("the damaged image was accepted\n");
+		math_unmapimage(&image);
+		result = -1;
+	} else {
+		printf("damaged image: %s\n", math_error(&ctx));
+	}
+
+	unlink(path);
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,147 @@
+#include "../src/cake.h"
+
+static const MathList *find(const MathProgram *program, const char *name)
+{
+	for (size_t i = 0; i < program->numVariables; i++)
+		if (strcmp(program->variables[i].name, name) == 0)
+			return program->variables[i].list;
+	return NULL;
+}
+
+/* compares the elements with the expected ones */
+static int expect(const MathProgram *program, const char *name,
+		const number_t *values, size_t count)
+{
+	const MathList *const list = find(program, name);
+	number_t value;
+
+	if (list == NULL || list->count != count) {
+		printf("%s: expected %zu elements\n", name, count);
+		return -1;
+	}
+	for (size_t i = 0; i < count; i++) {
+		value = math_listelement(list, i);
+		if (fabsl(value - values[i]) > 1e-12 * MAX(fabsl(values[i]),
+					1)) {
+			printf("%s[%zu] = %Lg, expected %Lg\n", name, i, value,
+					values[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = [1..1000000]",
+		"b = [3, 4, 5]",
+		"c = [4, 3, 12]",
+		"d = sqrt(b^2 + c^2)",
+		"e = a * 2 + 1",
+		"f(t) = t * t - n",
+		"n = 1",
+		"g = f(a)",
+		"k = [1, 2..4, 10, 2 * 3]",
+		"m = a",
+		"y = b",
+		"h = a + b",
+	};
+	static const struct {
+		const char *text;
+		enum math_error error;
+	} invalid[] = {
+		{ "1..2", MATH_INVALID_RANGE },
+		{ "[1..2..3]", MATH_INVALID_RANGE },
+		{ "[1..2 + 1]", MATH_SUCCESS },
+		{ "[(1..2)]", MATH_INVALID_RANGE },
+		{ "sin(1..2)", MATH_INVALID_RANGE },
+		{ "[1, 2)", MATH_UNBALANCED },
+		{ "(1, 2]", MATH_INVALID_CALL },
+		{ "[1, 2", MATH_UNBALANCED },
+		{ "[1.5..3]", MATH_SUCCESS },
+	};
+	static const number_t ds[] = { 5, 5, 13 };
+	static const number_t ks[] = { 1, 2, 3, 4, 10, 6 };
+	MathProgram program;
+	MathContext ctx;
+	MathGroup *group;
+	enum math_definition definition;
+	size_t address;
+	const MathList *list;
+	number_t value;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	for (size_t i = 0; i < ARRLEN(invalid); i++) {
+		memset(&ctx, 0, sizeof(ctx));
+		group = math_parse(&ctx, invalid[i].text);
+		printf("'%s': %s\n", invalid[i].text, math_error(&ctx));
+		if (ctx.error != invalid[i].error ||
+				(group == NULL) != (ctx.error != MATH_SUCCESS))
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	/* the lengths of h do not match */
+	if (math_bindprogram(&ctx, &program) ||
+			ctx.error != MATH_LIST_LENGTH || find(&program, "h")) {
+		printf("binding: %s\n", math_error(&ctx));
+		result = -1;
+	}
+
+	if (expect(&program, "d", ds, ARRLEN(ds)) < 0 ||
+			expect(&program, "k", ks, ARRLEN(ks)) < 0)
+		result = -1;
+
+	/* ranges are generated, not stored */
+	list = find(&program, "a");
+	if (list == NULL || list->values != NULL || list->count != 1000000 ||
+			find(&program, "m")->values != NULL)
+		result = -1;
+	list = find(&program, "e");
+	if (list == NULL || list->values == NULL ||
+			math_listelement(list, 999999) != 2000001)
+		result = -1;
+	list = find(&program, "g");
+	if (list == NULL || list->count != 1000000 ||
+			math_listelement(list, 0) != 0 ||
+			math_listelement(list, 9) != 99)
+		result = -1;
+
+	/* equations see lists as NaN */
+	math_pushlocal(&ctx, 1);
+	math_pushlocal(&ctx, 2);
+	value = math_computefunction(&ctx, &program.functions[1]);
+	ctx.numLocals = 0;
+	printf("y = b at (1, 2): %Lg\n", value);
+	if (!isnan(value))
+		result = -1;
+
+	/* redefining recomputes */
+	math_undefine(&ctx, &program, DEFINITION_VARIABLE,
+			program.numVariables - 1);
+	math_undefine(&ctx, &program, DEFINITION_VARIABLE, 2);
+	math_define(&ctx, &program, "c = [0, 0, 0]", &definition, &address);
+	if (!math_bindprogram(&ctx, &program) ||
+			expect(&program, "d", (number_t[]) { 3, 4, 5 }, 3) < 0) {
+		printf("rebinding: %s\n", math_error(&ctx));
+		result = -1;
+	}
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
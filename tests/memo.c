@@ -0,0 +1,132 @@
+#include "../src/cake.h"
+
+static number_t call(MathContext *ctx, const MathFunction *func,
+		number_t a, number_t b)
+{
+	number_t value;
+
+	math_pushlocal(ctx, a);
+	if (func->numParameters == 2)
+		math_pushlocal(ctx, b);
+	value = math_computefunction(ctx, func);
+	ctx->numLocals = 0;
+	return value;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = 3",
+		/* the calls never end but the results are dropped by `and 0`,
+		 * without a memo there are 2^256 of them
+		 */
+		"f(t) = t + (f(t - 1) and f(t - 2) and 0)",
+		"g(t, u) = t * a + sin(u)",
+		"h(t) = g(t, t) + g(t, t)",
+		"y = f(x) + h(x)",
+	};
+	MathProgram program;
+	MathContext ctx;
+	MathBlock block;
+	enum math_definition definition;
+	size_t address;
+	const MathFunction *f, *g, *h;
+	const number_t xs[] = { 4 }, ys[] = { 0 };
+	const number_t *const parameters[] = { xs, ys };
+	number_t value, expected;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	f = &program.functions[0];
+	g = &program.functions[1];
+	h = &program.functions[2];
+	if (!f->pure || !g->pure || !h->pure || !f->recursive ||
+			g->recursive || h->recursive) {
+		printf("the functions were not analyzed correctly\n");
+		result = -1;
+	}
+
+	/* only recursive functions remember by default */
+	value = call(&ctx, f, 10, 0);
+	printf("f(10) = %Lg: %s, %zu hits, %zu misses\n", value,
+			math_error(&ctx), ctx.memoHits, ctx.memoMisses);
+	if (value != 10 || ctx.error != MATH_RECURSIVE ||
+			ctx.memoHits == 0 || ctx.memoMisses > 2 * MATH_MAX_DEPTH)
+		result = -1;
+	ctx.memoHits = 0;
+	math_seterror(&ctx, MATH_SUCCESS, 0);
+	value = call(&ctx, f, 10, 0);
+	if (value != 10 || ctx.memoHits != 1 || ctx.error != MATH_RECURSIVE)
+		result = -1;
+	call(&ctx, h, 2, 0);
+	if (ctx.memoHits != 1)
+		result = -1;
+
+	/* the same results with all pure functions remembered */
+	ctx.memoize = MEMOIZE_NONE;
+	expected = call(&ctx, h, 2, 0);
+	ctx.memoize = MEMOIZE_PURE;
+	ctx.memoHits = 0;
+	value = call(&ctx, h, 2, 0);
+	printf("h(2) = %Lg, remembered %Lg, %zu hits\n", expected, value,
+			ctx.memoHits);
+	if (value != expected || ctx.memoHits != 1)
+		result = -1;
+
+	/* arguments that differ beyond a double are not the same call */
+	ctx.memoHits = 0;
+	expected = call(&ctx, g, 1, 0);
+	value = call(&ctx, g, 1 + 0x1p-60L, 0);
+	printf("g(1, 0) = %La, g(1 + 2^-60, 0) = %La\n", expected, value);
+	if (ctx.memoHits != 0 || value == expected)
+		result = -1;
+
+	/* nothing is remembered of the earlier binding */
+	math_undefine(&ctx, &program, DEFINITION_VARIABLE, 0);
+	math_define(&ctx, &program, "a = 5", &definition, &address);
+	math_bindprogram(&ctx, &program);
+	ctx.memoize = MEMOIZE_NONE;
+	expected = call(&ctx, h, 2, 0);
+	ctx.memoize = MEMOIZE_PURE;
+	value = call(&ctx, h, 2, 0);
+	printf("after rebinding h(2) = %Lg, remembered %Lg\n", expected,
+			value);
+	if (value != expected || value == 2 * (2 * 3 + sinl(2)))
+		result = -1;
+
+	/* inlining the recursion into a block ends as well */
+	memset(&block, 0, sizeof(block));
+	if (!math_blockfunction(&ctx, &block, &program.functions[3]) ||
+			!math_computeblock(&ctx, &block, parameters, 1)) {
+		printf("the block failed: %s\n", math_error(&ctx));
+		result = -1;
+	} else {
+		expected = call(&ctx, &program.functions[3], xs[0], ys[0]);
+		value = math_blockresult(&block, 0)[0];
+		printf("%zu operations, %Lg, block %Lg\n",
+				block.numOperations, expected, value);
+		if (fabsl(value - expected) > 1e-15)
+			result = -1;
+	}
+	math_freeblock(&block);
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,138 @@
+#include "../src/cake.h"
+
+/* builds `open` repeated count times, the middle and `close` repeated */
+static char *repeat(const char *open, const char *middle, const char *close,
+		size_t count)
+{
+	const size_t lenOpen = strlen(open), lenClose = strlen(close);
+	char *text, *p;
+
+	text = malloc(count * (lenOpen + lenClose) + strlen(middle) + 1);
+	if (text == NULL)
+		return NULL;
+	p = text;
+	for (size_t i = 0; i < count; i++, p += lenOpen)
+		memcpy(p, open, lenOpen);
+	p = stpcpy(p, middle);
+	for (size_t i = 0; i < count; i++, p += lenClose)
+		memcpy(p, close, lenClose);
+	*p = '\0';
+	return text;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *text;
+		number_t value;
+	} values[] = {
+		{ "1 + 2 * 3", 7 },
+		{ "8 / 4 / 2", 1 },
+		{ "7 - 2 - 1", 4 },
+		{ "2 ^ 3 ^ 2", 512 },
+		{ "-2 ^ 2", -4 },
+		{ "2 ^ -1", 0.5 },
+		{ "-3 * -(2 + 1)", 9 },
+		{ "7 mod 3 + 1", 2 },
+		{ "-7 mod 3", 2 },
+		{ "1 + 2 = 3", 0 },
+		{ "1 and 0 or 1", 1 },
+		{ "1 xor 1", 0 },
+		{ "3! * 2", 12 },
+		{ "2 ^ 3!", 64 },
+		{ "-3!", -6 },
+		{ "50% * 4", 2 },
+		{ "cos(180°)", -1 },
+		{ "pow(2, 1 + 2) + root(3, 27)", 11 },
+		{ "((((1)) + (2)))", 3 },
+		{ "sqrt(sqrt(16)) * +2", 4 },
+	};
+	static const struct {
+		const char *text;
+		enum math_error error;
+	} errors[] = {
+		{ "", MATH_HANGING_OPERATOR },
+		{ "1 +", MATH_HANGING_OPERATOR },
+		{ "--1", MATH_DOUBLE_PLUS_MINUS },
+		{ "1 - +-1", MATH_DOUBLE_PLUS_MINUS },
+		{ "(1 + 2", MATH_UNBALANCED },
+		{ "1 + 2)", MATH_UNBALANCED },
+		{ "pow(1)", MATH_INVALID_CALL },
+		{ "sin 1", MATH_INVALID_CALL },
+		{ "f()", MATH_INVALID_CALL },
+		{ "1, 2", MATH_INVALID_CALL },
+		{ "1 2", MATH_INVALID_TOKEN },
+		{ "* 2", MATH_INVALID_TOKEN },
+		{ "!", MATH_INVALID_TOKEN },
+		{ "(1 = 2) + 3", MATH_INVALID_TOKEN },
+		{ "1 = 2 = 3", MATH_INVALID_TOKEN },
+		{ "sqrt(1 = 2)", MATH_INVALID_TOKEN },
+	};
+	static const struct {
+		const char *open, *middle, *close;
+		size_t count;
+		number_t value;
+	} deep[] = {
+		{ "(", "1", ")", 100000, 1 },
+		{ "1 + ", "1", "", 20000, 20001 },
+		{ "1 ^ ", "2", "", 20000, 1 },
+		{ "-(", "1", ")", 10000, 1 },
+		{ "floor(", "1.5", ")", 10000, 1 },
+	};
+	MathContext ctx;
+	MathGroup *group;
+	number_t value;
+	char *text;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	setlocale(LC_CTYPE, "C.UTF-8");
+	memset(&ctx, 0, sizeof(ctx));
+	for (size_t i = 0; i < ARRLEN(values); i++) {
+		group = math_parse(&ctx, values[i].text);
+		if (group == NULL) {
+			printf("'%s': %s\n", values[i].text, math_error(&ctx));
+			result = -1;
+			continue;
+		}
+		value = math_computegroup(&ctx, group);
+		printf("%s = %Lg\n", values[i].text, value);
+		if (fabsl(value - values[i].value) > 1e-15)
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+
+	for (size_t i = 0; i < ARRLEN(errors); i++) {
+		group = math_parse(&ctx, errors[i].text);
+		printf("'%s': %s\n", errors[i].text, math_error(&ctx));
+		if (group != NULL || ctx.error != errors[i].error)
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+
+	/* nesting is only limited by memory */
+	for (size_t i = 0; i < ARRLEN(deep); i++) {
+		text = repeat(deep[i].open, deep[i].middle, deep[i].close,
+				deep[i].count);
+		if (text == NULL)
+			return -1;
+		group = math_parse(&ctx, text);
+		free(text);
+		if (group == NULL) {
+			printf("%zu x '%s': %s\n", deep[i].count,
+					deep[i].open, math_error(&ctx));
+			result = -1;
+			continue;
+		}
+		value = math_computegroup(&ctx, group);
+		printf("%zu x '%s' = %Lg\n", deep[i].count, deep[i].open,
+				value);
+		if (value != deep[i].value)
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+	math_freecontext(&ctx);
+	return result;
+}
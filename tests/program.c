@@ -0,0 +1,106 @@
+#include "../src/cake.h"
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"y = f(x) + b",
+		"a = 2",
+		"f(t) = t * a + 1",
+		"b = f(3)",
+		"c = d",
+		"d = c + 1",
+		"g(t) = g(t)",
+	};
+	MathProgram program;
+	MathContext ctx, other;
+	enum math_definition definition;
+	size_t address;
+	number_t value;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (math_bindprogram(&ctx, &program)) {
+		printf("the cycle of c and d was not found\n");
+		result = -1;
+	} else {
+		printf("binding: %s\n", math_error(&ctx));
+	}
+	printf("%zu variables, %zu functions\n", program.numVariables,
+			program.numFunctions);
+	for (size_t i = 0; i < program.numVariables; i++)
+		printf("%s = %Lf\n", program.variables[i].name,
+				program.variables[i].value);
+	if (program.variables[1].value != 7 ||
+			!isnan(program.variables[2].value))
+		result = -1;
+
+	/* a second context shares the program, locals stay apart */
+	memset(&other, 0, sizeof(other));
+	other.program = &program;
+	math_pushlocal(&other, 1.5);
+	math_pushlocal(&other, 0);
+	value = math_computefunction(&other, &program.functions[0]);
+	/* equations compute as left - right */
+	printf("0 - (f(1.5) + b) = %Lf\n", value);
+	if (value != -11)
+		result = -1;
+
+	math_poplocal(&other);
+	value = math_computefunction(&other, &program.functions[2]);
+	printf("g(1.5) = %Lf: %s\n", value, math_error(&other));
+	if (!isnan(value) || other.error != MATH_RECURSIVE)
+		result = -1;
+
+	/* b reads a through f and is computed again, the cycle is not */
+	if (!math_setvariable(&ctx, &program, 0, 3)) {
+		printf("setting a failed: %s\n", math_error(&ctx));
+		result = -1;
+	}
+	math_pushlocal(&other, 0);
+	value = math_computefunction(&other, &program.functions[0]);
+	other.numLocals = 0;
+	printf("with a = 3: b = %Lf, 0 - (f(1.5) + b) = %Lf\n",
+			program.variables[1].value, value);
+	if (program.variables[1].value != 10 || value != -15.5)
+		result = -1;
+
+	/* f keeps its place, a line of another kind is not taken */
+	if (math_redefine(&ctx, &program, "f(t) = t * a + 2",
+				DEFINITION_FUNCTION, 1) != 1 ||
+			math_redefine(&ctx, &program, "f = 2",
+				DEFINITION_FUNCTION, 1) != 0 ||
+			math_redefine(&ctx, &program, "f(t) = (",
+				DEFINITION_FUNCTION, 1) != -1 ||
+			program.numFunctions != 3 ||
+			strcmp(program.functions[1].name, "f") != 0) {
+		printf("redefining f failed: %s\n", math_error(&ctx));
+		result = -1;
+	}
+	math_bindprogram(&ctx, &program);
+	printf("with f(t) = t * a + 2: b = %Lf\n",
+			program.variables[1].value);
+	if (program.variables[1].value != 8)
+		result = -1;
+
+	math_undefine(&ctx, &program, DEFINITION_VARIABLE, 0);
+	if (math_bindprogram(&ctx, &program) ||
+			ctx.error != MATH_UNDEFINED)
+		result = -1;
+	printf("without a: %s\n", math_error(&ctx));
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	math_freecontext(&other);
+	return result;
+}
@@ -0,0 +1,152 @@
+#include "../src/cake.h"
+
+static number_t variable(const MathProgram *program, const char *name)
+{
+	for (size_t i = 0; i < program->numVariables; i++)
+		if (strcmp(program->variables[i].name, name) == 0)
+			return program->variables[i].value;
+	return NAN;
+}
+
+static int expect(const char *name, number_t value, number_t expected,
+		number_t tolerance)
+{
+	printf("%s = %.*Lg, expected %.*Lg\n", name, LDBL_DIG, value,
+			LDBL_DIG, expected);
+	if (!(fabsl(value - expected) <= tolerance * MAX(fabsl(expected), 1)))
+		return -1;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = sum(k, 1, 100, k^2)",
+		"b = prod(k, 1, 10, k)",
+		"c = integral(t, 0, 1, 4 / (1 + t^2))",
+		"d = sum(k, 1, 0, k) + prod(k, 1, 0, 2)",
+		/* enough terms for threads */
+		"e = sum(k, 1, 200000, k)",
+		/* enough intervals for threads */
+		"g = integral(t, 0, 10, sin(100 * t))",
+		"f(s) = integral(t, 0, s, cos(s * t))",
+		"h(s) = sum(k, 1, 3, sum(j, 1, k, j * s))",
+		/* far wider than the body, and one that does not converge */
+		"m = integral(t, 0, 1e308, exp(-t))",
+		"n = integral(t, 0, 1, 1 / t)",
+		"y = f(x) + h(x)",
+	};
+	static const struct {
+		const char *text;
+		enum math_error error;
+	} invalid[] = {
+		{ "sum(k, 1, 10, k)", MATH_SUCCESS },
+		{ "sum(1, 1, 10, k)", MATH_INVALID_CALL },
+		{ "sum(k, 1, 10)", MATH_INVALID_CALL },
+		{ "integral + 1", MATH_INVALID_CALL },
+	};
+	static const number_t xs[] = { 0.5, 1, 2, 3 }, ys[] = { 0, 0, 0, 0 };
+	MathProgram program;
+	MathContext ctx;
+	MathBlock block;
+	MathGroup *group, *derivative;
+	enum math_definition definition;
+	size_t address;
+	const number_t *const parameters[] = { xs, ys };
+	number_t value, expected;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	for (size_t i = 0; i < ARRLEN(invalid); i++) {
+		memset(&ctx, 0, sizeof(ctx));
+		group = math_parse(&ctx, invalid[i].text);
+		printf("'%s': %s\n", invalid[i].text, math_error(&ctx));
+		if (ctx.error != invalid[i].error ||
+				(group == NULL) != (ctx.error != MATH_SUCCESS))
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (expect("a", variable(&program, "a"), 338350, 0) < 0 ||
+			expect("b", variable(&program, "b"), 3628800, 0) < 0 ||
+			expect("c", variable(&program, "c"), M_PI, 1e-13) < 0 ||
+			expect("d", variable(&program, "d"), 1, 0) < 0 ||
+			expect("e", variable(&program, "e"), 20000100000.0,
+				0) < 0 ||
+			expect("g", variable(&program, "g"),
+				(1 - cosl(1000)) / 100, 1e-12) < 0 ||
+			expect("m", variable(&program, "m"), 1, 1e-13) < 0)
+		result = -1;
+	if (!isnan(variable(&program, "n"))) {
+		printf("n = %Lg, expected nan\n", variable(&program, "n"));
+		result = -1;
+	}
+
+	/* the series see the parameters around them, the equation
+	 * computes as y - f(x) - h(x)
+	 */
+	for (size_t i = 0; i < ARRLEN(xs); i++) {
+		expected = -sinl(xs[i] * xs[i]) / xs[i] - 10 * xs[i];
+		math_pushlocal(&ctx, xs[i]);
+		math_pushlocal(&ctx, 0);
+		value = math_computefunction(&ctx, &program.functions[2]);
+		ctx.numLocals = 0;
+		if (expect("y", value, expected, 1e-13) < 0)
+			result = -1;
+	}
+
+	/* and so do the blocks, for every sample */
+	memset(&block, 0, sizeof(block));
+	if (!math_blockfunction(&ctx, &block, &program.functions[2]) ||
+			!math_computeblock(&ctx, &block, parameters,
+				ARRLEN(xs))) {
+		printf("the block failed: %s\n", math_error(&ctx));
+		result = -1;
+	} else {
+		for (size_t i = 0; i < ARRLEN(xs); i++) {
+			expected = -sinl(xs[i] * xs[i]) / xs[i] - 10 * xs[i];
+			value = math_blockresult(&block, 0)[i];
+			if (expect("block y", value, expected, 1e-13) < 0)
+				result = -1;
+		}
+	}
+	math_freeblock(&block);
+
+	/* d/ds integral(t, 0, s, cos(s * t)) = cos(s^2) +
+	 * integral(t, 0, s, -t * sin(s * t))
+	 */
+	derivative = math_derivegroup(&ctx, program.functions[0].group, 0);
+	if (derivative == NULL) {
+		printf("deriving failed: %s\n", math_error(&ctx));
+		result = -1;
+	} else {
+		math_pushlocal(&ctx, 2);
+		ctx.frame = 0;
+		value = math_computegroup(&ctx, derivative);
+		ctx.numLocals = 0;
+		expected = 2 * cosl(4) - sinl(4) / 4;
+		if (expect("f'(2)", value, expected, 1e-12) < 0)
+			result = -1;
+		math_freegroup(&ctx, derivative);
+	}
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
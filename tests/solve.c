@@ -0,0 +1,151 @@
+#include "../src/cake.h"
+
+static const MathList *find(const MathProgram *program, const char *name)
+{
+	for (size_t i = 0; i < program->numVariables; i++)
+		if (strcmp(program->variables[i].name, name) == 0)
+			return program->variables[i].list;
+	return NULL;
+}
+
+/* compares the roots with the expected ones to a few ulps */
+static int expect(const char *name, const MathList *list,
+		const number_t *values, size_t count)
+{
+	number_t value;
+
+	if (list == NULL || list->count != count) {
+		printf("%s: expected %zu roots, got %zu\n", name, count,
+				list == NULL ? 0 : list->count);
+		return -1;
+	}
+	for (size_t i = 0; i < count; i++) {
+		value = math_listelement(list, i);
+		printf("%s[%zu] = %.*Lg\n", name, i, LDBL_DIG, value);
+		if (!(fabsl(value - values[i]) <= 8 * LDBL_EPSILON *
+					MAX(fabsl(values[i]), 1))) {
+			printf("expected %.*Lg\n", LDBL_DIG, values[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = solve(t, -2, 2, t^2 - 2)",
+		"b = solve(t, 0, 10, sin(t))",
+		/* the pole changes the sign too */
+		"c = solve(t, 1, 2, tan(t))",
+		"d = solve(t, 0, 1, t - n)",
+		"n = 0.3",
+		"e = solve(t, 0, 100, sin(t)) * 2",
+		"f(s, u) = s^3 - u",
+		"y = solve(t, 0, 1, t)",
+	};
+	static const struct {
+		const char *text;
+		enum math_error error;
+	} invalid[] = {
+		{ "solve(t, 0, 1, t)", MATH_SUCCESS },
+		{ "solve(1, 0, 1, t)", MATH_INVALID_CALL },
+		{ "solve(t, 0, 1)", MATH_INVALID_CALL },
+		{ "solve", MATH_INVALID_CALL },
+	};
+	const number_t pi = acosl(-1);
+	const number_t as[] = { -sqrtl(2), sqrtl(2) };
+	const number_t bs[] = { 0, pi, 2 * pi, 3 * pi };
+	const number_t ds[] = { 0.3L };
+	const number_t cubes[] = { 2 };
+	const number_t arguments[] = { NAN, 8 };
+	MathProgram program;
+	MathContext ctx;
+	MathGroup *group;
+	MathList roots;
+	const MathList *list;
+	enum math_definition definition;
+	size_t address;
+	number_t value;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	for (size_t i = 0; i < ARRLEN(invalid); i++) {
+		memset(&ctx, 0, sizeof(ctx));
+		group = math_parse(&ctx, invalid[i].text);
+		printf("'%s': %s\n", invalid[i].text, math_error(&ctx));
+		if (ctx.error != invalid[i].error ||
+				(group == NULL) != (ctx.error != MATH_SUCCESS))
+			result = -1;
+		math_freegroup(&ctx, group);
+	}
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+	if (expect("a", find(&program, "a"), as, ARRLEN(as)) < 0 ||
+			expect("b", find(&program, "b"), bs, ARRLEN(bs)) < 0 ||
+			expect("c", find(&program, "c"), NULL, 0) < 0 ||
+			expect("d", find(&program, "d"), ds, ARRLEN(ds)) < 0)
+		result = -1;
+
+	/* every root of sin up to 100, doubled */
+	list = find(&program, "e");
+	if (list == NULL || list->count != 32 ||
+			fabsl(math_listelement(list, 31) - 62 * pi) >
+			1e-15) {
+		printf("e: wrong roots\n");
+		result = -1;
+	}
+
+	/* equations see lists as NaN */
+	math_pushlocal(&ctx, 1);
+	math_pushlocal(&ctx, 2);
+	value = math_computefunction(&ctx, &program.functions[1]);
+	ctx.numLocals = 0;
+	printf("y = solve(...) at (1, 2): %Lg\n", value);
+	if (!isnan(value))
+		result = -1;
+
+	/* the roots in one parameter of a function, on threads and in a
+	 * worker that starts none
+	 */
+	for (int nested = 0; nested < 2; nested++) {
+		ctx.nested = nested;
+		if (!math_solve(&ctx, &program.functions[0], 0, arguments,
+					-10, 10, &roots)) {
+			printf("solving failed: %s\n", math_error(&ctx));
+			result = -1;
+			continue;
+		}
+		if (expect("cube root", &roots, cubes, ARRLEN(cubes)) < 0)
+			result = -1;
+		math_freelist(&roots);
+	}
+	ctx.nested = false;
+
+	/* the range has to be finite */
+	if (math_solve(&ctx, &program.functions[0], 0, arguments, 0,
+				INFINITY, &roots) ||
+			ctx.error != MATH_INVALID_RANGE) {
+		printf("an infinite range is invalid\n");
+		result = -1;
+	}
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
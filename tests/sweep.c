@@ -0,0 +1,113 @@
+#include "../src/cake.h"
+
+/* sweeps into memory, NULL if the sweep failed */
+static char *sweep(MathContext *ctx, const MathFunction *const *functions,
+		size_t numFunctions, const MathAxis *axes, size_t numAxes,
+		enum math_sweep_format format, size_t *size)
+{
+	char *data;
+	FILE *fp;
+
+	fp = open_memstream(&data, size);
+	if (fp == NULL)
+		return NULL;
+	if (!math_sweep(ctx, functions, numFunctions, axes, numAxes, format,
+				fp, 2)) {
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	fclose(fp);
+	return data;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *lines[] = {
+		"a = 2",
+		"f(s) = s * a",
+		"g(s, t) = s + t * 10",
+	};
+	static const char expected[] =
+		"s,t,g\n"
+		"0,0,0\n"
+		"0,1,10\n"
+		"0,2,20\n"
+		"1,0,1\n"
+		"1,1,11\n"
+		"1,2,21\n";
+	static const MathAxis grid[] = { { 0, 1, 2 }, { 0, 2, 3 } };
+	/* more rows than a window of chunks */
+	static const MathAxis large[] = { { 0, 1, 100001 } };
+	MathProgram program;
+	MathContext ctx;
+	const MathFunction *functions[2];
+	enum math_definition definition;
+	size_t address, size;
+	char *data;
+	double columns[2][100001];
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	memset(&program, 0, sizeof(program));
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.program = &program;
+	for (size_t i = 0; i < ARRLEN(lines); i++)
+		if (!math_define(&ctx, &program, lines[i], &definition,
+					&address)) {
+			printf("defining '%s' failed: %s\n", lines[i],
+					math_error(&ctx));
+			return -1;
+		}
+	if (!math_bindprogram(&ctx, &program)) {
+		printf("binding failed: %s\n", math_error(&ctx));
+		return -1;
+	}
+
+	/* the last parameter changes fastest */
+	functions[0] = &program.functions[1];
+	data = sweep(&ctx, functions, 1, grid, ARRLEN(grid), SWEEP_CSV,
+			&size);
+	if (data == NULL || strcmp(data, expected) != 0) {
+		printf("csv:\n%s\nexpected:\n%s\n", data, expected);
+		result = -1;
+	}
+	free(data);
+
+	/* the columns one after the other */
+	functions[0] = &program.functions[0];
+	data = sweep(&ctx, functions, 1, large, ARRLEN(large), SWEEP_BINARY,
+			&size);
+	if (data == NULL || size != sizeof(columns)) {
+		printf("binary: %zu bytes, expected %zu\n", size,
+				sizeof(columns));
+		result = -1;
+	} else {
+		memcpy(columns, data, sizeof(columns));
+		for (size_t i = 0; i < ARRLEN(columns[0]); i++)
+			if (columns[0][i] != (double) (i / 100000.0L) ||
+					columns[1][i] !=
+					(double) (i / 50000.0L)) {
+				printf("row %zu: %g %g\n", i, columns[0][i],
+						columns[1][i]);
+				result = -1;
+				break;
+			}
+	}
+	free(data);
+
+	/* every function needs one axis for each parameter */
+	functions[1] = &program.functions[1];
+	data = sweep(&ctx, functions, 2, large, ARRLEN(large), SWEEP_CSV,
+			&size);
+	printf("mismatched axes: %s\n", math_error(&ctx));
+	if (data != NULL || ctx.error != MATH_INVALID_CALL)
+		result = -1;
+	free(data);
+
+	math_freeprogram(&ctx, &program);
+	math_freecontext(&ctx);
+	return result;
+}
@@ -0,0 +1,77 @@
+#include "../src/cake.h"
+
+int main(int argc, char *argv[])
+{
+	const size_t tileMemory = TILE_SIZE * TILE_SIZE * sizeof(Uint32);
+	const uint64_t functions[] = { 7 };
+	TileCache cache;
+	Tile *tile;
+	int result = 0;
+
+	(void) argc;
+	(void) argv;
+
+	if (tile_init(&cache, 4 * tileMemory) < 0)
+		return -1;
+	printf("room for %zu tiles in %zu buckets\n", cache.maxTiles,
+			cache.numBuckets);
+	for (Sint64 i = 0; i < 4; i++)
+		if (tile_insert(&cache, i == 3 ? 8 : 7, 10, i, -i) == NULL) {
+			printf("inserting failed\n");
+			return -1;
+		}
+	/* the zoom is part of the key */
+	if (tile_find(&cache, 7, 11, 0, 0) != NULL ||
+			tile_find(&cache, 7, 10, 0, 1) != NULL ||
+			tile_find(&cache, 7, 10, 0, 0) == NULL) {
+		printf("finding the tiles failed\n");
+		result = -1;
+	}
+
+	/* tile 1 was used least recently since 0 was found */
+	tile_insert(&cache, 7, 10, 4, -4);
+	if (cache.numTiles != 4 || tile_find(&cache, 7, 10, 1, -1) != NULL ||
+			tile_find(&cache, 7, 10, 0, 0) == NULL ||
+			tile_find(&cache, 7, 10, 4, -4) == NULL) {
+		printf("the least recently used tile was not replaced\n");
+		result = -1;
+	}
+	printf("%zu hits, %zu misses\n", cache.hits, cache.misses);
+
+	/* function 8 changed */
+	tile_retain(&cache, functions, ARRLEN(functions));
+	if (cache.numTiles != 3 || tile_find(&cache, 8, 10, 3, -3) != NULL) {
+		printf("the changed function kept its tiles\n");
+		result = -1;
+	}
+	for (tile = cache.newest; tile != NULL; tile = tile->older)
+		printf("tile %lld, %lld of %llu\n", (long long) tile->x,
+				(long long) tile->y,
+				(unsigned long long) tile->function);
+
+	/* a view of 4 tiles fits, one of 100 does not and the cache stays
+	 * within its memory
+	 */
+	if (tile_reserve(&cache, 4) < 0 || tile_reserve(&cache, 100) == 0) {
+		printf("the reservations do not match the memory\n");
+		result = -1;
+	}
+	if (cache.maxTiles != 4 || cache.numTiles > 4) {
+		printf("%zu of %zu tiles after reserving 100\n",
+				cache.numTiles, cache.maxTiles);
+		result = -1;
+	}
+	tile_uninit(&cache);
+
+	/* nor does a 3840x2160 view of 20 equations grow the default one */
+	if (tile_init(&cache, TILE_MEMORY) < 0)
+		return -1;
+	if (tile_reserve(&cache, 31 * 18 * 20) == 0 ||
+			cache.maxTiles != TILE_MEMORY / tileMemory) {
+		printf("the view grew the cache to %zu tiles\n",
+				cache.maxTiles);
+		result = -1;
+	}
+	tile_uninit(&cache);
+	return result;
+}